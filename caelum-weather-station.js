@@ -1,12 +1,62 @@
+import {Zcl} from 'zigbee-herdsman';
 import * as m from 'zigbee-herdsman-converters/lib/modernExtend';
 
+// On-device report policy (0x01VP on caelumConfig: V = value, P = parameter), see main/report_policy.h
+const policyValues = [
+    {key: 'temperature', label: 'Temperature', unit: '0.01 °C'},
+    {key: 'humidity', label: 'Humidity', unit: '0.01 %'},
+    {key: 'pressure', label: 'Pressure', unit: '0.1 kPa'},
+    {key: 'batteryVoltage', label: 'Battery voltage', unit: '0.1 V'},
+    {key: 'batteryPercent', label: 'Battery percentage', unit: '0.5 %'},
+    {key: 'probeTemperature', label: 'DS18B20 temperature', unit: '0.01 °C'},
+];
+const policyParams = [
+    {key: 'Deadband', name: 'deadband', description: 'smallest change that is reported'},
+    {key: 'Hysteresis', name: 'hysteresis', description: 'extra change needed when the direction reverses'},
+    {key: 'MinInterval', name: 'min_interval', description: 'minimum seconds between two reports', unit: 's'},
+    {key: 'MaxInterval', name: 'max_interval', description: 'heartbeat: report after this many seconds anyway (0 = never)', unit: 's'},
+];
+const policyAttributes = [];
+policyValues.forEach((value, v) => policyParams.forEach((param, p) => policyAttributes.push({
+    attribute: `policy${value.key[0].toUpperCase()}${value.key.slice(1)}${param.key}`,
+    name: `policy_${value.key.replace(/[A-Z]/g, (c) => `_${c.toLowerCase()}`)}_${param.name}`,
+    id: 0x0100 | (v << 4) | p,
+    description: `${value.label} report policy: ${param.description}`,
+    unit: param.unit ?? value.unit,
+})));
+
 export default {
     zigbeeModel: ['caelum'],
     model: 'caelum',
     vendor: 'ESPRESSIF',
     description: 'Caelum - Battery-powered Zigbee weather station with rain gauge',
     extend: [
-        m.deviceEndpoints({endpoints: {"1":1,"2":2,"3":3,"4":4}}),
+        m.deviceEndpoints({endpoints: {"1":1,"2":2,"3":3,"4":4,"5":5,"6":6,"7":7}}),
+        m.deviceAddCustomCluster('caelumConfig', {
+            ID: 0xfc00,
+            attributes: {
+                measurementProfile: {ID: 0x0000, type: Zcl.DataType.ENUM8},
+                profileEnergy: {ID: 0x0001, type: Zcl.DataType.UINT16},
+                sensorErrors: {ID: 0x0010, type: Zcl.DataType.UINT32},
+                sensorRetries: {ID: 0x0011, type: Zcl.DataType.UINT32},
+                busRecoveries: {ID: 0x0012, type: Zcl.DataType.UINT16},
+                incompleteCycles: {ID: 0x0013, type: Zcl.DataType.UINT16},
+                sensorDiag: {ID: 0x0014, type: Zcl.DataType.CHAR_STR},
+                ...Object.fromEntries(policyAttributes.map((a) => [a.attribute, {ID: a.id, type: Zcl.DataType.UINT16}])),
+            },
+            commands: {},
+            commandsResponse: {},
+        }),
+        m.deviceAddCustomCluster('caelumRainRate', {
+            ID: 0xfc01,
+            attributes: {
+                rainRate: {ID: 0x0000, type: Zcl.DataType.UINT16},
+                rainRate10min: {ID: 0x0001, type: Zcl.DataType.UINT16},
+                rainRate1h: {ID: 0x0002, type: Zcl.DataType.UINT16},
+            },
+            commands: {},
+            commandsResponse: {},
+        }),
         m.temperature(
             {
                 endpointNames: ["1"],
@@ -29,6 +79,98 @@ export default {
             }
         ),
         m.battery(),
+        m.bindCluster({cluster: 'genPollCtrl', clusterType: 'input', endpointNames: ['1']}),
+        m.enumLookup(
+            {
+                name: "measurement_profile",
+                cluster: "caelumConfig",
+                attribute: "measurementProfile",
+                lookup: {"eco": 0, "balanced": 1, "precise": 2, "standard": 3},
+                description: "Sensor oversampling/filter profile (noise vs battery life)",
+                endpointName: "1",
+                entityCategory: "config",
+            }
+        ),
+        m.numeric(
+            {
+                name: "profile_energy",
+                cluster: "caelumConfig",
+                attribute: "profileEnergy",
+                description: "Estimated sensor energy per sample of the selected profile",
+                unit: "µJ",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        m.numeric(
+            {
+                name: "sensor_errors",
+                cluster: "caelumConfig",
+                attribute: "sensorErrors",
+                description: "Sensor bus, CRC and timeout errors since boot",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        m.numeric(
+            {
+                name: "sensor_retries",
+                cluster: "caelumConfig",
+                attribute: "sensorRetries",
+                description: "Extra sensor conversions spent on retries since boot",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        m.numeric(
+            {
+                name: "bus_recoveries",
+                cluster: "caelumConfig",
+                attribute: "busRecoveries",
+                description: "I2C bus recoveries since boot",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        m.numeric(
+            {
+                name: "incomplete_cycles",
+                cluster: "caelumConfig",
+                attribute: "incompleteCycles",
+                description: "Measurement cycles that ended with a failed sensor",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        m.text(
+            {
+                name: "sensor_diag",
+                cluster: "caelumConfig",
+                attribute: "sensorDiag",
+                description: "Per-sensor successful reads (ok), errors (e) and retries (r)",
+                access: "STATE_GET",
+                endpointNames: ["1"],
+                entityCategory: "diagnostic",
+            }
+        ),
+        ...policyAttributes.map((a) => m.numeric(
+            {
+                name: a.name,
+                cluster: "caelumConfig",
+                attribute: a.attribute,
+                description: a.description,
+                unit: a.unit,
+                valueMin: 0,
+                valueMax: 65535,
+                endpointNames: ["1"],
+                entityCategory: "config",
+            }
+        )),
         m.numeric(
             {
                 endpointNames: ["2"],
@@ -45,6 +187,49 @@ export default {
                 exposesName: "Rain amount"
             }
         ),
+        m.numeric(
+            {
+                endpointNames: ["2"],
+                name: "rain_rate",
+                cluster: "caelumRainRate",
+                attribute: "rainRate",
+                reporting: {min: 0, max: 3600, change: 1},
+                description: "Instantaneous rain rate (from the latest bucket tips)",
+                unit: "mm/h",
+                scale: 10,
+                precision: 1,
+                access: "STATE_GET",
+                icon: "mdi:weather-pouring",
+            }
+        ),
+        m.numeric(
+            {
+                endpointNames: ["2"],
+                name: "rain_rate_10min",
+                cluster: "caelumRainRate",
+                attribute: "rainRate10min",
+                reporting: {min: 0, max: 3600, change: 1},
+                description: "Rain rate over the last 10 minutes",
+                unit: "mm/h",
+                scale: 10,
+                precision: 1,
+                access: "STATE_GET",
+            }
+        ),
+        m.numeric(
+            {
+                endpointNames: ["2"],
+                name: "rain_rate_1h",
+                cluster: "caelumRainRate",
+                attribute: "rainRate1h",
+                reporting: {min: 0, max: 3600, change: 1},
+                description: "Rain over the last hour",
+                unit: "mm/h",
+                scale: 10,
+                precision: 1,
+                access: "STATE_GET",
+            }
+        ),
         m.numeric(
             {
                 endpointNames: ["3"],
@@ -58,9 +243,23 @@ export default {
                 exposesName: "Pulse Count"
             }
         ),
+        m.numeric(
+            {
+                endpointNames: ["2", "3"],
+                name: "summation",
+                cluster: "seMetering",
+                attribute: "currentSummDelivered",
+                reporting: {min: 0, max: 3600, change: 10000},
+                description: "Exact counter total (rain in mm, pulses in units)",
+                scale: 1000000,
+                precision: 2,
+                access: "STATE_GET",
+                entityCategory: "diagnostic",
+            }
+        ),
         m.temperature(
             {
-                endpointNames: ["4"],
+                endpointNames: ["4", "5", "6", "7"],
                 unit: "°C",
                 access: "STATE_GET",
                 precision: 1,
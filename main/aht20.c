@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -11,14 +12,39 @@ static const char *TAG = "AHT20";
 // Default I2C address for AHT20
 #define AHT20_I2C_ADDR 0x38
 
+// Conversion time: first busy-bit check after 75ms, datasheet guarantees completion by 80ms
+#define AHT20_MEASURE_TYP_US 75000
+#define AHT20_MEASURE_MAX_US 80000
+
+// Status byte: bit 7 set while a measurement is in progress
+#define AHT20_STATUS_BUSY (1 << 7)
+
 static i2c_bus_device_handle_t s_dev = NULL;
+static float s_last_temperature = 0.0f;
+static float s_last_humidity = 0.0f;
+static bool s_have_data = false;
+
+// Split-phase state: time the pending conversion was started
+static bool s_pending = false;
+static int64_t s_start_us = 0;
 
 // Measurement command for AHT20
 static const uint8_t AHT20_CMD_MEASURE[3] = { 0xAC, 0x33, 0x00 };
 
+void aht20_deinit(void)
+{
+    if (s_dev) {
+        i2c_bus_device_delete(&s_dev);
+        s_dev = NULL;
+    }
+    s_pending = false;
+    s_have_data = false;
+}
+
 esp_err_t aht20_init(i2c_bus_handle_t i2c_bus)
 {
     if (!i2c_bus) return ESP_ERR_INVALID_ARG;
+    aht20_deinit();
 
     // create device handle with default clock
     i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, AHT20_I2C_ADDR, 0);
@@ -43,39 +69,64 @@ esp_err_t aht20_init(i2c_bus_handle_t i2c_bus)
     return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t aht20_trigger_measurement(void)
+uint8_t aht20_get_address(void)
+{
+    return s_dev ? AHT20_I2C_ADDR : 0;
+}
+
+esp_err_t aht20_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us)
 {
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
 
     esp_err_t ret = i2c_bus_write_bytes(s_dev, NULL_I2C_MEM_ADDR, sizeof(AHT20_CMD_MEASURE), AHT20_CMD_MEASURE);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "aht20_trigger_measurement: write failed (%d)", ret);
+        ESP_LOGW(TAG, "aht20_start_measurement: write failed (%d)", ret);
+        s_pending = false;
         return ret;
     }
 
-    // Wait typical conversion time (datasheet ~75ms). Use 80ms to be safe.
-    vTaskDelay(pdMS_TO_TICKS(80));
+    s_start_us = esp_timer_get_time();
+    s_pending = true;
+    if (out_min_us) *out_min_us = AHT20_MEASURE_TYP_US;
+    if (out_max_us) *out_max_us = AHT20_MEASURE_MAX_US;
     return ESP_OK;
 }
 
+bool aht20_is_measurement_ready(void)
+{
+    if (!s_pending) return false;
+    int64_t elapsed = esp_timer_get_time() - s_start_us;
+    if (elapsed < AHT20_MEASURE_TYP_US) return false;
+    if (elapsed >= AHT20_MEASURE_MAX_US) return true;
+
+    // Between typical and max: poll the busy bit (single status byte read)
+    uint8_t status = 0;
+    if (i2c_bus_read_bytes(s_dev, NULL_I2C_MEM_ADDR, 1, &status) != ESP_OK) return false;
+    return (status & AHT20_STATUS_BUSY) == 0;
+}
+
 static esp_err_t aht20_read_raw(uint8_t buf[6])
 {
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
     return i2c_bus_read_bytes(s_dev, NULL_I2C_MEM_ADDR, 6, buf);
 }
 
-esp_err_t aht20_read_temperature(float *out_c)
+esp_err_t aht20_collect(void)
 {
-    if (!out_c) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
-
-    // Trigger measurement then read
-    esp_err_t ret = aht20_trigger_measurement();
-    if (ret != ESP_OK) return ret;
+    if (!s_pending) return ESP_ERR_INVALID_STATE;
+    s_pending = false;
 
     uint8_t raw[6];
-    ret = aht20_read_raw(raw);
-    if (ret != ESP_OK) return ret;
+    esp_err_t ret = aht20_read_raw(raw);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "aht20_collect: read failed (%d)", ret);
+        return ret;
+    }
+    if (raw[0] & AHT20_STATUS_BUSY) {
+        ESP_LOGW(TAG, "aht20_collect: still busy after %d us", AHT20_MEASURE_MAX_US);
+        return ESP_ERR_TIMEOUT;
+    }
 
     // Parse raw: status, h[20], t[20]
     // humidity_raw = (raw[1]<<12) | (raw[2]<<4) | (raw[3] >> 4)
@@ -84,11 +135,19 @@ esp_err_t aht20_read_temperature(float *out_c)
     uint32_t temp_raw = (((uint32_t)raw[3] & 0x0F) << 16) | ((uint32_t)raw[4] << 8) | (uint32_t)raw[5];
 
     // convert to physical values per datasheet
-    float humidity = ((float)hum_raw) * 100.0f / 1048576.0f; // 2^20 = 1048576
-    float temperature = ((float)temp_raw) * 200.0f / 1048576.0f - 50.0f;
+    s_last_humidity = ((float)hum_raw) * 100.0f / 1048576.0f; // 2^20 = 1048576
+    s_last_temperature = ((float)temp_raw) * 200.0f / 1048576.0f - 50.0f;
+    s_have_data = true;
+    return ESP_OK;
+}
+
+esp_err_t aht20_read_temperature(float *out_c)
+{
+    if (!out_c) return ESP_ERR_INVALID_ARG;
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
-    (void)humidity; // humidity function will return a separate value
-    *out_c = temperature;
+    *out_c = s_last_temperature;
     return ESP_OK;
 }
 
@@ -96,16 +155,8 @@ esp_err_t aht20_read_humidity(float *out_percent)
 {
     if (!out_percent) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
-    esp_err_t ret = aht20_trigger_measurement();
-    if (ret != ESP_OK) return ret;
-
-    uint8_t raw[6];
-    ret = aht20_read_raw(raw);
-    if (ret != ESP_OK) return ret;
-
-    uint32_t hum_raw = ((uint32_t)raw[1] << 12) | ((uint32_t)raw[2] << 4) | ((uint32_t)raw[3] >> 4);
-    float humidity = ((float)hum_raw) * 100.0f / 1048576.0f;
-    *out_percent = humidity;
+    *out_percent = s_last_humidity;
     return ESP_OK;
 }
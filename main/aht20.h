@@ -2,15 +2,30 @@
 
 #include "i2c_bus.h"
 #include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 // Initialize AHT20 on the provided I2C bus
 esp_err_t aht20_init(i2c_bus_handle_t i2c_bus);
 
-// Trigger a measurement (if required). Many AHT20 chips start measurement on read; this is provided for completeness.
-esp_err_t aht20_trigger_measurement(void);
+// Release the device handle (before the I2C bus is deleted)
+void aht20_deinit(void);
 
-// Read temperature in degrees Celsius
+// I2C address of the attached AHT20 (0 if none)
+uint8_t aht20_get_address(void);
+
+// Start a measurement without waiting; the optional outputs receive the
+// earliest ready check and the maximum conversion time
+esp_err_t aht20_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us);
+
+// True once the pending conversion has finished (busy bit cleared or max time elapsed)
+bool aht20_is_measurement_ready(void);
+
+// Fetch and cache the result of the pending conversion
+esp_err_t aht20_collect(void);
+
+// Read temperature in degrees Celsius (last collected value)
 esp_err_t aht20_read_temperature(float *out_c);
 
-// Read relative humidity in percent (0-100)
+// Read relative humidity in percent (0-100) (last collected value)
 esp_err_t aht20_read_humidity(float *out_percent);
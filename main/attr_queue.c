@@ -0,0 +1,182 @@
+/*
+ * Attribute Queue
+ *
+ * Design:
+ * - Bounded ring with a sequence number per slot: a producer claims a slot with one
+ *   compare-and-swap on the head, copies the update in and publishes it by storing
+ *   the slot sequence; a full ring drops the update instead of waiting
+ * - One consumer (the Zigbee task) reads slots in order and hands them back by
+ *   advancing their sequence one lap, so no lock is shared with the producers
+ * - A drain collects the ring into a report batch (which coalesces per attribute
+ *   and groups per cluster) and applies it in Zigbee context without the Zigbee lock
+ * - Flush only try-locks (zero timeout) to schedule the drain alarm; when the lock
+ *   is busy the Zigbee task is running and drains on its next CAN_SLEEP anyway
+ * - A producer that must know its updates are written (loaded battery sample after the
+ *   report burst) waits on the applied position instead: the drain publishes it and
+ *   gives a semaphore, the waiter compares it with the head it saw after pushing
+ */
+
+#include "attr_queue.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "ATTR_QUEUE";
+
+_Static_assert((ATTR_QUEUE_SLOTS & (ATTR_QUEUE_SLOTS - 1)) == 0, "ATTR_QUEUE_SLOTS must be a power of two");
+
+typedef struct {
+    atomic_uint seq;                    // == position: free for that producer; position + 1: holds an update
+    report_batch_entry_t update;
+} attr_queue_slot_t;
+
+static attr_queue_slot_t s_slots[ATTR_QUEUE_SLOTS];
+static atomic_uint s_head;              // Next position to claim (producers)
+static unsigned s_tail;                 // Next position to read (consumer only)
+static atomic_bool s_drain_scheduled;
+static atomic_uint s_dropped;
+static atomic_uint s_applied;           // Positions before this one are written (consumer publishes)
+static SemaphoreHandle_t s_drained;     // Given after every drain that applied updates
+static report_batch_t s_drain_batch;    // Consumer only
+
+static void attr_queue_drain_cb(uint8_t param);
+
+void attr_queue_init(void)
+{
+    for (unsigned i = 0; i < ATTR_QUEUE_SLOTS; i++) {
+        atomic_init(&s_slots[i].seq, i);
+    }
+    atomic_init(&s_head, 0);
+    s_tail = 0;
+    atomic_init(&s_drain_scheduled, false);
+    atomic_init(&s_dropped, 0);
+    atomic_init(&s_applied, 0);
+    if (s_drained == NULL) {
+        s_drained = xSemaphoreCreateBinary();
+    }
+    report_batch_reset(&s_drain_batch);
+}
+
+esp_err_t attr_queue_push(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, const void *value, size_t len)
+{
+    ESP_RETURN_ON_FALSE(value, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(len <= REPORT_BATCH_VALUE_MAX, ESP_ERR_INVALID_SIZE, TAG,
+                        "EP%u 0x%04x/0x%04x: value too large (%u bytes)", endpoint, cluster_id, attr_id, (unsigned)len);
+
+    attr_queue_slot_t *slot;
+    unsigned pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+    for (;;) {
+        slot = &s_slots[pos & (ATTR_QUEUE_SLOTS - 1)];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* The consumer has not freed this slot yet: ring full */
+            unsigned dropped = atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed) + 1;
+            ESP_LOGW(TAG, "Ring full - EP%u 0x%04x/0x%04x dropped (%u since boot)", endpoint, cluster_id, attr_id, dropped);
+            return ESP_ERR_NO_MEM;
+        } else {
+            pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+        }
+    }
+
+    slot->update.endpoint = endpoint;
+    slot->update.cluster_id = cluster_id;
+    slot->update.attr_id = attr_id;
+    slot->update.len = (uint8_t)len;
+    memcpy(slot->update.value, value, len);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return ESP_OK;
+}
+
+void attr_queue_flush(void)
+{
+    if (atomic_exchange(&s_drain_scheduled, true)) {
+        return;                         // A drain is already on its way
+    }
+    if (esp_zb_lock_acquire(0)) {
+        esp_zb_scheduler_alarm((esp_zb_callback_t)attr_queue_drain_cb, 0, 0);
+        esp_zb_lock_release();
+    } else {
+        /* Zigbee task busy: its next CAN_SLEEP drains */
+        atomic_store(&s_drain_scheduled, false);
+    }
+}
+
+esp_err_t attr_queue_flush_wait(uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(s_drained, ESP_ERR_INVALID_STATE, TAG, "attr_queue_init() not called");
+    unsigned target = atomic_load(&s_head);
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    /* Unlike attr_queue_flush(), wait for the lock: the caller wants the drain now */
+    if (!atomic_exchange(&s_drain_scheduled, true)) {
+        if (!esp_zb_lock_acquire(timeout)) {
+            atomic_store(&s_drain_scheduled, false);
+            return ESP_ERR_TIMEOUT;
+        }
+        esp_zb_scheduler_alarm((esp_zb_callback_t)attr_queue_drain_cb, 0, 0);
+        esp_zb_lock_release();
+    }
+    while ((int)(atomic_load_explicit(&s_applied, memory_order_acquire) - target) < 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || xSemaphoreTake(s_drained, timeout - elapsed) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+static void attr_queue_drain_cb(uint8_t param)
+{
+    (void)param;  // Unused
+    attr_queue_drain();
+}
+
+size_t attr_queue_drain(void)
+{
+    /* Cleared first: a push after this point schedules the next drain */
+    atomic_store(&s_drain_scheduled, false);
+
+    size_t taken = 0;
+    for (;;) {
+        attr_queue_slot_t *slot = &s_slots[s_tail & (ATTR_QUEUE_SLOTS - 1)];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if ((int)(seq - (s_tail + 1)) < 0) {
+            break;                      // Empty (or the next slot is still being written)
+        }
+        const report_batch_entry_t *u = &slot->update;
+        if (s_drain_batch.count == REPORT_BATCH_MAX_ENTRIES) {
+            /* More attributes than a batch holds: write this part, go on */
+            report_batch_apply(&s_drain_batch, NULL);
+        }
+        report_batch_add(&s_drain_batch, u->endpoint, u->cluster_id, u->attr_id, u->value, u->len);
+        atomic_store_explicit(&slot->seq, s_tail + ATTR_QUEUE_SLOTS, memory_order_release);
+        s_tail++;
+        taken++;
+    }
+    if (taken > 0) {
+        report_batch_apply(&s_drain_batch, NULL);
+        atomic_store_explicit(&s_applied, s_tail, memory_order_release);
+        if (s_drained) {
+            xSemaphoreGive(s_drained);
+        }
+        ESP_LOGD(TAG, "Drained %u update(s)", (unsigned)taken);
+    }
+    return taken;
+}
+
+uint32_t attr_queue_dropped(void)
+{
+    return atomic_load_explicit(&s_dropped, memory_order_relaxed);
+}
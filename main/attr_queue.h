@@ -0,0 +1,76 @@
+/*
+ * Attribute Queue
+ * Lock-free multi-producer / single-consumer ring of attribute updates; producer
+ * tasks never wait for the Zigbee lock, the Zigbee task applies the updates in one pass
+ */
+
+#ifndef ATTR_QUEUE_H
+#define ATTR_QUEUE_H
+
+#include "esp_err.h"
+#include "report_batch.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ring slots (power of two) */
+#ifndef ATTR_QUEUE_SLOTS
+#define ATTR_QUEUE_SLOTS 32
+#endif
+
+/**
+ * @brief Reset the ring (before the Zigbee task starts)
+ */
+void attr_queue_init(void);
+
+/**
+ * @brief Queue a server attribute value (copied); never blocks, any task
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the value is too large, ESP_ERR_NO_MEM if the ring is full (update dropped)
+ */
+esp_err_t attr_queue_push(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, const void *value, size_t len);
+
+/**
+ * @brief Ask the Zigbee task to drain the ring; never blocks, any task
+ *
+ * Schedules the drain alarm if the Zigbee lock is free right now; otherwise the
+ * Zigbee task is busy and drains on its next CAN_SLEEP (attr_queue_drain()).
+ */
+void attr_queue_flush(void);
+
+/**
+ * @brief Ask the Zigbee task to drain the ring and wait until every update queued so far is written
+ *
+ * Blocks (never call it from the Zigbee task): waits for the Zigbee lock to schedule
+ * the drain, then for the drain itself. Once it returns ESP_OK the attributes are set
+ * and their reports are handed to the stack.
+ *
+ * @param timeout_ms Upper bound for the whole wait
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the updates were not written in time (they still will be)
+ */
+esp_err_t attr_queue_flush_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Apply every queued update (Zigbee task context only)
+ *
+ * Updates of the same endpoint/cluster/attribute (the coalescing key) collapse to
+ * the last value; the rest is written grouped by endpoint and cluster, so each
+ * cluster still goes out as one frame.
+ *
+ * @return Number of updates taken from the ring
+ */
+size_t attr_queue_drain(void);
+
+/**
+ * @brief Updates dropped because the ring was full (since boot)
+ */
+uint32_t attr_queue_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATTR_QUEUE_H
@@ -0,0 +1,183 @@
+/*
+ * Battery Measurement
+ *
+ * Design:
+ * - ADC1 oneshot unit and adc_cali scheme (curve fitting where supported) are created
+ *   per measurement and deleted right after, so nothing stays powered between readings
+ * - BATTERY_ADC_SAMPLES calibrated samples, min/max trimmed: a single ADC spike cannot
+ *   move the Zigbee value by a reportable step
+ * - Loaded mode spreads the samples over a short window after a TX burst was queued and
+ *   keeps the lowest quarter, i.e. the voltage while the radio is drawing current
+ * - Const Li-ion discharge table (25 °C, light load), linear interpolation between points,
+ *   voltage shifted up for cold cells before the lookup
+ */
+
+#include "battery.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include <math.h>
+#include <stdlib.h>
+
+static const char *TAG = "BATTERY";
+
+#define BATTERY_ADC_CHANNEL ADC_CHANNEL_4   // GPIO4 on ESP32-H2
+#define BATTERY_ADC_UNIT    ADC_UNIT_1      // ADC1 on ESP32-H2
+#define BATTERY_ADC_ATTEN   ADC_ATTEN_DB_12 // 0-3.1V range (ESP32-H2: actually 0-2.5V)
+
+_Static_assert(BATTERY_ADC_SAMPLES >= 4, "trimmed mean and lowest quarter need at least 4 samples");
+
+/* Li-ion open-circuit discharge curve, descending voltage */
+typedef struct {
+    uint16_t mv;
+    uint8_t pct;
+} battery_curve_point_t;
+
+static const battery_curve_point_t s_curve[] = {
+    { 4200, 100 },
+    { 4100, 92 },
+    { 4000, 82 },
+    { 3920, 72 },
+    { 3850, 61 },
+    { 3800, 51 },
+    { 3760, 41 },
+    { 3720, 30 },
+    { 3680, 20 },
+    { 3620, 11 },
+    { 3500, 5 },
+    { 3300, 1 },
+    { 3000, 0 },
+};
+
+static adc_oneshot_unit_handle_t s_adc;
+static adc_cali_handle_t s_cali;
+
+static esp_err_t battery_adc_open(void)
+{
+    adc_oneshot_unit_init_cfg_t init_config = {
+        .unit_id = BATTERY_ADC_UNIT,
+        .ulp_mode = ADC_ULP_MODE_DISABLE,
+    };
+    ESP_RETURN_ON_ERROR(adc_oneshot_new_unit(&init_config, &s_adc), TAG, "ADC unit init failed");
+
+    adc_oneshot_chan_cfg_t chan_config = {
+        .atten = BATTERY_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    esp_err_t ret = adc_oneshot_config_channel(s_adc, BATTERY_ADC_CHANNEL, &chan_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure ADC channel: %s", esp_err_to_name(ret));
+        adc_oneshot_del_unit(s_adc);
+        s_adc = NULL;
+        return ret;
+    }
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id = BATTERY_ADC_UNIT,
+        .chan = BATTERY_ADC_CHANNEL,
+        .atten = BATTERY_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_cali_create_scheme_curve_fitting(&cali_config, &s_cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = BATTERY_ADC_UNIT,
+        .atten = BATTERY_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_cali_create_scheme_line_fitting(&cali_config, &s_cali);
+#else
+    ret = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ADC calibration unavailable, using nominal scale: %s", esp_err_to_name(ret));
+        s_cali = NULL;
+    }
+    return ESP_OK;
+}
+
+static void battery_adc_close(void)
+{
+    if (s_cali != NULL) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(s_cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(s_cali);
+#endif
+        s_cali = NULL;
+    }
+    if (s_adc != NULL) {
+        adc_oneshot_del_unit(s_adc);
+        s_adc = NULL;
+    }
+}
+
+static esp_err_t battery_sample_mv(int *out_mv)
+{
+    int raw;
+    ESP_RETURN_ON_ERROR(adc_oneshot_read(s_adc, BATTERY_ADC_CHANNEL, &raw), TAG, "ADC read failed");
+    if (s_cali == NULL || adc_cali_raw_to_voltage(s_cali, raw, out_mv) != ESP_OK) {
+        *out_mv = (raw * 2500) / 4095;
+    }
+    return ESP_OK;
+}
+
+static int battery_cmp_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+esp_err_t battery_measure(battery_measure_mode_t mode, float *out_voltage)
+{
+    if (!out_voltage) return ESP_ERR_INVALID_ARG;
+    ESP_RETURN_ON_ERROR(battery_adc_open(), TAG, "ADC not available");
+
+    int mv[BATTERY_ADC_SAMPLES];
+    uint32_t spacing_us = mode == BATTERY_MEASURE_LOADED ? BATTERY_LOAD_WINDOW_MS * 1000 / BATTERY_ADC_SAMPLES : 0;
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < BATTERY_ADC_SAMPLES && ret == ESP_OK; i++) {
+        ret = battery_sample_mv(&mv[i]);
+        if (spacing_us) esp_rom_delay_us(spacing_us);
+    }
+    battery_adc_close();
+    if (ret != ESP_OK) return ret;
+
+    qsort(mv, BATTERY_ADC_SAMPLES, sizeof(mv[0]), battery_cmp_int);
+    int first = 1, n = BATTERY_ADC_SAMPLES - 2;             // Trim min and max
+    if (mode == BATTERY_MEASURE_LOADED) {
+        first = 0;
+        n = BATTERY_ADC_SAMPLES / 4;                        // Lowest quarter: PA on
+    }
+    int sum = 0;
+    for (int i = first; i < first + n; i++) sum += mv[i];
+    float adc_v = (float)sum / (float)n / 1000.0f;
+
+    *out_voltage = adc_v * BATTERY_DIVIDER_RATIO * BATTERY_CAL_SCALE;
+    ESP_LOGI(TAG, "📊 ADC %d..%d mV, %s mean %.3fV → Battery: %.3fV", mv[0], mv[BATTERY_ADC_SAMPLES - 1],
+             mode == BATTERY_MEASURE_LOADED ? "loaded" : "trimmed", adc_v, *out_voltage);
+    return ESP_OK;
+}
+
+float battery_soc_percent(float voltage, float temperature_c)
+{
+    if (!isnan(temperature_c) && temperature_c < BATTERY_TEMP_REF_C) {
+        float t = fmaxf(temperature_c, BATTERY_TEMP_MIN_C);
+        voltage += (BATTERY_TEMP_REF_C - t) * BATTERY_TEMP_COEFF_V_PER_C;
+    }
+
+    const size_t n = sizeof(s_curve) / sizeof(s_curve[0]);
+    float mv = voltage * 1000.0f;
+    if (mv >= s_curve[0].mv) return (float)s_curve[0].pct;
+    for (size_t i = 1; i < n; i++) {
+        if (mv >= s_curve[i].mv) {
+            const battery_curve_point_t *hi = &s_curve[i - 1], *lo = &s_curve[i];
+            float f = (mv - lo->mv) / (float)(hi->mv - lo->mv);
+            return lo->pct + f * (float)(hi->pct - lo->pct);
+        }
+    }
+    return (float)s_curve[n - 1].pct;
+}
@@ -0,0 +1,85 @@
+/*
+ * Battery Measurement
+ * Averaged, calibrated cell voltage from the ADC divider and a Li-ion
+ * state-of-charge estimate from a discharge-curve lookup table
+ */
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ADC samples per measurement; min and max are dropped before averaging */
+#ifndef BATTERY_ADC_SAMPLES
+#define BATTERY_ADC_SAMPLES 16
+#endif
+
+/* Hardware divider: R1 from the cell to GPIO4, R2 from GPIO4 to GND */
+#ifndef BATTERY_DIVIDER_R1_KOHM
+#define BATTERY_DIVIDER_R1_KOHM 100
+#endif
+#ifndef BATTERY_DIVIDER_R2_KOHM
+#define BATTERY_DIVIDER_R2_KOHM 100
+#endif
+#define BATTERY_DIVIDER_RATIO ((float)(BATTERY_DIVIDER_R1_KOHM + BATTERY_DIVIDER_R2_KOHM) / BATTERY_DIVIDER_R2_KOHM)
+
+/* Board trim on top of adc_cali and the divider, 1.0 = none. To set it, read the cell
+ * with a multimeter and divide by the voltage this module logs at the same moment. */
+#ifndef BATTERY_CAL_SCALE
+#define BATTERY_CAL_SCALE 1.0f
+#endif
+
+/* Window over which BATTERY_MEASURE_LOADED spreads its samples */
+#ifndef BATTERY_LOAD_WINDOW_MS
+#define BATTERY_LOAD_WINDOW_MS 30
+#endif
+
+/* Cold-cell compensation: below the reference temperature the loaded voltage sags by
+ * about this much per °C for the same charge (clamped at BATTERY_TEMP_MIN_C) */
+#ifndef BATTERY_TEMP_REF_C
+#define BATTERY_TEMP_REF_C 20.0f
+#endif
+#ifndef BATTERY_TEMP_COEFF_V_PER_C
+#define BATTERY_TEMP_COEFF_V_PER_C 0.001f
+#endif
+#ifndef BATTERY_TEMP_MIN_C
+#define BATTERY_TEMP_MIN_C -20.0f
+#endif
+
+typedef enum {
+    BATTERY_MEASURE_IDLE,   /*!< Samples back-to-back, trimmed mean */
+    BATTERY_MEASURE_LOADED, /*!< Samples spread over BATTERY_LOAD_WINDOW_MS, mean of the lowest quarter */
+} battery_measure_mode_t;
+
+/**
+ * @brief Measure the cell voltage
+ *
+ * Claims ADC1 and its calibration scheme for the duration of the call and releases
+ * both afterwards so the ADC can power down between hourly readings.
+ * BATTERY_MEASURE_LOADED is meant to be called right after the radio has been given
+ * frames to send: the lowest samples are the ones taken while the PA draws current.
+ *
+ * @param mode        Sampling mode
+ * @param out_voltage Cell voltage in V
+ * @return ESP_OK, or the ADC error (no fallback value is substituted)
+ */
+esp_err_t battery_measure(battery_measure_mode_t mode, float *out_voltage);
+
+/**
+ * @brief Li-ion state of charge from the cell voltage
+ * @param voltage       Cell voltage in V
+ * @param temperature_c Cell temperature (onboard sensor), NAN if unknown
+ * @return 0-100 %
+ */
+float battery_soc_percent(float voltage, float temperature_c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATTERY_H */
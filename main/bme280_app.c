@@ -1,23 +1,146 @@
 #include "bme280_app.h"
+#include "bmx280_comp.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include "i2c_bus.h"
+#include <string.h>
 
-/* Access to bme280_dev_t structure for chip ID reading */
-typedef struct {
-    i2c_bus_device_handle_t i2c_dev;
-    uint8_t dev_addr;
-    /* ... rest of structure not needed here */
-} bme280_dev_internal_t;
+/* In-tree BME280 backend on top of i2c_bus (a BMP280 is served by bmp280.c).
+ * One measurement = one ctrl_meas write + one 8-byte burst read of 0xF7-0xFE;
+ * all three channels are compensated from that frame with a single t_fine. */
 
 static const char *TAG = "BME280_APP";
-bme280_handle_t g_bme280 = NULL;
-static bool is_bmp280 = false;  // Track if sensor is BMP280 (no humidity)
 
-bool bme280_app_is_bmp280(void)
+/* Possible I2C addresses (SDO low / high) */
+#define BME280_ADDR_0 0x76
+#define BME280_ADDR_1 0x77
+
+/* Registers */
+#define BME280_REG_CALIB00   0x88    /* 0x88-0xA1: T1..P9, 0xA0 reserved, 0xA1 H1 */
+#define BME280_REG_CHIP_ID   0xD0
+#define BME280_REG_CALIB26   0xE1    /* 0xE1-0xE7: H2..H6 */
+#define BME280_REG_CTRL_HUM  0xF2
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_CONFIG    0xF5
+#define BME280_REG_DATA      0xF7    /* press[3] temp[3] hum[2] */
+
+#define BME280_CHIP_ID 0x60
+
+#define BME280_CALIB00_LEN 26
+#define BME280_CALIB26_LEN (BME280_CALIB_LEN - BME280_CALIB00_LEN)
+
+/* ctrl_meas mode field */
+#define BME280_MODE_SLEEP         0
+#define BME280_MODE_FORCED        1
+
+static i2c_bus_device_handle_t s_dev = NULL;
+static uint8_t s_addr = 0;
+static uint8_t s_chip_id = 0;   // Chip ID read at init/attach (0 if none)
+
+/* Oversampling used for forced measurements (ctrl_hum latches on the next ctrl_meas write) */
+static uint8_t s_osrs_t = BMX280_OSRS_X1;
+static uint8_t s_osrs_p = BMX280_OSRS_X1;
+static uint8_t s_osrs_h = BMX280_OSRS_X1;
+/* IIR filter coefficient (standby time is unused in forced mode) */
+static uint8_t s_filter = BMX280_FILTER_OFF;
+
+/* Calibration values */
+static uint8_t s_calib_raw[BME280_CALIB_LEN];
+static bmx280_calib_t s_cal;
+
+static float s_last_temperature = 0.0f;
+static float s_last_humidity = 0.0f;
+static float s_last_pressure = 0.0f;
+static bool s_have_data = false;
+
+/* Split-phase state: time the pending conversion was started and its datasheet window */
+static bool s_pending = false;
+static int64_t s_start_us = 0;
+static uint32_t s_typ_us = 0;
+static uint32_t s_max_us = 0;
+
+uint8_t bme280_app_get_chip_id(void)
+{
+    return s_chip_id;
+}
+
+uint8_t bme280_app_get_address(void)
+{
+    return s_addr;
+}
+
+esp_err_t bme280_app_get_calibration(uint8_t *out, size_t len)
+{
+    if (!out || len < BME280_CALIB_LEN) return ESP_ERR_INVALID_ARG;
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    memcpy(out, s_calib_raw, BME280_CALIB_LEN);
+    return ESP_OK;
+}
+
+/* Decode the raw block: calib[0..25] = 0x88-0xA1, calib[26..32] = 0xE1-0xE7 */
+static void bme280_parse_calibration(const uint8_t *calib)
 {
-    return is_bmp280;
+    bmx280_comp_parse_calib(&s_cal, calib, true);
+    memcpy(s_calib_raw, calib, BME280_CALIB_LEN);
+}
+
+static esp_err_t bme280_read_calibration(i2c_bus_device_handle_t dev)
+{
+    uint8_t calib[BME280_CALIB_LEN] = { 0 };
+    esp_err_t ret = i2c_bus_read_bytes(dev, BME280_REG_CALIB00, BME280_CALIB00_LEN, calib);
+    if (ret != ESP_OK) return ret;
+    ret = i2c_bus_read_bytes(dev, BME280_REG_CALIB26, BME280_CALIB26_LEN, &calib[BME280_CALIB00_LEN]);
+    if (ret != ESP_OK) return ret;
+
+    bme280_parse_calibration(calib);
+    return ESP_OK;
+}
+
+/* Program oversampling/filter once; every measurement then only writes ctrl_meas */
+static uint8_t bme280_ctrl_meas(uint8_t mode)
+{
+    return (uint8_t)((s_osrs_t << 5) | (s_osrs_p << 2) | mode);
+}
+
+static esp_err_t bme280_configure(i2c_bus_device_handle_t dev)
+{
+    esp_err_t ret = i2c_bus_write_byte(dev, BME280_REG_CTRL_HUM, s_osrs_h);
+    if (ret == ESP_OK) {
+        ret = i2c_bus_write_byte(dev, BME280_REG_CONFIG, BMX280_CONFIG(s_filter));
+    }
+    if (ret == ESP_OK) {
+        ret = i2c_bus_write_byte(dev, BME280_REG_CTRL_MEAS, bme280_ctrl_meas(BME280_MODE_SLEEP));
+    }
+    return ret;
+}
+
+static void bme280_release(void)
+{
+    if (s_dev) {
+        i2c_bus_device_delete(&s_dev);
+        s_dev = NULL;
+    }
+    s_addr = 0;
+    s_chip_id = 0;
+    s_pending = false;
+    s_have_data = false;
+}
+
+/* Create a device at addr and read its chip ID; returns NULL unless a BME280 answers
+ * (a BMP280 at the other address must not hide a BME280) */
+static i2c_bus_device_handle_t bme280_open(i2c_bus_handle_t i2c_bus, uint8_t addr, uint8_t *chip_id)
+{
+    i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, addr, 0);
+    if (dev == NULL) return NULL;
+
+    *chip_id = 0;
+    if (i2c_bus_read_byte(dev, BME280_REG_CHIP_ID, chip_id) != ESP_OK || *chip_id != BME280_CHIP_ID) {
+        i2c_bus_device_delete(&dev);
+        return NULL;
+    }
+    return dev;
 }
 
 esp_err_t bme280_app_init(i2c_bus_handle_t i2c_bus)
@@ -26,105 +149,197 @@ esp_err_t bme280_app_init(i2c_bus_handle_t i2c_bus)
         ESP_LOGE(TAG, "i2c_bus handle is NULL");
         return ESP_ERR_INVALID_ARG;
     }
-    g_bme280 = bme280_create(i2c_bus, BME280_I2C_ADDRESS_DEFAULT);
-    if (!g_bme280) {
-        ESP_LOGE(TAG, "Failed to create BME280 handle");
-        return ESP_FAIL;
-    }
-    
-    /* Read and verify chip ID to detect BME280 vs BMP280 */
+    bme280_release();
+
     uint8_t chip_id = 0;
-    bme280_dev_internal_t *dev = (bme280_dev_internal_t *)g_bme280;
-    esp_err_t err = i2c_bus_read_byte(dev->i2c_dev, BME280_REGISTER_CHIPID, &chip_id);
+    uint8_t addr = BME280_ADDR_0;
+    i2c_bus_device_handle_t dev = bme280_open(i2c_bus, addr, &chip_id);
+    if (dev == NULL) {
+        addr = BME280_ADDR_1;
+        dev = bme280_open(i2c_bus, addr, &chip_id);
+    }
+    if (dev == NULL) {
+        ESP_LOGW(TAG, "No BME280 at 0x%02X or 0x%02X", BME280_ADDR_0, BME280_ADDR_1);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "✓ Detected BME280 sensor (Chip ID: 0x%02X) - Temperature + Humidity + Pressure", chip_id);
+
+    esp_err_t err = bme280_read_calibration(dev);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read chip ID");
+        ESP_LOGE(TAG, "BME280 calibration read failed");
+        i2c_bus_device_delete(&dev);
         return err;
     }
-    
-    if (chip_id == 0x60) {
-        ESP_LOGI(TAG, "✓ Detected BME280 sensor (Chip ID: 0x%02X) - Temperature + Humidity + Pressure", chip_id);
-        is_bmp280 = false;
-    } else if (chip_id == 0x58) {
-        ESP_LOGW(TAG, "⚠ Detected BMP280 sensor (Chip ID: 0x%02X) - Temperature + Pressure ONLY (no humidity!)", chip_id);
-        is_bmp280 = true;
-    } else {
-        ESP_LOGW(TAG, "⚠ Unknown sensor (Chip ID: 0x%02X) - Expected BME280 (0x60) or BMP280 (0x58)", chip_id);
-        is_bmp280 = false;
-    }
-    
-    /* Configure BME280 for forced mode (sleep between measurements)
-     * This minimizes power consumption - sensor sleeps until we trigger a measurement */
-    err = bme280_set_sampling(g_bme280, 
-                                       BME280_MODE_FORCED,           // Forced mode - sleep after each reading
-                                       BME280_SAMPLING_X1,           // Temperature oversampling x1 (fast, low power)
-                                       BME280_SAMPLING_X1,           // Pressure oversampling x1
-                                       BME280_SAMPLING_X1,           // Humidity oversampling x1
-                                       BME280_FILTER_OFF,            // No filtering needed for infrequent reads
-                                       BME280_STANDBY_MS_0_5);       // Standby (not used in forced mode)
+
+    /* Forced mode: sensor sleeps until we trigger a measurement */
+    err = bme280_configure(dev);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "BME280 forced mode config failed");
+        i2c_bus_device_delete(&dev);
         return err;
     }
-    
-    /* Read calibration coefficients */
-    err = bme280_read_coefficients(g_bme280);
+
+    s_dev = dev;
+    s_addr = addr;
+    s_chip_id = chip_id;
+    ESP_LOGI(TAG, "💤 BME280 initialized in FORCED mode at 0x%02X (sleeps between measurements)", addr);
+    return ESP_OK;
+}
+
+esp_err_t bme280_app_attach(i2c_bus_handle_t i2c_bus, uint8_t addr, uint8_t expected_chip_id, const uint8_t *calib)
+{
+    if (!i2c_bus || !calib || expected_chip_id == 0) return ESP_ERR_INVALID_ARG;
+    bme280_release();
+
+    /* Single chip-ID read confirms the cached device is still there */
+    uint8_t chip_id = 0;
+    i2c_bus_device_handle_t dev = bme280_open(i2c_bus, addr, &chip_id);
+    if (dev == NULL || chip_id != expected_chip_id) {
+        ESP_LOGW(TAG, "Chip ID 0x%02X at 0x%02X does not match cached 0x%02X", chip_id, addr, expected_chip_id);
+        if (dev) i2c_bus_device_delete(&dev);
+        return ESP_ERR_NOT_FOUND;
+    }
+    bme280_parse_calibration(calib);
+
+    /* Oversampling registers are lost on power loss, so always reprogram them */
+    esp_err_t err = bme280_configure(dev);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "BME280 calibration read failed");
+        i2c_bus_device_delete(&dev);
         return err;
     }
-    
-    vTaskDelay(pdMS_TO_TICKS(100)); // Brief settle time
-    ESP_LOGI(TAG, "💤 BME280 initialized in FORCED mode (sleeps between measurements)");
+
+    s_dev = dev;
+    s_addr = addr;
+    s_chip_id = chip_id;
     return ESP_OK;
 }
 
+esp_err_t bme280_app_set_config(uint8_t osrs_t, uint8_t osrs_p, uint8_t osrs_h, uint8_t filter)
+{
+    if (osrs_t == BMX280_OSRS_SKIP || osrs_t > BMX280_OSRS_X16 ||
+        osrs_p == BMX280_OSRS_SKIP || osrs_p > BMX280_OSRS_X16 ||
+        osrs_h > BMX280_OSRS_X16 || filter > BMX280_FILTER_X16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_osrs_t = osrs_t;
+    s_osrs_p = osrs_p;
+    s_osrs_h = osrs_h;
+    s_filter = filter;
+
+    /* Not attached yet: the settings are programmed by init/attach */
+    if (!s_dev) return ESP_OK;
+    esp_err_t err = bme280_configure(s_dev);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to apply oversampling/filter config: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void bme280_app_deinit(void)
+{
+    bme280_release();
+}
+
 esp_err_t bme280_app_sleep(void)
 {
-    if (!g_bme280) {
+    if (!s_dev) {
         return ESP_ERR_INVALID_STATE;
     }
-    
+
     /* In forced mode, BME280 automatically returns to sleep after measurement.
      * This function is a no-op but kept for API consistency. */
     ESP_LOGD(TAG, "💤 BME280 in sleep mode (automatic in forced mode)");
     return ESP_OK;
 }
 
-esp_err_t bme280_app_wake_and_measure(void)
+esp_err_t bme280_app_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us)
 {
-    if (!g_bme280) {
-        ESP_LOGE(TAG, "BME280 handle is NULL");
+    if (!s_dev) {
+        ESP_LOGE(TAG, "BME280 not initialized");
         return ESP_ERR_INVALID_STATE;
     }
-    
-    /* Trigger a forced measurement - sensor will wake, measure, then return to sleep */
-    esp_err_t err = bme280_take_forced_measurement(g_bme280);
+
+    esp_err_t err = i2c_bus_write_byte(s_dev, BME280_REG_CTRL_MEAS, bme280_ctrl_meas(BME280_MODE_FORCED));
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to trigger forced measurement");
+        s_pending = false;
         return err;
     }
-    
-    /* Wait for measurement to complete (~10ms for 1x oversampling) */
-    vTaskDelay(pdMS_TO_TICKS(15));
-    
-    ESP_LOGD(TAG, "⚡ BME280 forced measurement complete");
+
+    s_start_us = esp_timer_get_time();
+    s_typ_us = bmx280_conversion_time_us(s_osrs_t, s_osrs_p, s_osrs_h, false);
+    s_max_us = bmx280_conversion_time_us(s_osrs_t, s_osrs_p, s_osrs_h, true);
+    s_pending = true;
+    if (out_min_us) *out_min_us = s_typ_us;
+    if (out_max_us) *out_max_us = s_max_us;
+    return ESP_OK;
+}
+
+bool bme280_app_is_measurement_ready(void)
+{
+    if (!s_pending) return false;
+    int64_t elapsed = esp_timer_get_time() - s_start_us;
+    if (elapsed < s_typ_us) return false;
+    if (elapsed >= s_max_us) return true;
+
+    /* Between typical and max: ask the chip (status.measuring) */
+    uint8_t status = 0;
+    if (i2c_bus_read_byte(s_dev, BMX280_REG_STATUS, &status) != ESP_OK) return false;
+    return (status & BMX280_STATUS_MEASURING) == 0;
+}
+
+esp_err_t bme280_app_collect(void)
+{
+    if (!s_dev) return ESP_ERR_INVALID_STATE;
+    if (!s_pending) return ESP_ERR_INVALID_STATE;
+    s_pending = false;
+
+    /* One burst for all channels */
+    uint8_t data[8];
+    esp_err_t err = i2c_bus_read_bytes(s_dev, BME280_REG_DATA, sizeof(data), data);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to read measurement result: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int32_t adc_P = (int32_t)((((uint32_t)data[0]) << 12) | (((uint32_t)data[1]) << 4) | ((uint32_t)data[2] >> 4));
+    int32_t adc_T = (int32_t)((((uint32_t)data[3]) << 12) | (((uint32_t)data[4]) << 4) | ((uint32_t)data[5] >> 4));
+    int32_t adc_H = (int32_t)((((uint32_t)data[6]) << 8) | (uint32_t)data[7]);
+
+    /* t_fine is computed once and shared by P and H */
+    bmx280_comp_t comp;
+    err = bmx280_compensate(&s_cal, adc_T, adc_P, adc_H, &comp);
+    if (err != ESP_OK) return err;
+
+    s_last_temperature = (float)comp.temperature_centi / 100.0f;
+    s_last_pressure = (float)comp.pressure_q8 / 25600.0f; // Q24.8 Pa to hPa
+    s_last_humidity = (float)comp.humidity_q10 / 1024.0f;
+    s_have_data = true;
+
+    ESP_LOGD(TAG, "⚡ BME280 forced measurement collected");
     return ESP_OK;
 }
 
 esp_err_t bme280_app_read_temperature(float *temperature)
 {
-    if (!g_bme280 || !temperature) return ESP_ERR_INVALID_ARG;
-    return bme280_read_temperature(g_bme280, temperature);
+    if (!s_dev || !temperature) return ESP_ERR_INVALID_ARG;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
+    *temperature = s_last_temperature;
+    return ESP_OK;
 }
 
 esp_err_t bme280_app_read_humidity(float *humidity)
 {
-    if (!g_bme280 || !humidity) return ESP_ERR_INVALID_ARG;
-    return bme280_read_humidity(g_bme280, humidity);
+    if (!s_dev || !humidity) return ESP_ERR_INVALID_ARG;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
+    *humidity = s_last_humidity;
+    return ESP_OK;
 }
 
 esp_err_t bme280_app_read_pressure(float *pressure)
 {
-    if (!g_bme280 || !pressure) return ESP_ERR_INVALID_ARG;
-    return bme280_read_pressure(g_bme280, pressure);
+    if (!s_dev || !pressure) return ESP_ERR_INVALID_ARG;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
+    *pressure = s_last_pressure;
+    return ESP_OK;
 }
@@ -1,34 +1,60 @@
 #pragma once
-#include "bme280.h"
 #include "i2c_bus.h"
 #include "esp_err.h"
+#include "bmx280_comp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Handle for BME280 sensor
-extern bme280_handle_t g_bme280;
+// Size of the raw calibration block: 0x88-0xA1 (26 bytes) + 0xE1-0xE7 (7 bytes)
+#define BME280_CALIB_LEN BMX280_CALIB_LEN
 
-// Initialize BME280 sensor (returns ESP_OK or error)
+// Initialize the BME280 at 0x76 or 0x77 (chip ID 0x60 only; ESP_ERR_NOT_FOUND otherwise)
 esp_err_t bme280_app_init(i2c_bus_handle_t i2c_bus);
 
-// Check if detected sensor is BMP280 (no humidity support)
-bool bme280_app_is_bmp280(void);
+// Attach to a previously detected sensor using cached raw calibration; fails unless the chip ID matches
+esp_err_t bme280_app_attach(i2c_bus_handle_t i2c_bus, uint8_t addr, uint8_t expected_chip_id, const uint8_t *calib);
+
+// Release the device handle (e.g. when the chip is served by another driver)
+void bme280_app_deinit(void);
+
+// Chip ID read at init/attach (0x60, 0 if none)
+uint8_t bme280_app_get_chip_id(void);
+
+// I2C address of the attached sensor (0 if none)
+uint8_t bme280_app_get_address(void);
+
+// Copy the raw calibration block (BME280_CALIB_LEN bytes) of the attached sensor
+esp_err_t bme280_app_get_calibration(uint8_t *out, size_t len);
+
+// Set oversampling (BMX280_OSRS_*) and IIR filter (BMX280_FILTER_*) for the following
+// forced measurements; written to the chip at once if attached, otherwise at init/attach
+esp_err_t bme280_app_set_config(uint8_t osrs_t, uint8_t osrs_p, uint8_t osrs_h, uint8_t filter);
 
 // Put BME280 into sleep mode (low power)
 esp_err_t bme280_app_sleep(void);
 
-// Wake BME280 and take a forced measurement
-esp_err_t bme280_app_wake_and_measure(void);
+// Start a forced measurement without waiting; the optional outputs receive the
+// datasheet typical (earliest ready check) and maximum conversion time
+esp_err_t bme280_app_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us);
+
+// True once the pending conversion has finished (status.measuring cleared or max time elapsed)
+bool bme280_app_is_measurement_ready(void);
+
+// Fetch and cache the result of the pending conversion
+esp_err_t bme280_app_collect(void);
 
-// Read temperature (Celsius)
+// Read temperature (Celsius) from the last collected measurement
 esp_err_t bme280_app_read_temperature(float *temperature);
 
-// Read humidity (%)
+// Read humidity (%) from the last collected measurement
 esp_err_t bme280_app_read_humidity(float *humidity);
 
-// Read pressure (hPa)
+// Read pressure (hPa) from the last collected measurement
 esp_err_t bme280_app_read_pressure(float *pressure);
 
 #ifdef __cplusplus
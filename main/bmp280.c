@@ -1,10 +1,12 @@
 #include "bmp280.h"
+#include "bmx280_comp.h"
 #include "i2c_bus.h"
 #include "esp_log.h"
 #include "esp_err.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -23,47 +25,70 @@ static const char *TAG = "BMP280";
 #define BMP280_REG_DATA       0xF7
 
 static i2c_bus_device_handle_t s_dev = NULL;
+static uint8_t s_addr = 0;
 
 /* Calibration values */
-static uint16_t dig_T1;
-static int16_t  dig_T2;
-static int16_t  dig_T3;
-static uint16_t dig_P1;
-static int16_t  dig_P2;
-static int16_t  dig_P3;
-static int16_t  dig_P4;
-static int16_t  dig_P5;
-static int16_t  dig_P6;
-static int16_t  dig_P7;
-static int16_t  dig_P8;
-static int16_t  dig_P9;
-
-static int32_t t_fine = 0;
+static bmx280_calib_t s_cal;
+
+// Oversampling used for forced measurements
+static uint8_t s_osrs_t = BMX280_OSRS_X1;
+static uint8_t s_osrs_p = BMX280_OSRS_X1;
+static uint8_t s_filter = BMX280_FILTER_OFF;
+
+static float s_last_temperature = 0.0f;
+static float s_last_pressure = 0.0f;
+static bool s_have_data = false;
+
+// Split-phase state: time the pending conversion was started and its datasheet window
+static bool s_pending = false;
+static int64_t s_start_us = 0;
+static uint32_t s_typ_us = 0;
+static uint32_t s_max_us = 0;
+
+static uint8_t s_calib_raw[BMP280_CALIB_LEN];
+
+static void bmp280_parse_calibration(const uint8_t *calib)
+{
+    bmx280_comp_parse_calib(&s_cal, calib, false);
+    memcpy(s_calib_raw, calib, BMP280_CALIB_LEN);
+}
 
 static esp_err_t bmp280_read_calibration(i2c_bus_device_handle_t dev)
 {
-    uint8_t calib[24];
+    uint8_t calib[BMP280_CALIB_LEN];
     esp_err_t ret = i2c_bus_read_bytes(dev, BMP280_REG_CALIB00, sizeof(calib), calib);
     if (ret != ESP_OK) return ret;
 
-    dig_T1 = (uint16_t)((calib[1] << 8) | calib[0]);
-    dig_T2 = (int16_t)((calib[3] << 8) | calib[2]);
-    dig_T3 = (int16_t)((calib[5] << 8) | calib[4]);
-    dig_P1 = (uint16_t)((calib[7] << 8) | calib[6]);
-    dig_P2 = (int16_t)((calib[9] << 8) | calib[8]);
-    dig_P3 = (int16_t)((calib[11] << 8) | calib[10]);
-    dig_P4 = (int16_t)((calib[13] << 8) | calib[12]);
-    dig_P5 = (int16_t)((calib[15] << 8) | calib[14]);
-    dig_P6 = (int16_t)((calib[17] << 8) | calib[16]);
-    dig_P7 = (int16_t)((calib[19] << 8) | calib[18]);
-    dig_P8 = (int16_t)((calib[21] << 8) | calib[20]);
-    dig_P9 = (int16_t)((calib[23] << 8) | calib[22]);
+    bmp280_parse_calibration(calib);
     return ESP_OK;
 }
 
+// IIR filter lives in the config register; ctrl_meas is written on every trigger
+static esp_err_t bmp280_configure(i2c_bus_device_handle_t dev)
+{
+    return i2c_bus_write_byte(dev, BMP280_REG_CONFIG, BMX280_CONFIG(s_filter));
+}
+
+static void bmp280_release(void)
+{
+    if (s_dev) {
+        i2c_bus_device_delete(&s_dev);
+        s_dev = NULL;
+    }
+    s_addr = 0;
+    s_pending = false;
+    s_have_data = false;
+}
+
+void bmp280_deinit(void)
+{
+    bmp280_release();
+}
+
 esp_err_t bmp280_init(i2c_bus_handle_t i2c_bus)
 {
     if (!i2c_bus) return ESP_ERR_INVALID_ARG;
+    bmp280_release();
 
     i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, BMP280_ADDR_0, 0);
     uint8_t id = 0;
@@ -71,8 +96,9 @@ esp_err_t bmp280_init(i2c_bus_handle_t i2c_bus)
     if (dev) {
         if (i2c_bus_read_bytes(dev, BMP280_REG_ID, 1, &id) == ESP_OK && id == 0x58) {
             ESP_LOGI(TAG, "bmp280_init: found BMP280 at 0x%02x", BMP280_ADDR_0);
-            if (bmp280_read_calibration(dev) == ESP_OK) {
+            if (bmp280_read_calibration(dev) == ESP_OK && bmp280_configure(dev) == ESP_OK) {
                 s_dev = dev;
+                s_addr = BMP280_ADDR_0;
                 return ESP_OK;
             }
         }
@@ -84,8 +110,9 @@ esp_err_t bmp280_init(i2c_bus_handle_t i2c_bus)
     if (dev) {
         if (i2c_bus_read_bytes(dev, BMP280_REG_ID, 1, &id) == ESP_OK && id == 0x58) {
             ESP_LOGI(TAG, "bmp280_init: found BMP280 at 0x%02x", BMP280_ADDR_1);
-            if (bmp280_read_calibration(dev) == ESP_OK) {
+            if (bmp280_read_calibration(dev) == ESP_OK && bmp280_configure(dev) == ESP_OK) {
                 s_dev = dev;
+                s_addr = BMP280_ADDR_1;
                 return ESP_OK;
             }
         }
@@ -96,121 +123,153 @@ esp_err_t bmp280_init(i2c_bus_handle_t i2c_bus)
     return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t bmp280_trigger_measurement(void)
+esp_err_t bmp280_attach(i2c_bus_handle_t i2c_bus, uint8_t addr, const uint8_t *calib)
 {
-    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
-    // set oversampling x1 for temp and pressure, and forced mode (0x25)
-    uint8_t ctrl = (1 << 5) | (1 << 2) | 1; // osrs_t=1, osrs_p=1, mode=1 (forced)
-    return i2c_bus_write_bytes(s_dev, BMP280_REG_CTRL_MEAS, 1, &ctrl);
+    if (!i2c_bus || !calib) return ESP_ERR_INVALID_ARG;
+    if (addr != BMP280_ADDR_0 && addr != BMP280_ADDR_1) return ESP_ERR_INVALID_ARG;
+    bmp280_release();
+
+    i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, addr, 0);
+    if (dev == NULL) return ESP_ERR_NOT_FOUND;
+
+    // Single chip-ID read confirms the cached device is still there
+    uint8_t id = 0;
+    if (i2c_bus_read_bytes(dev, BMP280_REG_ID, 1, &id) != ESP_OK || id != 0x58) {
+        ESP_LOGW(TAG, "bmp280_attach: no BMP280 at 0x%02x (id=0x%02x)", addr, id);
+        i2c_bus_device_delete(&dev);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Config register is lost on power loss, so always reprogram it
+    if (bmp280_configure(dev) != ESP_OK) {
+        i2c_bus_device_delete(&dev);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    bmp280_parse_calibration(calib);
+    s_dev = dev;
+    s_addr = addr;
+    return ESP_OK;
 }
 
-// Read raw ADC values without triggering (assumes measurement already done)
-static esp_err_t bmp280_read_raw_only(int32_t *adc_T, int32_t *adc_P)
+uint8_t bmp280_get_address(void)
 {
-    if (!adc_T || !adc_P) return ESP_ERR_INVALID_ARG;
+    return s_addr;
+}
+
+esp_err_t bmp280_get_calibration(uint8_t *out, size_t len)
+{
+    if (!out || len < BMP280_CALIB_LEN) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    memcpy(out, s_calib_raw, BMP280_CALIB_LEN);
+    return ESP_OK;
+}
 
-    uint8_t data[6];
-    esp_err_t ret = i2c_bus_read_bytes(s_dev, BMP280_REG_DATA, 6, data);
-    if (ret != ESP_OK) return ret;
+esp_err_t bmp280_set_config(uint8_t osrs_t, uint8_t osrs_p, uint8_t filter)
+{
+    if (osrs_t == BMX280_OSRS_SKIP || osrs_t > BMX280_OSRS_X16 ||
+        osrs_p == BMX280_OSRS_SKIP || osrs_p > BMX280_OSRS_X16 || filter > BMX280_FILTER_X16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_osrs_t = osrs_t;
+    s_osrs_p = osrs_p;
+    s_filter = filter;
+
+    // Not attached yet: the filter is programmed by init/attach
+    if (s_dev == NULL) return ESP_OK;
+    esp_err_t ret = bmp280_configure(s_dev);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "bmp280_set_config: config write failed (%s)", esp_err_to_name(ret));
+    }
+    return ret;
+}
 
-    *adc_P = (int32_t)((((uint32_t)data[0]) << 12) | (((uint32_t)data[1]) << 4) | ((uint32_t)data[2] >> 4));
-    *adc_T = (int32_t)((((uint32_t)data[3]) << 12) | (((uint32_t)data[4]) << 4) | ((uint32_t)data[5] >> 4));
+esp_err_t bmp280_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us)
+{
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    uint8_t ctrl = (uint8_t)((s_osrs_t << 5) | (s_osrs_p << 2) | 1); // mode=1 (forced)
+    esp_err_t ret = i2c_bus_write_bytes(s_dev, BMP280_REG_CTRL_MEAS, 1, &ctrl);
+    if (ret != ESP_OK) {
+        s_pending = false;
+        return ret;
+    }
+
+    s_start_us = esp_timer_get_time();
+    s_typ_us = bmx280_conversion_time_us(s_osrs_t, s_osrs_p, BMX280_OSRS_SKIP, false);
+    s_max_us = bmx280_conversion_time_us(s_osrs_t, s_osrs_p, BMX280_OSRS_SKIP, true);
+    s_pending = true;
+    if (out_min_us) *out_min_us = s_typ_us;
+    if (out_max_us) *out_max_us = s_max_us;
     return ESP_OK;
 }
 
-// Read raw ADC values with trigger and wait (for standalone use)
+bool bmp280_is_measurement_ready(void)
+{
+    if (!s_pending) return false;
+    int64_t elapsed = esp_timer_get_time() - s_start_us;
+    if (elapsed < s_typ_us) return false;
+    if (elapsed >= s_max_us) return true;
+
+    // Between typical and max: ask the chip (status.measuring)
+    uint8_t status = 0;
+    if (i2c_bus_read_byte(s_dev, BMX280_REG_STATUS, &status) != ESP_OK) return false;
+    return (status & BMX280_STATUS_MEASURING) == 0;
+}
+
+// Read raw ADC values of the last completed conversion
 static esp_err_t bmp280_read_raw(int32_t *adc_T, int32_t *adc_P)
 {
     if (!adc_T || !adc_P) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
 
-    // trigger forced measurement
-    esp_err_t ret = bmp280_trigger_measurement();
+    uint8_t data[6];
+    esp_err_t ret = i2c_bus_read_bytes(s_dev, BMP280_REG_DATA, 6, data);
     if (ret != ESP_OK) return ret;
 
-    // typical max conversion time ~10ms for osrs=1; wait 15ms
-    vTaskDelay(pdMS_TO_TICKS(15));
-
-    return bmp280_read_raw_only(adc_T, adc_P);
+    *adc_P = (int32_t)((((uint32_t)data[0]) << 12) | (((uint32_t)data[1]) << 4) | ((uint32_t)data[2] >> 4));
+    *adc_T = (int32_t)((((uint32_t)data[3]) << 12) | (((uint32_t)data[4]) << 4) | ((uint32_t)data[5] >> 4));
+    return ESP_OK;
 }
 
-esp_err_t bmp280_read_temperature(float *out_c)
+esp_err_t bmp280_collect(void)
 {
-    if (!out_c) return ESP_ERR_INVALID_ARG;
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_pending) return ESP_ERR_INVALID_STATE;
+    s_pending = false;
+
     int32_t adc_T = 0, adc_P = 0;
     esp_err_t ret = bmp280_read_raw(&adc_T, &adc_P);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "bmp280_collect: read failed (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+
+    bmx280_comp_t comp;
+    ret = bmx280_compensate(&s_cal, adc_T, adc_P, 0, &comp);
     if (ret != ESP_OK) return ret;
 
-    // Temperature compensation (per datasheet)
-    float var1 = (((float)adc_T) / 16384.0f - ((float)dig_T1) / 1024.0f) * ((float)dig_T2);
-    float var2 = ((((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f) * (((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f)) * ((float)dig_T3);
-    float T = var1 + var2;
-    t_fine = (int32_t)T;
-    *out_c = T / 5120.0f;
+    s_last_temperature = (float)comp.temperature_centi / 100.0f;
+    s_last_pressure = (float)comp.pressure_q8 / 25600.0f; // Q24.8 Pa to hPa
+    s_have_data = true;
     return ESP_OK;
 }
 
-esp_err_t bmp280_read_pressure_no_trigger(float *out_hpa)
+esp_err_t bmp280_read_temperature(float *out_c)
 {
-    if (!out_hpa) return ESP_ERR_INVALID_ARG;
-    int32_t adc_T = 0, adc_P = 0;
-    esp_err_t ret = bmp280_read_raw_only(&adc_T, &adc_P);
-    if (ret != ESP_OK) return ret;
+    if (!out_c) return ESP_ERR_INVALID_ARG;
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
-    // compute t_fine from adc_T
-    float var1 = (((float)adc_T) / 16384.0f - ((float)dig_T1) / 1024.0f) * ((float)dig_T2);
-    float var2 = ((((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f) * (((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f)) * ((float)dig_T3);
-    float tf = var1 + var2;
-    int32_t t_f = (int32_t)tf;
-
-    // Pressure compensation (per datasheet)
-    float p_var1 = ((float)t_f / 2.0f) - 64000.0f;
-    float p_var2 = p_var1 * p_var1 * ((float)dig_P6) / 32768.0f;
-    p_var2 = p_var2 + p_var1 * ((float)dig_P5) * 2.0f;
-    p_var2 = (p_var2 / 4.0f) + (((float)dig_P4) * 65536.0f);
-    p_var1 = (((float)dig_P3) * p_var1 * p_var1 / 524288.0f + ((float)dig_P2) * p_var1) / 524288.0f;
-    p_var1 = (1.0f + p_var1 / 32768.0f) * ((float)dig_P1);
-    if (p_var1 == 0.0f) return ESP_ERR_INVALID_STATE; // avoid division by zero
-
-    float p = 1048576.0f - (float)adc_P;
-    p = (p - (p_var2 / 4096.0f)) * 6250.0f / p_var1;
-    p_var1 = ((float)dig_P9) * p * p / 2147483648.0f;
-    p_var2 = p * ((float)dig_P8) / 32768.0f;
-    p = p + (p_var1 + p_var2 + ((float)dig_P7)) / 16.0f;
-
-    *out_hpa = p / 100.0f; // convert Pa to hPa
+    *out_c = s_last_temperature;
     return ESP_OK;
 }
 
 esp_err_t bmp280_read_pressure(float *out_hpa)
 {
     if (!out_hpa) return ESP_ERR_INVALID_ARG;
-    int32_t adc_T = 0, adc_P = 0;
-    esp_err_t ret = bmp280_read_raw(&adc_T, &adc_P);
-    if (ret != ESP_OK) return ret;
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
-    // compute t_fine from adc_T
-    float var1 = (((float)adc_T) / 16384.0f - ((float)dig_T1) / 1024.0f) * ((float)dig_T2);
-    float var2 = ((((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f) * (((float)adc_T) / 131072.0f - ((float)dig_T1) / 8192.0f)) * ((float)dig_T3);
-    float tf = var1 + var2;
-    int32_t t_f = (int32_t)tf;
-
-    // Pressure compensation (per datasheet)
-    float p_var1 = ((float)t_f / 2.0f) - 64000.0f;
-    float p_var2 = p_var1 * p_var1 * ((float)dig_P6) / 32768.0f;
-    p_var2 = p_var2 + p_var1 * ((float)dig_P5) * 2.0f;
-    p_var2 = (p_var2 / 4.0f) + (((float)dig_P4) * 65536.0f);
-    p_var1 = (((float)dig_P3) * p_var1 * p_var1 / 524288.0f + ((float)dig_P2) * p_var1) / 524288.0f;
-    p_var1 = (1.0f + p_var1 / 32768.0f) * ((float)dig_P1);
-    if (p_var1 == 0.0f) return ESP_ERR_INVALID_STATE; // avoid division by zero
-
-    float p = 1048576.0f - (float)adc_P;
-    p = (p - (p_var2 / 4096.0f)) * 6250.0f / p_var1;
-    p_var1 = ((float)dig_P9) * p * p / 2147483648.0f;
-    p_var2 = p * ((float)dig_P8) / 32768.0f;
-    p = p + (p_var1 + p_var2 + ((float)dig_P7)) / 16.0f;
-
-    *out_hpa = p / 100.0f; // convert Pa to hPa
+    *out_hpa = s_last_pressure;
     return ESP_OK;
 }
@@ -2,18 +2,45 @@
 
 #include "i2c_bus.h"
 #include "esp_err.h"
+#include "bmx280_comp.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Size of the raw calibration block (registers 0x88-0x9F)
+#define BMP280_CALIB_LEN BMX280_CALIB_TP_LEN
 
 // Initialize BMP280 on provided I2C bus
 esp_err_t bmp280_init(i2c_bus_handle_t i2c_bus);
 
-// Trigger a measurement if required
-esp_err_t bmp280_trigger_measurement(void);
+// Attach to a BMP280 at a known address using cached raw calibration (skips probing)
+esp_err_t bmp280_attach(i2c_bus_handle_t i2c_bus, uint8_t addr, const uint8_t *calib);
+
+// Release the device handle (before the I2C bus is deleted)
+void bmp280_deinit(void);
+
+// I2C address of the attached BMP280 (0 if none)
+uint8_t bmp280_get_address(void);
+
+// Copy the raw calibration block (BMP280_CALIB_LEN bytes) of the attached BMP280
+esp_err_t bmp280_get_calibration(uint8_t *out, size_t len);
+
+// Set oversampling (BMX280_OSRS_*) and IIR filter (BMX280_FILTER_*) for the following
+// forced measurements; written to the chip at once if attached, otherwise at init/attach
+esp_err_t bmp280_set_config(uint8_t osrs_t, uint8_t osrs_p, uint8_t filter);
 
-// Read temperature in degrees Celsius
+// Start a forced-mode measurement without waiting; the optional outputs receive the
+// datasheet typical (earliest ready check) and maximum conversion time
+esp_err_t bmp280_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us);
+
+// True once the pending conversion has finished (status.measuring cleared or max time elapsed)
+bool bmp280_is_measurement_ready(void);
+
+// Fetch, compensate and cache the result of the pending conversion
+esp_err_t bmp280_collect(void);
+
+// Read temperature in degrees Celsius (last collected value)
 esp_err_t bmp280_read_temperature(float *out_c);
 
-// Read pressure in hPa (triggers measurement internally)
+// Read pressure in hPa (last collected value)
 esp_err_t bmp280_read_pressure(float *out_hpa);
-
-// Read pressure in hPa without triggering (assumes measurement already done)
-esp_err_t bmp280_read_pressure_no_trigger(float *out_hpa);
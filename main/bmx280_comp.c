@@ -0,0 +1,172 @@
+/*
+ * BMP280 / BME280 Compensation
+ *
+ * Formulas are taken verbatim from the Bosch datasheets (BMP280 section 8.2,
+ * BME280 section 8.2). The ESP32-H2 has no FPU, so the integer path is the
+ * default; the float path is kept as a reference and selected with
+ * BMX280_COMP_USE_FLOAT. Both produce the same fixed-point units.
+ */
+
+#include "bmx280_comp.h"
+#include <string.h>
+
+void bmx280_comp_parse_calib(bmx280_calib_t *cal, const uint8_t *raw, bool has_humidity)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->T1 = (uint16_t)((raw[1] << 8) | raw[0]);
+    cal->T2 = (int16_t)((raw[3] << 8) | raw[2]);
+    cal->T3 = (int16_t)((raw[5] << 8) | raw[4]);
+    cal->P1 = (uint16_t)((raw[7] << 8) | raw[6]);
+    cal->P2 = (int16_t)((raw[9] << 8) | raw[8]);
+    cal->P3 = (int16_t)((raw[11] << 8) | raw[10]);
+    cal->P4 = (int16_t)((raw[13] << 8) | raw[12]);
+    cal->P5 = (int16_t)((raw[15] << 8) | raw[14]);
+    cal->P6 = (int16_t)((raw[17] << 8) | raw[16]);
+    cal->P7 = (int16_t)((raw[19] << 8) | raw[18]);
+    cal->P8 = (int16_t)((raw[21] << 8) | raw[20]);
+    cal->P9 = (int16_t)((raw[23] << 8) | raw[22]);
+
+    cal->has_humidity = has_humidity;
+    if (has_humidity) {
+        const uint8_t *h = &raw[26];
+        cal->H1 = raw[25];
+        cal->H2 = (int16_t)((h[1] << 8) | h[0]);
+        cal->H3 = h[2];
+        cal->H4 = (int16_t)(((int16_t)(int8_t)h[3] << 4) | (h[4] & 0x0F));
+        cal->H5 = (int16_t)(((int16_t)(int8_t)h[5] << 4) | (h[4] >> 4));
+        cal->H6 = (int8_t)h[6];
+    }
+}
+
+/* Oversampling code to ratio: skip, x1, x2, x4, x8, x16 (codes above 5 mean x16) */
+static uint32_t bmx280_osrs_ratio(uint8_t osrs)
+{
+    static const uint8_t ratio[] = { 0, 1, 2, 4, 8, 16 };
+    return osrs < sizeof(ratio) ? ratio[osrs] : 16;
+}
+
+uint32_t bmx280_conversion_time_us(uint8_t osrs_t, uint8_t osrs_p, uint8_t osrs_h, bool max)
+{
+    const uint32_t base_us = max ? 1250 : 1000;
+    const uint32_t per_os_us = max ? 2300 : 2000;
+    const uint32_t setup_us = max ? 575 : 500;   // P and H measurement setup
+
+    uint32_t t = bmx280_osrs_ratio(osrs_t);
+    uint32_t p = bmx280_osrs_ratio(osrs_p);
+    uint32_t h = bmx280_osrs_ratio(osrs_h);
+
+    uint32_t us = base_us + per_os_us * t;
+    if (p) us += per_os_us * p + setup_us;
+    if (h) us += per_os_us * h + setup_us;
+    return us;
+}
+
+#if !BMX280_COMP_USE_FLOAT
+
+/* Returns temperature in 0.01 °C, t_fine carries fine resolution temperature to P/H */
+static int32_t bmx280_comp_temperature(const bmx280_calib_t *cal, int32_t adc_T, int32_t *t_fine)
+{
+    int32_t var1 = ((((adc_T >> 3) - ((int32_t)cal->T1 << 1))) * ((int32_t)cal->T2)) >> 11;
+    int32_t var2 = (((((adc_T >> 4) - ((int32_t)cal->T1)) * ((adc_T >> 4) - ((int32_t)cal->T1))) >> 12) *
+                    ((int32_t)cal->T3)) >> 14;
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+/* Returns pressure in Pa as Q24.8, 0 on invalid calibration */
+static uint32_t bmx280_comp_pressure(const bmx280_calib_t *cal, int32_t adc_P, int32_t t_fine)
+{
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)cal->P6;
+    var2 = var2 + ((var1 * (int64_t)cal->P5) << 17);
+    var2 = var2 + (((int64_t)cal->P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)cal->P3) >> 8) + ((var1 * (int64_t)cal->P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)cal->P1) >> 33;
+    if (var1 == 0) {
+        return 0; // avoid division by zero
+    }
+    int64_t p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)cal->P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)cal->P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)cal->P7) << 4);
+    return (uint32_t)p;
+}
+
+/* Returns humidity in %RH as Q22.10 */
+static uint32_t bmx280_comp_humidity(const bmx280_calib_t *cal, int32_t adc_H, int32_t t_fine)
+{
+    int32_t v = t_fine - ((int32_t)76800);
+    v = (((((adc_H << 14) - (((int32_t)cal->H4) << 20) - (((int32_t)cal->H5) * v)) + ((int32_t)16384)) >> 15) *
+         (((((((v * ((int32_t)cal->H6)) >> 10) * (((v * ((int32_t)cal->H3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) * ((int32_t)cal->H2) + 8192) >> 14));
+    v = (v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)cal->H1)) >> 4));
+    v = (v < 0 ? 0 : v);
+    v = (v > 419430400 ? 419430400 : v);
+    return (uint32_t)(v >> 12);
+}
+
+esp_err_t bmx280_compensate(const bmx280_calib_t *cal, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                            bmx280_comp_t *out)
+{
+    if (!cal || !out) return ESP_ERR_INVALID_ARG;
+
+    int32_t t_fine = 0;
+    int32_t t = bmx280_comp_temperature(cal, adc_T, &t_fine);
+    uint32_t p = bmx280_comp_pressure(cal, adc_P, t_fine);
+    if (p == 0) return ESP_ERR_INVALID_STATE;
+
+    out->temperature_centi = t;
+    out->pressure_q8 = p;
+    out->humidity_q10 = cal->has_humidity ? bmx280_comp_humidity(cal, adc_H, t_fine) : 0;
+    return ESP_OK;
+}
+
+#else /* BMX280_COMP_USE_FLOAT */
+
+esp_err_t bmx280_compensate(const bmx280_calib_t *cal, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                            bmx280_comp_t *out)
+{
+    if (!cal || !out) return ESP_ERR_INVALID_ARG;
+
+    // Temperature compensation (per datasheet)
+    float var1 = (((float)adc_T) / 16384.0f - ((float)cal->T1) / 1024.0f) * ((float)cal->T2);
+    float var2 = ((((float)adc_T) / 131072.0f - ((float)cal->T1) / 8192.0f) *
+                  (((float)adc_T) / 131072.0f - ((float)cal->T1) / 8192.0f)) * ((float)cal->T3);
+    float T = var1 + var2;
+    int32_t t_fine = (int32_t)T;
+
+    // Pressure compensation (per datasheet)
+    float p_var1 = ((float)t_fine / 2.0f) - 64000.0f;
+    float p_var2 = p_var1 * p_var1 * ((float)cal->P6) / 32768.0f;
+    p_var2 = p_var2 + p_var1 * ((float)cal->P5) * 2.0f;
+    p_var2 = (p_var2 / 4.0f) + (((float)cal->P4) * 65536.0f);
+    p_var1 = (((float)cal->P3) * p_var1 * p_var1 / 524288.0f + ((float)cal->P2) * p_var1) / 524288.0f;
+    p_var1 = (1.0f + p_var1 / 32768.0f) * ((float)cal->P1);
+    if (p_var1 == 0.0f) return ESP_ERR_INVALID_STATE; // avoid division by zero
+
+    float p = 1048576.0f - (float)adc_P;
+    p = (p - (p_var2 / 4096.0f)) * 6250.0f / p_var1;
+    p_var1 = ((float)cal->P9) * p * p / 2147483648.0f;
+    p_var2 = p * ((float)cal->P8) / 32768.0f;
+    p = p + (p_var1 + p_var2 + ((float)cal->P7)) / 16.0f;
+
+    // Humidity compensation (per datasheet)
+    float h = 0.0f;
+    if (cal->has_humidity) {
+        h = ((float)t_fine) - 76800.0f;
+        h = (((float)adc_H) - (((float)cal->H4) * 64.0f + ((float)cal->H5) / 16384.0f * h)) *
+            (((float)cal->H2) / 65536.0f * (1.0f + ((float)cal->H6) / 67108864.0f * h *
+            (1.0f + ((float)cal->H3) / 67108864.0f * h)));
+        h = h * (1.0f - ((float)cal->H1) * h / 524288.0f);
+        if (h > 100.0f) h = 100.0f;
+        if (h < 0.0f) h = 0.0f;
+    }
+
+    out->temperature_centi = (int32_t)(T / 51.2f);
+    out->pressure_q8 = (uint32_t)(p * 256.0f);
+    out->humidity_q10 = (uint32_t)(h * 1024.0f);
+    return ESP_OK;
+}
+
+#endif /* BMX280_COMP_USE_FLOAT */
@@ -0,0 +1,118 @@
+/*
+ * BMP280 / BME280 Compensation
+ * Shared calibration decoding and datasheet compensation formulas
+ */
+
+#ifndef BMX280_COMP_H
+#define BMX280_COMP_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Select the compensation path at compile time:
+ * 0 = datasheet 32/64-bit integer formulas (default, no soft-float on ESP32-H2)
+ * 1 = datasheet floating point formulas (reference path) */
+#ifndef BMX280_COMP_USE_FLOAT
+#define BMX280_COMP_USE_FLOAT 0
+#endif
+
+/* Raw calibration layout: 0x88-0xA1 (26 bytes), then 0xE1-0xE7 (7 bytes, BME280 only) */
+#define BMX280_CALIB_TP_LEN 24
+#define BMX280_CALIB_LEN    33
+
+typedef struct {
+    uint16_t T1;
+    int16_t  T2;
+    int16_t  T3;
+    uint16_t P1;
+    int16_t  P2;
+    int16_t  P3;
+    int16_t  P4;
+    int16_t  P5;
+    int16_t  P6;
+    int16_t  P7;
+    int16_t  P8;
+    int16_t  P9;
+    uint8_t  H1;
+    int16_t  H2;
+    uint8_t  H3;
+    int16_t  H4;
+    int16_t  H5;
+    int8_t   H6;
+    bool     has_humidity;
+} bmx280_calib_t;
+
+/* Oversampling register codes (osrs_t / osrs_p / osrs_h fields) */
+#define BMX280_OSRS_SKIP 0
+#define BMX280_OSRS_X1   1
+#define BMX280_OSRS_X2   2
+#define BMX280_OSRS_X4   3
+#define BMX280_OSRS_X8   4
+#define BMX280_OSRS_X16  5
+
+/* IIR filter coefficient codes (config register 0xF5 bits 4:2); the filter
+ * state is kept between forced measurements as long as the chip stays powered */
+#define BMX280_REG_CONFIG      0xF5
+#define BMX280_FILTER_OFF      0
+#define BMX280_FILTER_X2       1
+#define BMX280_FILTER_X4       2
+#define BMX280_FILTER_X8       3
+#define BMX280_FILTER_X16      4
+#define BMX280_CONFIG(filter)  ((uint8_t)(((filter) & 0x07) << 2))
+
+/* Status register (0xF3): measuring bit is set while a conversion is running */
+#define BMX280_REG_STATUS        0xF3
+#define BMX280_STATUS_MEASURING  (1 << 3)
+
+/* Compensated values in fixed-point units (identical for both paths) */
+typedef struct {
+    int32_t  temperature_centi;  // 0.01 °C
+    uint32_t pressure_q8;        // Pa, Q24.8 (value / 256 = Pa)
+    uint32_t humidity_q10;       // %RH, Q22.10 (value / 1024 = %RH), 0 without humidity
+} bmx280_comp_t;
+
+/**
+ * @brief Decode a raw calibration block
+ * @param cal Destination
+ * @param raw BMX280_CALIB_TP_LEN bytes (BMP280) or BMX280_CALIB_LEN bytes (BME280)
+ * @param has_humidity true to decode the humidity coefficients (BME280)
+ */
+void bmx280_comp_parse_calib(bmx280_calib_t *cal, const uint8_t *raw, bool has_humidity);
+
+/**
+ * @brief Compensate one raw frame; t_fine is computed once and shared by P and H
+ * @param cal Decoded calibration
+ * @param adc_T Raw 20-bit temperature
+ * @param adc_P Raw 20-bit pressure
+ * @param adc_H Raw 16-bit humidity (ignored without humidity coefficients)
+ * @param out Compensated result
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE on invalid calibration (division by zero)
+ */
+esp_err_t bmx280_compensate(const bmx280_calib_t *cal, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                            bmx280_comp_t *out);
+
+/**
+ * @brief Forced-mode conversion time from the datasheet formula (BME280 9.1 / BMP280 3.8.1)
+ *
+ * max: 1.25 + 2.3*T + (2.3*P + 0.575) + (2.3*H + 0.575) ms
+ * typ: 1.0  + 2.0*T + (2.0*P + 0.5)   + (2.0*H + 0.5)   ms
+ * where T/P/H are oversampling ratios and a skipped channel contributes nothing.
+ *
+ * @param osrs_t Temperature oversampling code (BMX280_OSRS_*)
+ * @param osrs_p Pressure oversampling code
+ * @param osrs_h Humidity oversampling code (BMX280_OSRS_SKIP on BMP280)
+ * @param max true for the maximum, false for the typical time
+ * @return Conversion time in microseconds
+ */
+uint32_t bmx280_conversion_time_us(uint8_t osrs_t, uint8_t osrs_p, uint8_t osrs_h, bool max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BMX280_COMP_H
@@ -0,0 +1,654 @@
+/*
+ * Counter Channels
+ *
+ * Design:
+ * - One const table row per input; adding an anemometer or flow meter is a new row,
+ *   not a new task/queue/timer/ISR copy
+ * - One ISR for all GPIO-backend channels (arg = channel index) feeding one queue;
+ *   one task owns every total, so Zigbee writes are applied as queue events too
+ * - One esp_timer armed for the earliest per-channel flush deadline (quiet time after
+ *   the last pulse, or the next collect of an active PCNT burst)
+ * - Totals are integer pulse counts; the fixed-point calibration (1e-6 units per pulse)
+ *   turns them into units only when they are published or logged, so they never drift
+ * - Totals cached in one RTC record (magic + format + CRC + channel count) so a reset with
+ *   RTC retained skips NVS; NVS keeps the per-channel namespace/keys of the table
+ * - Flushes append one record with every channel's count to the counter journal partition
+ *   (one small flash program, no NVS commit); without that partition the per-channel NVS
+ *   keys are written as before. Load order: RTC, journal, NVS
+ * - Once the journal holds a record it is the persistent copy: the NVS keys go stale and are
+ *   not read while it does (they seed an empty journal; a failed journal write still lands
+ *   there, so a journal lost later falls back to the best NVS value)
+ * - An RTC or journal record written by a table with another channel count restores the
+ *   first min(stored, current) channels; channels added since start from zero
+ * - Storage format 2 persists the pulse count only; format-1 float totals found in NVS are
+ *   converted to pulses once and their blob erased (a format-1 RTC record is just dropped)
+ * - Attribute publishing is a callback: this module knows nothing about Zigbee
+ */
+
+#include "counter_channel.h"
+#include "counter_journal.h"
+#include "pulse_pcnt.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "COUNTER";
+
+#define COUNTER_QUEUE_LEN    32
+#define COUNTER_TASK_STACK   4096
+#define COUNTER_RTC_MAGIC    0xC0C4A001
+#define COUNTER_FORMAT       2              // 1: float total + pulses, 2: pulses only
+#define COUNTER_NVS_FORMAT_KEY "fmt"        // u8 in each channel namespace, absent = format 1
+
+typedef enum {
+    COUNTER_EVT_PULSE = 0,  // GPIO backend edge
+    COUNTER_EVT_HW,         // PCNT backend: burst started or threshold reached
+    COUNTER_EVT_TIMER,      // Flush timer expired: flush channels whose deadline passed
+    COUNTER_EVT_FLUSH,      // Explicit flush request
+    COUNTER_EVT_SET,        // Replace a total
+} counter_evt_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t channel;
+    bool force_nvs;
+    bool force_attribute;
+    TickType_t tick;
+    float value;
+} counter_evt_t;
+
+typedef struct {
+    uint32_t pulses;                // The total: units = pulses x micro_units_per_pulse / 1e6
+    uint32_t pending_pulses;        // Accepted since the last flush
+    bool pending_nvs;
+    bool pending_attr;
+    TickType_t last_tick;           // Last accepted edge (debounce)
+    int64_t flush_due_us;           // esp_timer deadline, 0 = none
+    pulse_pcnt_handle_t pcnt;       // NULL: GPIO ISR backend
+    bool isr_installed;
+    uint32_t overflows;             // Edges dropped on a full queue (written from ISR)
+} counter_state_t;
+
+/* Totals across resets with RTC memory retained */
+typedef struct {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t count;
+    uint32_t pulses[COUNTER_CHANNEL_MAX];
+    uint32_t crc;
+} counter_rtc_t;
+
+static RTC_DATA_ATTR counter_rtc_t s_rtc;
+
+static const counter_channel_config_t *s_table;
+static size_t s_count;
+static counter_state_t s_state[COUNTER_CHANNEL_MAX];
+static QueueHandle_t s_queue;
+static esp_timer_handle_t s_flush_timer;
+static counter_channel_publish_cb_t s_publish;
+static volatile bool s_online;
+
+uint64_t counter_channel_micro_units(const counter_channel_config_t *config, uint32_t pulses)
+{
+    return (uint64_t)pulses * config->micro_units_per_pulse;
+}
+
+/* Total in 0.01 units, rounded half up (log/display precision) */
+static uint64_t counter_centi(size_t idx)
+{
+    return (counter_channel_micro_units(&s_table[idx], s_state[idx].pulses) + COUNTER_MICRO_PER_UNIT / 200) /
+           (COUNTER_MICRO_PER_UNIT / 100);
+}
+
+static float counter_total(size_t idx)
+{
+    return (float)counter_centi(idx) / 100.0f;
+}
+
+/* Whole pulses closest to a total in units (writes from the coordinator, format-1 migration) */
+static uint32_t counter_pulses_from_units(size_t idx, float units)
+{
+    double pulses = (double)units * COUNTER_MICRO_PER_UNIT / s_table[idx].micro_units_per_pulse;
+    return pulses >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)llround(pulses);
+}
+
+/* printf arguments for a counter_centi() value with "%llu.%02u" */
+#define CENTI_ARGS(c) (unsigned long long)((c) / 100), (unsigned)((c) % 100)
+
+static uint32_t counter_rtc_crc(void)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&s_rtc, offsetof(counter_rtc_t, crc));
+}
+
+static bool counter_rtc_valid(void)
+{
+    return s_rtc.magic == COUNTER_RTC_MAGIC && s_rtc.format == COUNTER_FORMAT && s_rtc.count > 0 &&
+           s_rtc.count <= COUNTER_CHANNEL_MAX && s_rtc.crc == counter_rtc_crc();
+}
+
+static void counter_rtc_store(void)
+{
+    for (size_t i = 0; i < s_count; i++) {
+        s_rtc.pulses[i] = s_state[i].pulses;
+    }
+    s_rtc.magic = COUNTER_RTC_MAGIC;
+    s_rtc.format = COUNTER_FORMAT;
+    s_rtc.count = s_count;
+    s_rtc.crc = counter_rtc_crc();
+}
+
+/* Write the channel's NVS keys in one commit; the legacy float blob is dropped on migration */
+static void counter_save_nvs(size_t idx, bool erase_legacy)
+{
+    const counter_channel_config_t *cfg = &s_table[idx];
+    counter_state_t *st = &s_state[idx];
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(cfg->nvs_namespace, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(cfg->name, "⚠️ NVS not available: %s", esp_err_to_name(ret));
+        return;
+    }
+    nvs_set_u8(nvs_handle, COUNTER_NVS_FORMAT_KEY, COUNTER_FORMAT);
+    nvs_set_u32(nvs_handle, cfg->nvs_count_key, st->pulses);
+    if (erase_legacy) {
+        nvs_erase_key(nvs_handle, cfg->nvs_value_key);
+    }
+    ret = nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    if (ret == ESP_OK) {
+        uint64_t centi = counter_centi(idx);
+        ESP_LOGI(cfg->name, "💾 Saved: %llu.%02u (%lu pulses)", CENTI_ARGS(centi), (unsigned long)st->pulses);
+    }
+}
+
+static void counter_load_nvs(size_t idx)
+{
+    const counter_channel_config_t *cfg = &s_table[idx];
+    counter_state_t *st = &s_state[idx];
+    nvs_handle_t nvs_handle;
+    if (nvs_open(cfg->nvs_namespace, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    uint8_t format = 1;
+    nvs_get_u8(nvs_handle, COUNTER_NVS_FORMAT_KEY, &format);
+    uint32_t pulses = 0;
+    bool have_pulses = nvs_get_u32(nvs_handle, cfg->nvs_count_key, &pulses) == ESP_OK;
+    float total = 0.0f;
+    size_t size = sizeof(total);
+    bool have_total = format < COUNTER_FORMAT &&
+                      nvs_get_blob(nvs_handle, cfg->nvs_value_key, &total, &size) == ESP_OK &&
+                      isfinite(total) && total >= 0.0f;
+    nvs_close(nvs_handle);
+
+    if (format >= COUNTER_FORMAT || !have_total) {
+        st->pulses = have_pulses ? pulses : 0;
+        return;
+    }
+    /* Format 1: the float total is what the coordinator last saw (a Zigbee reset only rewrote
+     * the total), so it wins over the stored count */
+    st->pulses = counter_pulses_from_units(idx, total);
+    ESP_LOGI(cfg->name, "🔄 Migrating format-1 total %.2f (%lu pulses stored) -> %lu pulses", total,
+             (unsigned long)pulses, (unsigned long)st->pulses);
+    counter_save_nvs(idx, true);
+}
+
+/* One journal record with every channel's count */
+static esp_err_t counter_save_journal(void)
+{
+    uint32_t pulses[COUNTER_CHANNEL_MAX];
+    for (size_t i = 0; i < s_count; i++) {
+        pulses[i] = s_state[i].pulses;
+    }
+    return counter_journal_append(pulses, s_count);
+}
+
+/* RTC record (all channels), then the journal, else the channel's NVS keys */
+static void counter_save(size_t idx)
+{
+    counter_rtc_store();
+    if (counter_journal_available()) {
+        if (counter_save_journal() == ESP_OK) {
+            uint64_t centi = counter_centi(idx);
+            ESP_LOGI(s_table[idx].name, "💾 Journaled: %llu.%02u (%lu pulses)", CENTI_ARGS(centi),
+                     (unsigned long)s_state[idx].pulses);
+            return;
+        }
+        ESP_LOGW(s_table[idx].name, "⚠️ Journal write failed - saving to NVS");
+    }
+    counter_save_nvs(idx, false);
+}
+
+static void counter_add(size_t idx, uint32_t pulses, TickType_t tick)
+{
+    counter_state_t *st = &s_state[idx];
+    if (s_table[idx].on_pulses) {
+        s_table[idx].on_pulses(idx, pulses, pdTICKS_TO_MS(tick));
+    }
+    st->pulses += pulses;
+    st->pending_pulses += pulses;
+    st->pending_nvs = true;
+    if (s_online) {
+        st->pending_attr = true;
+    }
+}
+
+static void counter_flush_totals(size_t idx, bool save_to_nvs, bool update_attribute)
+{
+    const counter_channel_config_t *cfg = &s_table[idx];
+    counter_state_t *st = &s_state[idx];
+    if (st->overflows) {
+        ESP_LOGW(cfg->name, "⚠️ %lu edge(s) dropped on a full event queue", (unsigned long)st->overflows);
+        st->overflows = 0;
+    }
+    if (save_to_nvs) {
+        counter_save(idx);
+    }
+    if (update_attribute && s_publish) {
+        s_publish(idx, cfg, counter_total(idx), st->pulses);
+    }
+    st->pending_pulses = 0;
+    st->pending_nvs = false;
+    st->pending_attr = false;
+}
+
+/* Move the PCNT count into the totals; returns true while the burst continues */
+static bool counter_collect_pcnt(size_t idx)
+{
+    counter_state_t *st = &s_state[idx];
+    uint32_t pulses = 0;
+    bool active = false;
+    if (st->pcnt == NULL || pulse_pcnt_take(st->pcnt, &pulses, &active) != ESP_OK || pulses == 0) {
+        return active;
+    }
+    counter_add(idx, pulses, xTaskGetTickCount());
+    uint64_t centi = counter_centi(idx);
+    ESP_LOGI(s_table[idx].name, "🔢 %lu pulse(s) from PCNT: %llu.%02u total", (unsigned long)pulses, CENTI_ARGS(centi));
+    return active;
+}
+
+static void counter_flush(size_t idx, bool force_nvs, bool force_attribute)
+{
+    counter_state_t *st = &s_state[idx];
+    bool burst_active = counter_collect_pcnt(idx);
+    bool do_nvs = st->pending_nvs || force_nvs;
+    bool do_attr = st->pending_attr || force_attribute;
+    if (do_nvs || do_attr) {
+        counter_flush_totals(idx, do_nvs, do_attr);
+    }
+    st->flush_due_us = burst_active ? esp_timer_get_time() + COUNTER_FLUSH_INTERVAL_US : 0;
+}
+
+/* Arm the shared timer for the earliest deadline */
+static void counter_arm_timer(void)
+{
+    int64_t due = 0;
+    for (size_t i = 0; i < s_count; i++) {
+        if (s_state[i].flush_due_us && (due == 0 || s_state[i].flush_due_us < due)) {
+            due = s_state[i].flush_due_us;
+        }
+    }
+    esp_timer_stop(s_flush_timer);
+    if (due) {
+        int64_t delay = due - esp_timer_get_time();
+        esp_timer_start_once(s_flush_timer, delay > 1000 ? (uint64_t)delay : 1000);
+    }
+}
+
+static void counter_handle_pulse(size_t idx, TickType_t tick)
+{
+    const counter_channel_config_t *cfg = &s_table[idx];
+    counter_state_t *st = &s_state[idx];
+    if ((tick - st->last_tick) <= pdMS_TO_TICKS(cfg->debounce_ms)) {
+        ESP_LOGD(cfg->name, "Pulse ignored - debounce active (%lu ms)", (unsigned long)pdTICKS_TO_MS(tick - st->last_tick));
+        return;
+    }
+    st->last_tick = tick;
+    counter_add(idx, 1, tick);
+    uint64_t centi = counter_centi(idx);
+    ESP_LOGI(cfg->name, "🔢 Pulse #%lu: %llu.%02u total", (unsigned long)st->pulses, CENTI_ARGS(centi));
+
+    if (st->pending_pulses >= COUNTER_FLUSH_THRESHOLD) {
+        ESP_LOGD(cfg->name, "Pulse threshold reached (%lu) - flushing totals", (unsigned long)st->pending_pulses);
+        counter_flush(idx, false, false);
+    } else {
+        st->flush_due_us = esp_timer_get_time() + COUNTER_FLUSH_INTERVAL_US;
+    }
+}
+
+static void counter_handle_event(const counter_evt_t *evt)
+{
+    size_t first = evt->channel == COUNTER_CHANNEL_ALL ? 0 : evt->channel;
+    size_t last = evt->channel == COUNTER_CHANNEL_ALL ? s_count : (size_t)evt->channel + 1;
+    if (first >= s_count) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (size_t i = first; i < last && i < s_count; i++) {
+        counter_state_t *st = &s_state[i];
+        switch (evt->type) {
+        case COUNTER_EVT_PULSE:
+            counter_handle_pulse(i, evt->tick);
+            break;
+        case COUNTER_EVT_HW:
+            /* Burst start schedules the collect; a threshold event during the burst flushes now */
+            if (st->flush_due_us == 0) {
+                st->flush_due_us = now + COUNTER_FLUSH_INTERVAL_US;
+            } else {
+                counter_flush(i, false, false);
+            }
+            break;
+        case COUNTER_EVT_TIMER:
+            if (st->flush_due_us && st->flush_due_us <= now) {
+                counter_flush(i, false, false);
+            }
+            break;
+        case COUNTER_EVT_FLUSH:
+            counter_flush(i, evt->force_nvs, evt->force_attribute);
+            break;
+        case COUNTER_EVT_SET:
+            st->pulses = counter_pulses_from_units(i, evt->value);
+            ESP_LOGI(s_table[i].name, "🔄 Total set: %.2f -> %lu pulses", evt->value, (unsigned long)st->pulses);
+            counter_save(i);
+            st->pending_nvs = false;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void counter_task(void *arg)
+{
+    counter_evt_t evt;
+    ESP_LOGI(TAG, "Counter task started for %u channel(s)", (unsigned)s_count);
+    for (;;) {
+        if (xQueueReceive(s_queue, &evt, portMAX_DELAY)) {
+            counter_handle_event(&evt);
+            counter_arm_timer();
+        }
+    }
+}
+
+static void IRAM_ATTR counter_gpio_isr(void *arg)
+{
+    uint8_t idx = (uint8_t)(uintptr_t)arg;
+    counter_evt_t evt = {
+        .type = COUNTER_EVT_PULSE,
+        .channel = idx,
+        .tick = xTaskGetTickCountFromISR(),
+    };
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    if (xQueueSendFromISR(s_queue, &evt, &xHigherPriorityTaskWoken) != pdPASS) {
+        s_state[idx].overflows++;   // Pulse lost, reported at the next flush
+    }
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/* PCNT backend event (ISR context): a full queue only delays the flush, the count stays in the unit */
+static bool IRAM_ATTR counter_pcnt_event(void *arg)
+{
+    counter_evt_t evt = {
+        .type = COUNTER_EVT_HW,
+        .channel = (uint8_t)(uintptr_t)arg,
+        .tick = xTaskGetTickCountFromISR(),
+    };
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xQueueSendFromISR(s_queue, &evt, &xHigherPriorityTaskWoken);
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+static void counter_flush_timer_callback(void *arg)
+{
+    counter_evt_t evt = {
+        .type = COUNTER_EVT_TIMER,
+        .channel = COUNTER_CHANNEL_ALL,
+    };
+    xQueueSend(s_queue, &evt, 0);
+}
+
+static void counter_post(const counter_evt_t *evt)
+{
+    if (s_queue == NULL) {
+        return;
+    }
+    if (xQueueSend(s_queue, evt, 0) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to queue counter event %u (queue full)", evt->type);
+    }
+}
+
+static esp_err_t counter_setup_input(size_t idx)
+{
+    const counter_channel_config_t *cfg = &s_table[idx];
+    counter_state_t *st = &s_state[idx];
+    void *arg = (void *)(uintptr_t)idx;
+
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_POSEDGE,
+        .pin_bit_mask = (1ULL << cfg->gpio),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = 0,
+        .pull_down_en = 1,
+    };
+    ESP_RETURN_ON_ERROR(gpio_config(&io_conf), cfg->name, "Failed to configure GPIO%d", cfg->gpio);
+
+    /* Light sleep wake source, so pulses are not missed while the chip sleeps */
+    esp_err_t ret = gpio_wakeup_enable(cfg->gpio, GPIO_INTR_HIGH_LEVEL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(cfg->name, "⚠️ Failed to enable GPIO wake: %s", esp_err_to_name(ret));
+    }
+
+    /* Optional hardware counting: PCNT counts the edges, the CPU only wakes per burst */
+    if (cfg->use_pcnt) {
+        const pulse_pcnt_config_t pcnt_config = {
+            .gpio = cfg->gpio,
+            .threshold = cfg->pcnt_threshold,
+            .on_event = counter_pcnt_event,
+            .user_ctx = arg,
+        };
+        ret = pulse_pcnt_new(&pcnt_config, &st->pcnt);
+        if (ret == ESP_OK) {
+            st->isr_installed = true;
+            ESP_LOGI(cfg->name, "✅ PCNT counting on GPIO%d (counts while offline)", cfg->gpio);
+            return ESP_OK;
+        }
+        st->pcnt = NULL;
+        ESP_LOGW(cfg->name, "⚠️ PCNT backend unavailable (%s) - using GPIO ISR", esp_err_to_name(ret));
+    }
+
+    /* Installed now so pulses after wake (but before the network is back) are counted */
+    ret = gpio_isr_handler_add(cfg->gpio, counter_gpio_isr, arg);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(cfg->name, "⚠️ Failed to add ISR handler: %s - pulses while offline may be missed", esp_err_to_name(ret));
+        return ret;
+    }
+    st->isr_installed = true;
+    gpio_intr_enable(cfg->gpio);
+    ESP_LOGI(cfg->name, "✅ GPIO%d counting (level=%d, pull-down, rising edge, %lu ms debounce)",
+             cfg->gpio, gpio_get_level(cfg->gpio), (unsigned long)cfg->debounce_ms);
+    return ESP_OK;
+}
+
+esp_err_t counter_channel_init(const counter_channel_config_t *table, size_t count)
+{
+    ESP_RETURN_ON_FALSE(table && count > 0 && count <= COUNTER_CHANNEL_MAX && count <= COUNTER_JOURNAL_VALUES,
+                        ESP_ERR_INVALID_ARG, TAG,
+                        "invalid channel table");
+    for (size_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_FALSE(table[i].micro_units_per_pulse > 0, ESP_ERR_INVALID_ARG, TAG, "%s: zero calibration",
+                            table[i].name);
+    }
+    s_table = table;
+    s_count = count;
+    memset(s_state, 0, sizeof(s_state));
+
+    bool journal = counter_journal_init() == ESP_OK;
+    uint32_t stored[COUNTER_CHANNEL_MAX];
+    size_t stored_count = 0;
+    const char *source = "NVS";
+    bool from_record = true;
+    if (counter_rtc_valid()) {
+        stored_count = s_rtc.count;
+        memcpy(stored, s_rtc.pulses, stored_count * sizeof(uint32_t));
+        source = "RTC";
+    } else if (journal && counter_journal_latest(stored, COUNTER_CHANNEL_MAX, &stored_count) == ESP_OK) {
+        source = "journal";
+    } else {
+        from_record = false;
+    }
+    if (from_record && stored_count != count) {
+        ESP_LOGW(TAG, "⚠️ %s record holds %u channel(s), table has %u - restoring %u", source,
+                 (unsigned)stored_count, (unsigned)count, (unsigned)(stored_count < count ? stored_count : count));
+    }
+    /* Channels added since the record was written start from zero */
+    for (size_t i = 0; i < count; i++) {
+        if (i < stored_count) {
+            s_state[i].pulses = stored[i];
+        } else if (!from_record) {
+            counter_load_nvs(i);
+        }
+        uint64_t centi = counter_centi(i);
+        ESP_LOGI(table[i].name, "📂 Loaded from %s: %llu.%02u (%lu pulses)",
+                 i < stored_count || !from_record ? source : "nothing (new channel)", CENTI_ARGS(centi),
+                 (unsigned long)s_state[i].pulses);
+    }
+    counter_rtc_store();
+    if (journal && !from_record) {
+        /* First boot with the journal partition: seed it, NVS is not read from here on */
+        counter_save_journal();
+    }
+    return ESP_OK;
+}
+
+esp_err_t counter_channel_start(counter_channel_publish_cb_t publish)
+{
+    ESP_RETURN_ON_FALSE(s_table, ESP_ERR_INVALID_STATE, TAG, "counter_channel_init() not called");
+    ESP_RETURN_ON_FALSE(s_queue == NULL, ESP_ERR_INVALID_STATE, TAG, "already started");
+    s_publish = publish;
+
+    s_queue = xQueueCreate(COUNTER_QUEUE_LEN, sizeof(counter_evt_t));
+    ESP_RETURN_ON_FALSE(s_queue, ESP_ERR_NO_MEM, TAG, "Failed to create event queue");
+
+    const esp_timer_create_args_t flush_timer_args = {
+        .callback = counter_flush_timer_callback,
+        .name = "counter_flush"
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&flush_timer_args, &s_flush_timer), TAG, "Failed to create flush timer");
+
+    esp_err_t ret = gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    for (size_t i = 0; i < s_count; i++) {
+        counter_setup_input(i);
+    }
+
+    ESP_RETURN_ON_FALSE(xTaskCreate(counter_task, "counter_task", COUNTER_TASK_STACK, NULL, 5, NULL) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "Failed to create counter task");
+    ESP_LOGI(TAG, "✅ %u counter channel(s) ready - initial report after network connection", (unsigned)s_count);
+    return ESP_OK;
+}
+
+void counter_channel_set_online(bool online)
+{
+    s_online = online;
+    for (size_t i = 0; i < s_count; i++) {
+        const counter_channel_config_t *cfg = &s_table[i];
+        counter_state_t *st = &s_state[i];
+        if (st->pcnt != NULL) {
+            continue;   // PCNT owns the GPIO interrupt and counts all along
+        }
+        if (online && !st->isr_installed && s_queue != NULL) {
+            counter_setup_input(i);
+        } else if (st->isr_installed) {
+            /* The handler stays installed: removing it would open a gap where edges cannot be queued */
+            if (online) {
+                gpio_intr_enable(cfg->gpio);
+            } else {
+                gpio_intr_disable(cfg->gpio);
+            }
+        }
+        ESP_LOGI(cfg->name, "%s on GPIO%d", online ? "✅ Counting enabled" : "Interrupts disabled (handler kept)", cfg->gpio);
+    }
+    if (!online) {
+        /* Persist any accumulated pulses before going idle */
+        counter_channel_request_flush(COUNTER_CHANNEL_ALL, true, false);
+    }
+}
+
+void counter_channel_request_flush(uint8_t index, bool force_nvs, bool force_attribute)
+{
+    counter_evt_t evt = {
+        .type = COUNTER_EVT_FLUSH,
+        .channel = index,
+        .force_nvs = force_nvs,
+        .force_attribute = force_attribute,
+    };
+    counter_post(&evt);
+}
+
+void counter_channel_set_total(uint8_t index, float total)
+{
+    if (index >= s_count || !isfinite(total) || total < 0.0f) {
+        ESP_LOGW(TAG, "Ignoring total %.2f for channel %u", total, index);
+        return;
+    }
+    counter_evt_t evt = {
+        .type = COUNTER_EVT_SET,
+        .channel = index,
+        .value = total,
+    };
+    counter_post(&evt);
+}
+
+void counter_channel_count_wake_pulse(uint8_t index)
+{
+    if (index >= s_count || s_queue != NULL) {
+        return;
+    }
+    counter_add(index, 1, xTaskGetTickCount());
+    uint64_t centi = counter_centi(index);
+    ESP_LOGI(s_table[index].name, "🔢 Pulse during sleep: #%lu, %llu.%02u total", (unsigned long)s_state[index].pulses,
+             CENTI_ARGS(centi));
+    counter_save(index);
+    s_state[index].pending_nvs = false;
+}
+
+esp_err_t counter_channel_get_total(uint8_t index, float *total, uint32_t *pulses)
+{
+    ESP_RETURN_ON_FALSE(index < s_count && total, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    *total = counter_total(index);
+    if (pulses) *pulses = s_state[index].pulses;
+    return ESP_OK;
+}
+
+int counter_channel_find_endpoint(uint8_t endpoint)
+{
+    for (size_t i = 0; i < s_count; i++) {
+        if (s_table[i].endpoint == endpoint) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const counter_channel_config_t *counter_channel_get_config(uint8_t index)
+{
+    return index < s_count ? &s_table[index] : NULL;
+}
+
+size_t counter_channel_count(void)
+{
+    return s_count;
+}
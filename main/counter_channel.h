@@ -0,0 +1,152 @@
+/*
+ * Counter Channels
+ * Pulse inputs (rain gauge, pulse counter, ...) described by a const table and
+ * served by one task, one queue and one flush timer
+ */
+
+#ifndef COUNTER_CHANNEL_H
+#define COUNTER_CHANNEL_H
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Channels supported by the RTC cache and the per-channel state */
+#ifndef COUNTER_CHANNEL_MAX
+#define COUNTER_CHANNEL_MAX 4
+#endif
+
+/* Accepted pulses before the totals are flushed without waiting for the timer */
+#ifndef COUNTER_FLUSH_THRESHOLD
+#define COUNTER_FLUSH_THRESHOLD 10U
+#endif
+
+/* Quiet time after the last pulse before the totals are flushed */
+#ifndef COUNTER_FLUSH_INTERVAL_US
+#define COUNTER_FLUSH_INTERVAL_US (10ULL * 1000ULL * 1000ULL)
+#endif
+
+/* Channel index for requests that address every channel */
+#define COUNTER_CHANNEL_ALL 0xFF
+
+/* Fixed-point calibration: totals are pulses x micro-units per pulse, never a float sum */
+#define COUNTER_MICRO_PER_UNIT 1000000U
+#define COUNTER_MICRO_UNITS(units) ((uint32_t)((units) * COUNTER_MICRO_PER_UNIT + 0.5))
+
+/**
+ * @brief One pulse input
+ *
+ * endpoint, reportable_change, description and the metering fields are not used by
+ * this module; they let the Zigbee side build the endpoint and its reporting from the
+ * same row.
+ */
+typedef struct {
+    const char *name;               /*!< Log tag */
+    gpio_num_t gpio;                /*!< Rising-edge input, pulled down, light-sleep wake source */
+    uint32_t micro_units_per_pulse; /*!< Calibration in 1e-6 units per pulse (mm of rain, litres, ...);
+                                         use COUNTER_MICRO_UNITS() */
+    uint32_t debounce_ms;           /*!< Minimum spacing of accepted pulses (GPIO ISR backend) */
+    bool use_pcnt;                  /*!< Count with the PCNT peripheral instead of one ISR per edge */
+    uint16_t pcnt_threshold;        /*!< PCNT backend: flush every N pulses during a burst */
+    uint8_t endpoint;               /*!< Zigbee endpoint (Analog Input PresentValue) */
+    float reportable_change;        /*!< Local reporting configuration */
+    const char *description;        /*!< ZCL character string (length-prefixed) */
+    uint8_t metering_unit;          /*!< Metering UnitofMeasure (0x07 litres, 0x0B unitless, ...) */
+    uint8_t metering_device_type;   /*!< Metering MeteringDeviceType (0x00 electric, 0x02 water, ...) */
+    const char *nvs_namespace;      /*!< NVS location of the totals */
+    const char *nvs_value_key;      /*!< Legacy float blob (format 1), migrated and erased on load */
+    const char *nvs_count_key;      /*!< u32: total pulses (the persisted total) */
+    void (*on_pulses)(size_t index, uint32_t pulses, uint32_t tick_ms); /*!< Optional, counter task: accepted pulses
+                                                                             and their tick (ms) */
+} counter_channel_config_t;
+
+/**
+ * @brief Publish a channel total (called from the counter task)
+ * @param index  Channel index in the table
+ * @param config Table row
+ * @param total  Total in units, rounded to 0.01 (converted from the pulse count for display)
+ * @param pulses Total pulses; exact total = pulses x micro_units_per_pulse / COUNTER_MICRO_PER_UNIT
+ */
+typedef void (*counter_channel_publish_cb_t)(size_t index, const counter_channel_config_t *config, float total,
+                                             uint32_t pulses);
+
+/**
+ * @brief Bind the table and load the totals (RTC cache, else NVS)
+ *
+ * Cheap and hardware-free, so it can run before the Zigbee clusters are created.
+ * The table must stay valid for the lifetime of the firmware.
+ */
+esp_err_t counter_channel_init(const counter_channel_config_t *table, size_t count);
+
+/**
+ * @brief Configure the inputs and start the counter task and flush timer
+ *
+ * Inputs count from here on, even while offline; reporting waits for
+ * counter_channel_set_online(true).
+ */
+esp_err_t counter_channel_start(counter_channel_publish_cb_t publish);
+
+/**
+ * @brief Gate attribute updates and the GPIO interrupts on the network state
+ *
+ * Going offline persists the pending totals.
+ */
+void counter_channel_set_online(bool online);
+
+/**
+ * @brief Queue a flush of one channel or COUNTER_CHANNEL_ALL
+ * @param force_nvs       Persist even if nothing changed since the last flush
+ * @param force_attribute Publish even if nothing changed since the last flush
+ */
+void counter_channel_request_flush(uint8_t index, bool force_nvs, bool force_attribute);
+
+/**
+ * @brief Replace a total (e.g. reset from the coordinator); applied and persisted by the counter task
+ *
+ * The total is stored as whole pulses, so it is rounded to a multiple of the calibration.
+ */
+void counter_channel_set_total(uint8_t index, float total);
+
+/**
+ * @brief Count one pulse that happened before the inputs were armed (wake edge from deep sleep)
+ *
+ * Call before counter_channel_start(). Persisted immediately.
+ */
+void counter_channel_count_wake_pulse(uint8_t index);
+
+/**
+ * @brief Current totals (pulses may be NULL)
+ */
+esp_err_t counter_channel_get_total(uint8_t index, float *total, uint32_t *pulses);
+
+/**
+ * @brief Exact total of a pulse count in 1e-6 units
+ */
+uint64_t counter_channel_micro_units(const counter_channel_config_t *config, uint32_t pulses);
+
+/**
+ * @brief Channel index of a Zigbee endpoint, -1 if none
+ */
+int counter_channel_find_endpoint(uint8_t endpoint);
+
+/**
+ * @brief Table row of a channel, NULL if out of range
+ */
+const counter_channel_config_t *counter_channel_get_config(uint8_t index);
+
+/**
+ * @brief Number of channels in the table
+ */
+size_t counter_channel_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COUNTER_CHANNEL_H */
@@ -0,0 +1,180 @@
+/*
+ * Counter Journal
+ *
+ * Design:
+ * - 32-byte records (sequence, format, value count, values, CRC) appended in order;
+ *   the partition is a ring of sectors and a sector is erased only when the write
+ *   position wraps into it, so the newest record always survives in the previous sector
+ * - The record body is programmed first and the CRC word last: a record counts only
+ *   once its CRC word is in flash, so a reset mid-write leaves the previous record valid
+ * - Boot scans every slot once for the highest valid sequence number; slots after it
+ *   that are not blank (torn write, stale data) are skipped up to the next sector
+ * - A flush is one ~32-byte flash program instead of an NVS entry rewrite + commit,
+ *   and one sector erase per 128 flushes instead of NVS page churn
+ */
+
+#include "counter_journal.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "COUNTER_JOURNAL";
+
+#define JOURNAL_FORMAT      1
+#define JOURNAL_SEQ_BLANK   0xFFFFFFFFU
+#define JOURNAL_SCAN_BATCH  16          // Records read per flash access during the boot scan
+
+typedef struct {
+    uint32_t seq;
+    uint8_t format;
+    uint8_t count;
+    uint16_t reserved;
+    uint32_t values[COUNTER_JOURNAL_VALUES];
+    uint32_t reserved2;
+    uint32_t crc;                       // Programmed last: commit marker
+} counter_journal_record_t;
+
+_Static_assert(sizeof(counter_journal_record_t) == 32, "journal record must stay 32 bytes");
+
+static const esp_partition_t *s_part;
+static uint32_t s_slots;                // Record slots in the partition
+static uint32_t s_slots_per_sector;
+static uint32_t s_next;                 // Next slot to program
+static uint32_t s_seq;                  // Sequence number of the next record
+static bool s_have_latest;
+static counter_journal_record_t s_latest;
+static uint32_t s_erases;               // Sector erases since boot (diagnostics)
+
+static uint32_t journal_crc(const counter_journal_record_t *rec)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)rec, offsetof(counter_journal_record_t, crc));
+}
+
+static bool journal_valid(const counter_journal_record_t *rec)
+{
+    return rec->seq != JOURNAL_SEQ_BLANK && rec->format == JOURNAL_FORMAT && rec->count <= COUNTER_JOURNAL_VALUES &&
+           rec->crc == journal_crc(rec);
+}
+
+static bool journal_blank(const counter_journal_record_t *rec)
+{
+    const uint32_t *words = (const uint32_t *)rec;
+    for (size_t i = 0; i < sizeof(*rec) / sizeof(uint32_t); i++) {
+        if (words[i] != 0xFFFFFFFFU) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t journal_read(uint32_t slot, counter_journal_record_t *rec, size_t n)
+{
+    return esp_partition_read(s_part, slot * sizeof(counter_journal_record_t), rec, n * sizeof(*rec));
+}
+
+esp_err_t counter_journal_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, COUNTER_JOURNAL_SUBTYPE, COUNTER_JOURNAL_LABEL);
+    if (s_part == NULL) {
+        ESP_LOGW(TAG, "⚠️ No '%s' partition - counter totals stay in NVS", COUNTER_JOURNAL_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_slots_per_sector = s_part->erase_size / sizeof(counter_journal_record_t);
+    s_slots = (s_part->size / s_part->erase_size) * s_slots_per_sector;
+    if (s_slots < 2 * s_slots_per_sector) {
+        ESP_LOGW(TAG, "⚠️ '%s' partition too small (%lu bytes) - counter totals stay in NVS",
+                 COUNTER_JOURNAL_LABEL, (unsigned long)s_part->size);
+        s_part = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* Newest valid record */
+    counter_journal_record_t batch[JOURNAL_SCAN_BATCH];
+    uint32_t latest_slot = 0;
+    s_have_latest = false;
+    for (uint32_t slot = 0; slot < s_slots; slot += JOURNAL_SCAN_BATCH) {
+        size_t n = s_slots - slot < JOURNAL_SCAN_BATCH ? s_slots - slot : JOURNAL_SCAN_BATCH;
+        if (journal_read(slot, batch, n) != ESP_OK) {
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (journal_valid(&batch[i]) && (!s_have_latest || batch[i].seq > s_latest.seq)) {
+                s_latest = batch[i];
+                latest_slot = slot + i;
+                s_have_latest = true;
+            }
+        }
+    }
+
+    /* Append after it, past anything that is not blank in the rest of its sector */
+    s_next = s_have_latest ? (latest_slot + 1) % s_slots : 0;
+    s_seq = s_have_latest ? s_latest.seq + 1 : 1;
+    while (s_next % s_slots_per_sector != 0) {
+        counter_journal_record_t rec;
+        if (journal_read(s_next, &rec, 1) == ESP_OK && journal_blank(&rec)) {
+            break;
+        }
+        s_next = (s_next + 1) % s_slots;
+    }
+
+    if (s_have_latest) {
+        ESP_LOGI(TAG, "📂 Journal: record #%lu at slot %lu/%lu", (unsigned long)s_latest.seq,
+                 (unsigned long)latest_slot, (unsigned long)s_slots);
+    } else {
+        ESP_LOGI(TAG, "📂 Journal empty (%lu slots)", (unsigned long)s_slots);
+    }
+    return ESP_OK;
+}
+
+bool counter_journal_available(void)
+{
+    return s_part != NULL;
+}
+
+esp_err_t counter_journal_latest(uint32_t *values, size_t max, size_t *count)
+{
+    ESP_RETURN_ON_FALSE(values && count, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (!s_have_latest) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *count = s_latest.count < max ? s_latest.count : max;
+    memcpy(values, s_latest.values, *count * sizeof(uint32_t));
+    return ESP_OK;
+}
+
+esp_err_t counter_journal_append(const uint32_t *values, size_t count)
+{
+    ESP_RETURN_ON_FALSE(s_part, ESP_ERR_INVALID_STATE, TAG, "journal not available");
+    ESP_RETURN_ON_FALSE(values && count <= COUNTER_JOURNAL_VALUES, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    size_t offset = s_next * sizeof(counter_journal_record_t);
+    if (s_next % s_slots_per_sector == 0) {
+        ESP_RETURN_ON_ERROR(esp_partition_erase_range(s_part, offset, s_part->erase_size), TAG,
+                            "Failed to erase sector at 0x%x", (unsigned)offset);
+        s_erases++;
+        ESP_LOGI(TAG, "🧹 Sector %lu erased (%lu erase(s) since boot)", (unsigned long)(s_next / s_slots_per_sector),
+                 (unsigned long)s_erases);
+    }
+
+    counter_journal_record_t rec;
+    memset(&rec, 0xFF, sizeof(rec));
+    rec.seq = s_seq;
+    rec.format = JOURNAL_FORMAT;
+    rec.count = (uint8_t)count;
+    memcpy(rec.values, values, count * sizeof(uint32_t));
+    rec.crc = journal_crc(&rec);
+
+    /* Body first, then the CRC word that commits it */
+    s_next = (s_next + 1) % s_slots;
+    ESP_RETURN_ON_ERROR(esp_partition_write(s_part, offset, &rec, offsetof(counter_journal_record_t, crc)), TAG,
+                        "Failed to write record #%lu", (unsigned long)rec.seq);
+    ESP_RETURN_ON_ERROR(esp_partition_write(s_part, offset + offsetof(counter_journal_record_t, crc), &rec.crc,
+                                            sizeof(rec.crc)), TAG, "Failed to commit record #%lu", (unsigned long)rec.seq);
+    s_seq++;
+    s_latest = rec;
+    s_have_latest = true;
+    return ESP_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * Counter Journal
+ * Append-only, wear-levelled log of counter totals on a dedicated data partition:
+ * fixed-size, sequence-numbered, CRC'd records, one flash sector erased per wrap
+ */
+
+#ifndef COUNTER_JOURNAL_H
+#define COUNTER_JOURNAL_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Partition holding the journal (partitions.csv: "counters, data, 0x40, ..., 0x4000") */
+#ifndef COUNTER_JOURNAL_LABEL
+#define COUNTER_JOURNAL_LABEL "counters"
+#endif
+
+#ifndef COUNTER_JOURNAL_SUBTYPE
+#define COUNTER_JOURNAL_SUBTYPE 0x40
+#endif
+
+/* Values per record (one per counter channel) */
+#define COUNTER_JOURNAL_VALUES 4
+
+/**
+ * @brief Find the partition and recover the newest valid record and the append position
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the partition table has no journal (NVS fallback)
+ */
+esp_err_t counter_journal_init(void);
+
+/**
+ * @brief true once counter_journal_init() found a usable partition
+ */
+bool counter_journal_available(void);
+
+/**
+ * @brief Values of the newest valid record
+ * @param values Output, up to max entries
+ * @param max    Capacity of values
+ * @param count  Output: values copied - the record's channel count (capped at max), which may
+ *               differ from the current table after a firmware change
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the journal is empty
+ */
+esp_err_t counter_journal_latest(uint32_t *values, size_t max, size_t *count);
+
+/**
+ * @brief Append a record (erases the next sector first when the write position enters it)
+ * @param values Values to store, count <= COUNTER_JOURNAL_VALUES
+ * @param count  Number of values
+ */
+esp_err_t counter_journal_append(const uint32_t *values, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COUNTER_JOURNAL_H */
@@ -0,0 +1,230 @@
+/*
+ * DS18B20 Temperature Probes
+ *
+ * Design:
+ * - Probes are addressed with Match ROM from an attached ROM table; with none attached
+ *   a single probe is addressed with Skip ROM
+ * - Split phase: one broadcast Convert T starts every probe, each result is collected
+ *   once the conversion time for the resolution has passed (no busy-wait on the bus)
+ * - Every scratchpad read is CRC-checked; a probe that lost power mid-cycle (power-on
+ *   config or 85 °C result) is reprogrammed and its value dropped
+ * - Resolution changes rewrite TH/TL from the scratchpad so alarm thresholds survive
+ */
+
+#include "ds18b20.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "DS18B20";
+
+// Function commands
+#define DS18B20_CMD_CONVERT_T        0x44
+#define DS18B20_CMD_WRITE_SCRATCHPAD 0x4E
+#define DS18B20_CMD_READ_SCRATCHPAD  0xBE
+
+// Scratchpad layout
+#define DS18B20_SP_TEMP_LSB 0
+#define DS18B20_SP_TEMP_MSB 1
+#define DS18B20_SP_TH       2
+#define DS18B20_SP_TL       3
+#define DS18B20_SP_CONFIG   4
+#define DS18B20_SP_CRC      8
+#define DS18B20_SP_LEN      9
+
+// Config register: R1:R0 in bits 6:5, remaining bits read as 1
+#define DS18B20_CONFIG(res) ((uint8_t)((((res) - 9) << 5) | 0x1F))
+
+// Temperature register after power-on (+85 °C), kept until a conversion completes
+#define DS18B20_POWER_ON_RAW 0x0550
+
+// 12-bit conversion takes 750 ms max; each bit less halves it
+#define DS18B20_TCONV_12BIT_US 750000
+
+_Static_assert(DS18B20_MAX_DEVICES <= 32, "s_uncollected holds one bit per probe");
+
+// Broadcast address for ds18b20_command()
+#define DS18B20_ALL SIZE_MAX
+
+static ds18b20_resolution_t s_resolution = DS18B20_RESOLUTION_12BIT;
+
+// Attached ROM IDs; s_count == 0 means a single probe addressed with Skip ROM
+static onewire_rom_t s_roms[DS18B20_MAX_DEVICES];
+static size_t s_count = 0;
+
+// Split-phase state: probes (bit = index) whose result has not been collected yet
+static uint32_t s_uncollected = 0;
+static int64_t s_start_us = 0;
+static uint32_t s_max_us = 0;
+
+static uint32_t ds18b20_conversion_time_us(ds18b20_resolution_t resolution)
+{
+    return DS18B20_TCONV_12BIT_US >> (DS18B20_RESOLUTION_12BIT - resolution);
+}
+
+/* Reset, ROM command (Skip ROM for DS18B20_ALL or single-probe mode, Match ROM + ID
+ * otherwise), function command and payload as one bus transaction */
+static esp_err_t ds18b20_command(size_t index, uint8_t cmd, const uint8_t *payload, size_t len)
+{
+    bool present = false;
+    ESP_RETURN_ON_ERROR(onewire_rmt_reset(&present), TAG, "reset failed");
+    if (!present) return ESP_ERR_NOT_FOUND;
+
+    uint8_t seq[1 + sizeof(onewire_rom_t) + 1 + 3];
+    size_t n = 0;
+    if (index == DS18B20_ALL || s_count == 0) {
+        seq[n++] = ONEWIRE_CMD_SKIP_ROM;
+    } else {
+        seq[n++] = ONEWIRE_CMD_MATCH_ROM;
+        memcpy(&seq[n], s_roms[index].id, sizeof(s_roms[index].id));
+        n += sizeof(s_roms[index].id);
+    }
+    seq[n++] = cmd;
+    if (len > sizeof(seq) - n) return ESP_ERR_INVALID_SIZE;
+    if (len) memcpy(&seq[n], payload, len);
+    return onewire_rmt_write_bytes(seq, n + len);
+}
+
+static esp_err_t ds18b20_read_scratchpad(size_t index, uint8_t sp[DS18B20_SP_LEN])
+{
+    ESP_RETURN_ON_ERROR(ds18b20_command(index, DS18B20_CMD_READ_SCRATCHPAD, NULL, 0), TAG, "read scratchpad failed");
+    ESP_RETURN_ON_ERROR(onewire_rmt_read_bytes(sp, DS18B20_SP_LEN), TAG, "scratchpad read failed");
+    if (onewire_crc8(sp, DS18B20_SP_LEN) != 0) {
+        ESP_LOGW(TAG, "Probe %u: scratchpad CRC mismatch", (unsigned)index);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ds18b20_configure(size_t index, ds18b20_resolution_t resolution)
+{
+    // Write Scratchpad always takes TH, TL and config: keep the stored alarm thresholds
+    uint8_t sp[DS18B20_SP_LEN];
+    ESP_RETURN_ON_ERROR(ds18b20_read_scratchpad(index, sp), TAG, "cannot read alarm thresholds");
+    const uint8_t payload[3] = { sp[DS18B20_SP_TH], sp[DS18B20_SP_TL], DS18B20_CONFIG(resolution) };
+    return ds18b20_command(index, DS18B20_CMD_WRITE_SCRATCHPAD, payload, sizeof(payload));
+}
+
+esp_err_t ds18b20_init(gpio_num_t gpio)
+{
+    s_uncollected = 0;
+    ESP_RETURN_ON_ERROR(onewire_rmt_init(gpio), TAG, "1-Wire bus init failed");
+
+    bool present = false;
+    ESP_RETURN_ON_ERROR(onewire_rmt_reset(&present), TAG, "reset failed");
+    return present ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t ds18b20_search(onewire_rom_t *roms, size_t max, size_t *out_count, bool alarm_only)
+{
+    if (!roms || !out_count) return ESP_ERR_INVALID_ARG;
+    *out_count = 0;
+
+    onewire_search_t search;
+    onewire_search_init(&search);
+    uint8_t cmd = alarm_only ? ONEWIRE_CMD_ALARM_SEARCH : ONEWIRE_CMD_SEARCH_ROM;
+    bool found = true;
+    while (found && *out_count < max) {
+        ESP_RETURN_ON_ERROR(onewire_rmt_search_next(&search, cmd, &found), TAG, "ROM search failed");
+        if (!found) break;
+        if (search.rom.id[0] != DS18B20_FAMILY_CODE) {
+            ESP_LOGD(TAG, "Skipping 1-Wire device of family 0x%02x", search.rom.id[0]);
+            continue;
+        }
+        roms[(*out_count)++] = search.rom;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_attach(const onewire_rom_t *roms, size_t count)
+{
+    if (count > DS18B20_MAX_DEVICES || (count && !roms)) return ESP_ERR_INVALID_ARG;
+    if (count) memcpy(s_roms, roms, count * sizeof(*roms));
+    s_count = count;
+    s_uncollected = 0;
+    return ESP_OK;
+}
+
+size_t ds18b20_get_count(void)
+{
+    return s_count ? s_count : 1;
+}
+
+esp_err_t ds18b20_set_resolution(ds18b20_resolution_t resolution)
+{
+    if (resolution < DS18B20_RESOLUTION_9BIT || resolution > DS18B20_RESOLUTION_12BIT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < ds18b20_get_count(); i++) {
+        esp_err_t r = ds18b20_configure(i, resolution);
+        if (r != ESP_OK) {
+            ESP_LOGW(TAG, "Probe %u: resolution not set (%s)", (unsigned)i, esp_err_to_name(r));
+            ret = r;
+        }
+    }
+
+    s_resolution = resolution;
+    ESP_LOGI(TAG, "Resolution %d-bit (%lu ms conversion)", resolution,
+             (unsigned long)(ds18b20_conversion_time_us(resolution) / 1000));
+    return ret;
+}
+
+esp_err_t ds18b20_start_conversion(uint32_t *out_max_us)
+{
+    // Skip ROM + Convert T starts every probe: one conversion window serves all of them
+    ESP_RETURN_ON_ERROR(ds18b20_command(DS18B20_ALL, DS18B20_CMD_CONVERT_T, NULL, 0), TAG, "Convert T failed");
+    s_uncollected = (1UL << ds18b20_get_count()) - 1;
+    s_start_us = esp_timer_get_time();
+    s_max_us = ds18b20_conversion_time_us(s_resolution);
+    if (out_max_us) *out_max_us = s_max_us;
+    return ESP_OK;
+}
+
+bool ds18b20_is_conversion_pending(void)
+{
+    return s_uncollected != 0;
+}
+
+bool ds18b20_is_conversion_ready(void)
+{
+    return s_uncollected != 0 && (esp_timer_get_time() - s_start_us) >= (int64_t)s_max_us;
+}
+
+esp_err_t ds18b20_collect(size_t index, float *out_temperature)
+{
+    if (!out_temperature || index >= ds18b20_get_count()) return ESP_ERR_INVALID_ARG;
+    if (!(s_uncollected & (1UL << index))) return ESP_ERR_INVALID_STATE;
+    if (!ds18b20_is_conversion_ready()) return ESP_ERR_NOT_FINISHED;
+    s_uncollected &= ~(1UL << index);
+
+    uint8_t sp[DS18B20_SP_LEN];
+    ESP_RETURN_ON_ERROR(ds18b20_read_scratchpad(index, sp), TAG, "collect failed");
+
+    // A brown-out restores the power-on config (12-bit): below 12 bits that differs from ours
+    if (sp[DS18B20_SP_CONFIG] != DS18B20_CONFIG(s_resolution)) {
+        ESP_LOGW(TAG, "Probe %u: config 0x%02x, expected 0x%02x - probe was reset, reprogramming", (unsigned)index,
+                 sp[DS18B20_SP_CONFIG], DS18B20_CONFIG(s_resolution));
+        ds18b20_configure(index, s_resolution);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    /* At 12 bits the power-on config equals ours, so a reset after our Convert T only
+     * shows as the power-on temperature. A real 85 °C is outside an outdoor probe's
+     * range: the value is dropped rather than reported */
+    int16_t raw = (int16_t)((sp[DS18B20_SP_TEMP_MSB] << 8) | sp[DS18B20_SP_TEMP_LSB]);
+    if (raw == DS18B20_POWER_ON_RAW) {
+        ESP_LOGW(TAG, "Probe %u: power-on value (85 °C) after a full conversion window - probe was reset",
+                 (unsigned)index);
+        ds18b20_configure(index, s_resolution);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // Below 12 bits the low bits are undefined
+    raw &= (int16_t)~((1 << (DS18B20_RESOLUTION_12BIT - s_resolution)) - 1);
+    *out_temperature = (float)raw * 0.0625f;
+    ESP_LOGD(TAG, "Probe %u: raw 0x%04x -> %.4f °C", (unsigned)index, (uint16_t)raw, *out_temperature);
+    return ESP_OK;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "onewire_rmt.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Probes that can share the bus (each is addressed with Match ROM)
+#ifndef DS18B20_MAX_DEVICES
+#define DS18B20_MAX_DEVICES 4
+#endif
+
+// Family code in byte 0 of every DS18B20 ROM ID
+#define DS18B20_FAMILY_CODE 0x28
+
+// Conversion resolution (config register R1:R0); conversion time doubles per bit
+typedef enum {
+    DS18B20_RESOLUTION_9BIT = 9,    // 0.5 °C, 93.75 ms max
+    DS18B20_RESOLUTION_10BIT = 10,  // 0.25 °C, 187.5 ms max
+    DS18B20_RESOLUTION_11BIT = 11,  // 0.125 °C, 375 ms max
+    DS18B20_RESOLUTION_12BIT = 12,  // 0.0625 °C, 750 ms max (power-on default)
+} ds18b20_resolution_t;
+
+// Set up the 1-Wire bus and check for a presence pulse. ESP_ERR_NOT_FOUND if nothing answers.
+// Until ds18b20_attach() is called with ROM IDs a single probe addressed by Skip ROM is assumed.
+esp_err_t ds18b20_init(gpio_num_t gpio);
+
+// Enumerate the DS18B20s on the bus (Search ROM, or Alarm Search with alarm_only).
+// Other device families are skipped. Returns ESP_OK if the search completed.
+esp_err_t ds18b20_search(onewire_rom_t *roms, size_t max, size_t *out_count, bool alarm_only);
+
+// Address the probes by ROM ID from now on; index i of the other calls is roms[i].
+// count 0 returns to the single-probe Skip ROM mode.
+esp_err_t ds18b20_attach(const onewire_rom_t *roms, size_t count);
+
+// Number of addressable probes (1 in Skip ROM mode)
+size_t ds18b20_get_count(void);
+
+// Program the resolution of every probe (scratchpad only, no EEPROM write).
+// Returns the last error if some probes could not be configured.
+esp_err_t ds18b20_set_resolution(ds18b20_resolution_t resolution);
+
+// Broadcast Convert T to all probes at once and return immediately. *out_max_us
+// (optional) receives the datasheet conversion time; results stay in the
+// scratchpads until collected.
+esp_err_t ds18b20_start_conversion(uint32_t *out_max_us);
+
+// True while some probe of the started conversion has not been collected
+bool ds18b20_is_conversion_pending(void);
+
+// True once the pending conversion has had its datasheet maximum time
+bool ds18b20_is_conversion_ready(void);
+
+// Read the scratchpad of probe `index` (CRC checked). Returns ESP_ERR_INVALID_STATE
+// if its result was already collected, ESP_ERR_NOT_FINISHED if it is too early,
+// ESP_ERR_INVALID_RESPONSE if the probe lost its configuration (power glitch).
+esp_err_t ds18b20_collect(size_t index, float *out_temperature);
@@ -0,0 +1,115 @@
+/*
+ * DS18B20 Probe Table
+ *
+ * Design:
+ * - One CRC-protected, versioned blob in NVS, same scheme as the sensor topology cache
+ * - Append-only: slots are never reordered, so endpoint N always shows the same probe
+ * - Written only when a search finds a probe that is not in the table yet
+ * - A factory reset (NVS erase) forgets the probes
+ */
+
+#include "ds18b20_roms.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "DS18B20_ROMS";
+static const char *NVS_NAMESPACE = "ds18b20";
+static const char *NVS_KEY = "roms";
+
+static uint32_t ds18b20_roms_crc(const ds18b20_rom_table_t *table)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)table, offsetof(ds18b20_rom_table_t, crc));
+}
+
+esp_err_t ds18b20_roms_load(ds18b20_rom_table_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    memset(out, 0, sizeof(*out));
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ds18b20_rom_table_t table;
+    size_t size = sizeof(table);
+    esp_err_t ret = nvs_get_blob(nvs_handle, NVS_KEY, &table, &size);
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK || size != sizeof(table)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (table.version != DS18B20_ROMS_VERSION) {
+        ESP_LOGW(TAG, "Probe table version %u != %u - ignoring", table.version, DS18B20_ROMS_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (table.crc != ds18b20_roms_crc(&table) || table.count > DS18B20_MAX_DEVICES) {
+        ESP_LOGW(TAG, "Probe table CRC mismatch - ignoring");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *out = table;
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_roms_save(ds18b20_rom_table_t *table)
+{
+    if (!table) return ESP_ERR_INVALID_ARG;
+
+    table->version = DS18B20_ROMS_VERSION;
+    table->reserved = 0;
+    table->crc = ds18b20_roms_crc(table);
+
+    ds18b20_rom_table_t stored;
+    if (ds18b20_roms_load(&stored) == ESP_OK && memcmp(&stored, table, sizeof(stored)) == 0) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_blob(nvs_handle, NVS_KEY, table, sizeof(*table));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "💾 Probe table saved (%u probe(s))", table->count);
+    } else {
+        ESP_LOGE(TAG, "Failed to store probe table: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+int ds18b20_roms_find(const ds18b20_rom_table_t *table, const onewire_rom_t *rom)
+{
+    for (uint8_t i = 0; i < table->count; i++) {
+        if (memcmp(table->rom[i].id, rom->id, sizeof(rom->id)) == 0) return i;
+    }
+    return -1;
+}
+
+bool ds18b20_roms_merge(ds18b20_rom_table_t *table, const onewire_rom_t *found, size_t count)
+{
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        if (ds18b20_roms_find(table, &found[i]) >= 0) continue;
+        if (table->count >= DS18B20_MAX_DEVICES) {
+            ESP_LOGW(TAG, "Probe table full (%d) - ignoring %02x%02x%02x%02x%02x%02x%02x%02x", DS18B20_MAX_DEVICES,
+                     found[i].id[7], found[i].id[6], found[i].id[5], found[i].id[4],
+                     found[i].id[3], found[i].id[2], found[i].id[1], found[i].id[0]);
+            continue;
+        }
+        table->rom[table->count++] = found[i];
+        changed = true;
+    }
+    return changed;
+}
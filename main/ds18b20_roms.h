@@ -0,0 +1,66 @@
+/*
+ * DS18B20 Probe Table
+ * Persisted ROM IDs of the probes on the 1-Wire bus; the slot of a probe
+ * selects its Zigbee endpoint, so the mapping survives reboots and probe swaps
+ */
+
+#ifndef DS18B20_ROMS_H
+#define DS18B20_ROMS_H
+
+#include "ds18b20.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bump whenever the layout or meaning of ds18b20_rom_table_t changes */
+#define DS18B20_ROMS_VERSION 1
+
+typedef struct {
+    uint16_t version;           // DS18B20_ROMS_VERSION
+    uint8_t  count;             // Used slots in rom[]
+    uint8_t  reserved;
+    onewire_rom_t rom[DS18B20_MAX_DEVICES];
+    uint32_t crc;               // CRC32 over all preceding bytes
+} ds18b20_rom_table_t;
+
+/**
+ * @brief Load the probe table from NVS
+ * @param out Destination table (emptied if nothing valid is stored)
+ * @return ESP_OK if a table with matching version and CRC was found
+ */
+esp_err_t ds18b20_roms_load(ds18b20_rom_table_t *out);
+
+/**
+ * @brief Store the probe table in NVS if it differs from the stored one
+ * @param table Table to store (version and CRC are filled in here)
+ * @return ESP_OK on success
+ */
+esp_err_t ds18b20_roms_save(ds18b20_rom_table_t *table);
+
+/**
+ * @brief Add newly discovered probes to free slots; known probes keep their slot,
+ *        probes missing from the bus keep theirs too (a loose connector must not
+ *        shift the other depths to different endpoints)
+ * @param table Table to update
+ * @param found ROM IDs found by the search
+ * @param count Entries in found
+ * @return true if the table changed
+ */
+bool ds18b20_roms_merge(ds18b20_rom_table_t *table, const onewire_rom_t *found, size_t count);
+
+/**
+ * @brief Slot of a ROM ID in the table
+ * @return Slot index, or -1 if the ROM is not in the table
+ */
+int ds18b20_roms_find(const ds18b20_rom_table_t *table, const onewire_rom_t *rom);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DS18B20_ROMS_H
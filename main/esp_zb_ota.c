@@ -16,7 +16,7 @@
 #include "freertos/task.h"
 #include "esp_timer.h"
 #include "esp_sleep.h"
-#include "esp_pm.h"
+#include "poll_control.h"
 
 static const char *TAG = "ESP_ZB_OTA";
 
@@ -26,8 +26,9 @@ static esp_zb_zcl_ota_upgrade_status_t ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRA
 /* OTA in progress flag - used to prevent sleep during transfer */
 static bool ota_transfer_active = false;
 
-/* Power Management lock to prevent CPU frequency scaling and sleep during OTA */
-static esp_pm_lock_handle_t ota_pm_lock = NULL;
+/* Fast polling follows the block transfer: every received block extends the window,
+ * so a stalled transfer falls back to long polling on its own */
+#define OTA_FAST_POLL_WINDOW_MS  30000
 
 /* OTA partition handle */
 static const esp_partition_t *update_partition = NULL;
@@ -42,17 +43,7 @@ esp_err_t esp_zb_ota_init(void)
 {
     ESP_LOGI(TAG, "Initializing Zigbee OTA");
     
-    /* Create Power Management lock to prevent sleep during OTA
-     * ESP_PM_NO_LIGHT_SLEEP prevents the device from entering light sleep,
-     * which would silence the UART console and potentially cause OTA timeouts */
-    esp_err_t ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "ota_no_sleep", &ota_pm_lock);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to create PM lock: %s (OTA will still work but console may go silent)", 
-                 esp_err_to_name(ret));
-        ota_pm_lock = NULL;  // Set to NULL so we know not to use it
-    } else {
-        ESP_LOGI(TAG, "✅ PM lock created - can prevent light sleep during OTA");
-    }
+    esp_err_t ret;
     
     // Get the currently running partition
     const esp_partition_t *running_partition = esp_ota_get_running_partition();
@@ -120,19 +111,11 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
              * via indirect transmission: the coordinator buffers frames and the device
              * polls to pick them up. Polling is driven by the sleep→wake cycle.
              *
-             * Instead, we acquire a PM lock (ESP_PM_NO_LIGHT_SLEEP) which prevents
-             * the CPU from entering light sleep. When the Zigbee stack calls
-             * esp_zb_sleep_now(), the sleep is a no-op and the stack "wakes up"
-             * immediately, polls the parent, and gets data — effectively fast polling.
-             * This keeps UART active for logging while maintaining the poll cycle. */
-            if (ota_pm_lock != NULL) {
-                ret = esp_pm_lock_acquire(ota_pm_lock);
-                if (ret == ESP_OK) {
-                    ESP_LOGI(TAG, "🔒 PM lock acquired - light sleep blocked, fast polling active");
-                } else {
-                    ESP_LOGW(TAG, "Failed to acquire PM lock: %s", esp_err_to_name(ret));
-                }
-            }
+             * Instead, we request Poll Control fast polling: the stack polls the
+             * parent at the short poll interval and still light-sleeps in between,
+             * so blocks are picked up quickly without keeping the CPU awake. */
+            poll_control_fast_poll(POLL_CONTROL_REASON_OTA, OTA_FAST_POLL_WINDOW_MS);
+            ESP_LOGI(TAG, "⚡ Fast polling active for the transfer");
 
             // Begin OTA update.
             // OTA_WITH_SEQUENTIAL_WRITES erases flash lazily (one sector at a time as
@@ -143,10 +126,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "❌ esp_ota_begin failed: %s", esp_err_to_name(ret));
                 ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
-                /* Release PM lock on error */
-                if (ota_pm_lock != NULL) {
-                    esp_pm_lock_release(ota_pm_lock);
-                }
+                poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
                 return ret;
             }
             ESP_LOGI(TAG, "✅ OTA write session started - ready to receive chunks (lazy erase enabled)");
@@ -193,6 +173,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             int64_t write_time_us = esp_timer_get_time() - write_start;
 
             total_received += message.payload_size;
+            poll_control_fast_poll(POLL_CONTROL_REASON_OTA, OTA_FAST_POLL_WINDOW_MS);
 
             ESP_LOGI(TAG, "Chunk written: %d bytes in %lld us. Progress: %ld/%ld (%.1f%%)",
                      write_len, write_time_us, total_received, total_image_size,
@@ -207,10 +188,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(ret));
                 ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
-                if (ota_pm_lock != NULL) {
-                    esp_pm_lock_release(ota_pm_lock);
-                    ESP_LOGW(TAG, "PM lock released after write error");
-                }
+                poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
                 ota_transfer_active = false;
                 return ret;
             }
@@ -225,11 +203,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(ret));
                 ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
-                /* CRITICAL: Release PM lock on error */
-                if (ota_pm_lock != NULL) {
-                    esp_pm_lock_release(ota_pm_lock);
-                    ESP_LOGW(TAG, "🔓 PM lock released after esp_ota_end error");
-                }
+                poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
 
 
                 ota_transfer_active = false;
@@ -243,11 +217,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to get new app description: %s", esp_err_to_name(ret));
                 ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
-                /* CRITICAL: Release PM lock on error */
-                if (ota_pm_lock != NULL) {
-                    esp_pm_lock_release(ota_pm_lock);
-                    ESP_LOGW(TAG, "🔓 PM lock released after partition description error");
-                }
+                poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
 
 
                 ota_transfer_active = false;
@@ -262,11 +232,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(ret));
                 ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
-                /* CRITICAL: Release PM lock on error */
-                if (ota_pm_lock != NULL) {
-                    esp_pm_lock_release(ota_pm_lock);
-                    ESP_LOGW(TAG, "🔓 PM lock released after set_boot_partition error");
-                }
+                poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
 
 
                 ota_transfer_active = false;
@@ -281,11 +247,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             /* Re-enable sleep before reboot (will be re-configured after reboot) */
             ota_transfer_active = false;
 
-            /* Release PM lock to allow normal power management */
-            if (ota_pm_lock != NULL) {
-                esp_pm_lock_release(ota_pm_lock);
-                ESP_LOGI(TAG, "🔓 PM lock released - light sleep re-enabled");
-            }
+            poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
             
             ESP_LOGI(TAG, "Rebooting in 3 seconds...");
             
@@ -321,11 +283,7 @@ esp_err_t zb_ota_upgrade_value_handler(esp_zb_zcl_ota_upgrade_value_message_t me
             ota_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
             ota_transfer_active = false;
 
-            /* Release PM lock to allow normal power management */
-            if (ota_pm_lock != NULL) {
-                esp_pm_lock_release(ota_pm_lock);
-                ESP_LOGI(TAG, "🔓 PM lock released - light sleep re-enabled");
-            }
+            poll_control_fast_poll_stop(POLL_CONTROL_REASON_OTA);
 
             // Abort OTA if it was started
             if (update_handle) {
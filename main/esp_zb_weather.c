@@ -24,22 +24,33 @@
 #include "driver/gpio.h"
 #include "bme280_app.h"
 #include "sensor_if.h"
+#include "sensor_profile.h"
+#include "sensor_oversample.h"
+#include "ds18b20.h"
+#include "ds18b20_roms.h"
+#include "battery.h"
+#include "counter_channel.h"
+#include "rain_rate.h"
+#include "attr_queue.h"
+#include "report_policy.h"
+#include "poll_control.h"
 #include "i2c_bus.h"
 #include "nvs.h"
 #include "weather_driver.h"
-#include "esp_adc/adc_oneshot.h"
-#include "esp_adc/adc_cali.h"
-#include "esp_adc/adc_cali_scheme.h"
 #include "esp_ota_ops.h"
 #include "esp_app_format.h"
 #include "esp_timer.h"
 #include "esp_pm.h"
 #include "esp_sleep.h"
 #include "esp_rom_uart.h"
-#include "driver/rmt_tx.h"
-#include "driver/rmt_rx.h"
+#include "esp_rom_crc.h"
+#include "esp_attr.h"
 /* Generated header with FW_VERSION / FW_DATE_CODE - created at configure time */
 #include "version.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* OTA upgrade running versions */
 #ifndef OTA_UPGRADE_RUNNING_FILE_VERSION
@@ -53,8 +64,8 @@
 #error Define ZB_ED_ROLE in idf.py menuconfig to compile Weather Station (End Device) source code.
 #endif
 
-/* Zigbee Sleepy End Device (SED) configuration */
-#define ZIGBEE_KEEP_ALIVE_MS        7500    // Keep-alive poll interval (7.5 seconds)
+/* Zigbee Sleepy End Device (SED) configuration
+ * The keep-alive (long poll) interval is the Poll Control LongPollInterval, see poll_control.h */
 #define ZIGBEE_SLEEP_THRESHOLD_MS   6000    // Idle time before sleep signal (6 seconds)
 #define ZIGBEE_ED_TIMEOUT           ESP_ZB_ED_AGING_TIMEOUT_64MIN  // Parent timeout
 
@@ -73,15 +84,25 @@ static const char *TAG = "WEATHER_STATION";
 /* Network connection status - declared early for LED functions */
 static bool zigbee_network_connected = false;
 
-/* Sleep prevention during initial configuration
- * Prevents device from sleeping for 60 seconds after joining network
- * This gives coordinator (Z2M) time to configure reporting without interruption.
- * IMPORTANT: We use a PM lock instead of skipping esp_zb_sleep_now() — the Zigbee
- * stack requires that esp_zb_sleep_now() is ALWAYS called on CAN_SLEEP, otherwise
- * the internal critical section nesting becomes unbalanced and causes a crash. */
-static int64_t network_join_time_us = 0;
-static esp_pm_lock_handle_t config_pm_lock = NULL;
-#define INITIAL_CONFIG_DELAY_SEC 60  // Wait 60 seconds before allowing sleep after join
+/* Fast polling during initial configuration
+ * After joining the device polls its parent at the Poll Control short poll interval,
+ * so the coordinator (Z2M) can interview and configure reporting without waiting a
+ * long poll per frame. Light sleep between polls stays allowed. The window follows
+ * the configuration traffic (Basic cluster access, Configure Reporting and bind
+ * exchanges) and closes once it has been quiet for CONFIG_WINDOW_IDLE_MS; a rejoin
+ * without interview ends after a few seconds instead of a full minute. */
+#define INITIAL_CONFIG_DELAY_SEC 60     // Upper bound of the fast-poll window after join
+#define CONFIG_WINDOW_IDLE_MS    5000   // Quiet time that ends the window
+static bool config_window_active = false;
+static int64_t config_window_start_us = 0;
+static int64_t config_window_last_us = 0;
+static uint16_t config_window_events = 0;
+
+/* Frames that count as configuration traffic (checked on the raw APS payload) */
+#define CONFIG_ZDO_BIND_REQ          0x0021  // ZDO Bind_req / Unbind_req
+#define CONFIG_ZDO_UNBIND_REQ        0x0022
+#define CONFIG_ZCL_CMD_CONFIG_REPORT 0x06    // Profile-wide Configure Reporting
+#define CONFIG_ZCL_CMD_READ_REPORT   0x08    // Profile-wide Read Reporting Configuration
 
 /* LED is used only during boot/join process:
  * - Blink yellow/orange during network joining
@@ -204,62 +225,71 @@ static void debug_led_blink_red(void)
 #define RAIN_GAUGE_GPIO         12              // GPIO pin for rain gauge reed switch
 #define RAIN_MM_PER_PULSE       0.36f           // mm of rain per bucket tip (adjust for your sensor)
 
-typedef enum {
-    RAIN_EVENT_PULSE = 0,
-    RAIN_EVENT_FLUSH,
-} rain_event_type_t;
-
-/* Rain gauge queue event */
-typedef struct {
-    rain_event_type_t type;
-    TickType_t tick;
-    bool force_nvs;
-    bool force_attribute;
-} rain_evt_t;
-
 /* Pulse counter configuration (GPIO13) */
 #define PULSE_COUNTER_GPIO      13              // GPIO pin for pulse counter input
 #define PULSE_COUNTER_VALUE     1.0f            // Value per pulse (can be adjusted)
 
-typedef enum {
-    PULSE_EVENT_PULSE = 0,
-    PULSE_EVENT_FLUSH,
-} pulse_event_type_t;
-
-/* Pulse counter queue event */
-typedef struct {
-    pulse_event_type_t type;
-    TickType_t tick;
-    bool force_nvs;
-    bool force_attribute;
-} pulse_evt_t;
-
-static QueueHandle_t rain_gauge_evt_queue = NULL;
-static float total_rainfall_mm = 0.0f;
-static uint32_t rain_pulse_count = 0;
-static const char *RAIN_TAG = "RAIN_GAUGE";
-static bool rain_gauge_enabled = false;  // Only enable when connected to network
-static bool rain_gauge_isr_installed = false;  // Track ISR installation state
-static esp_timer_handle_t rain_flush_timer = NULL;
-
-/* Pulse counter variables (GPIO13) */
-static QueueHandle_t pulse_counter_evt_queue = NULL;
-static float total_pulse_count_value = 0.0f;
-static uint32_t pulse_counter_count = 0;
-static const char *PULSE_TAG = "PULSE_COUNTER";
-static bool pulse_counter_enabled = false;  // Only enable when connected to network
-static bool pulse_counter_isr_installed = false;  // Track ISR installation state
-static esp_timer_handle_t pulse_flush_timer = NULL;
-
-/* DS18B20 temperature sensor (GPIO24) */
+/* Counter channels: one row per pulse input, served by the counter_channel task.
+ * NVS namespaces/keys are the ones earlier firmware used, so totals survive the update. */
+enum {
+    COUNTER_RAIN = 0,
+    COUNTER_PULSE,
+};
+
+static void rain_tips_recorded(size_t index, uint32_t tips, uint32_t tick_ms);
+
+static const counter_channel_config_t counter_channels[] = {
+    [COUNTER_RAIN] = {
+        .name = "RAIN_GAUGE",
+        .gpio = RAIN_GAUGE_GPIO,
+        .micro_units_per_pulse = COUNTER_MICRO_UNITS(RAIN_MM_PER_PULSE),
+        .debounce_ms = 200,
+        .use_pcnt = RAIN_GAUGE_USE_PCNT,
+        .pcnt_threshold = COUNTER_FLUSH_THRESHOLD,
+        .endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT,
+        .reportable_change = 0.3f,                  // Report when rain changes by 0.3mm
+        .description = "\x0E""Rainfall Total",      // Length-prefixed: 14 bytes + "Rainfall Total"
+        .metering_unit = 0x07,                      // Litres (1 mm of rain = 1 L/m²)
+        .metering_device_type = 0x02,               // Water metering
+        .nvs_namespace = "rain_storage",
+        .nvs_value_key = "rainfall",
+        .nvs_count_key = "pulses",
+        .on_pulses = rain_tips_recorded,            // Feeds the rain rate window
+    },
+    [COUNTER_PULSE] = {
+        .name = "PULSE_COUNTER",
+        .gpio = PULSE_COUNTER_GPIO,
+        .micro_units_per_pulse = COUNTER_MICRO_UNITS(PULSE_COUNTER_VALUE),
+        .debounce_ms = 200,
+        .use_pcnt = PULSE_COUNTER_USE_PCNT,
+        .pcnt_threshold = PULSE_COUNTER_PCNT_THRESHOLD,
+        .endpoint = HA_ESP_PULSE_COUNTER_ENDPOINT,
+        .reportable_change = 1.0f,                  // Report when pulse count changes by 1
+        .description = "\x0D""Pulse Counter",       // Length-prefixed: 13 bytes + "Pulse Counter"
+        .metering_unit = 0x0B,                      // Unitless: whatever the connected meter counts
+        .metering_device_type = 0x00,               // ZCL default (electric); set it to the connected meter
+        .nvs_namespace = "pulse_storage",
+        .nvs_value_key = "pulse_val",
+        .nvs_count_key = "pulse_cnt",
+    },
+};
+
+/* DS18B20 temperature probes (GPIO24, multi-drop) */
 static const char *DS18B20_TAG = "DS18B20";
-static float ds18b20_last_temp = 0.0f;
+static ds18b20_rom_table_t ds18b20_probes;           // Persisted ROM IDs: slot i -> endpoint HA_ESP_DS18B20_ENDPOINT + i
+static uint8_t ds18b20_endpoint_count = 1;           // Probe endpoints created at stack start
+static uint32_t ds18b20_present_mask = 0;            // Slots answering on the bus this boot
+static float ds18b20_last_temp[DS18B20_MAX_DEVICES] = { 0 };
+
+/* Each probe needs its own report policy state (channel = probe slot) */
+_Static_assert(REPORT_POLICY_CHANNELS >= DS18B20_MAX_DEVICES, "REPORT_POLICY_CHANNELS must cover every DS18B20 slot");
 static bool ds18b20_available = false;
 
+/* Last onboard sensor temperature, used for battery SoC compensation */
+static float board_temperature_c = NAN;
+
 /* Periodic sensor reading interval (5 minutes as per requirements) */
 #define PERIODIC_READING_INTERVAL_MS (5 * 60 * 1000ULL)  // 5 minutes in milliseconds
-#define RAIN_PULSE_FLUSH_THRESHOLD   10U
-#define RAIN_FLUSH_INTERVAL_US       (10ULL * 1000ULL * 1000ULL) // 10 seconds
 static esp_timer_handle_t periodic_report_timer = NULL;
 
 /* Heartbeat logging for debugging - logs every 30 minutes to prove device is alive */
@@ -270,6 +300,12 @@ static esp_timer_handle_t heartbeat_timer = NULL;
 static QueueHandle_t sensor_read_queue = NULL;
 static TaskHandle_t sensor_read_task_handle = NULL;
 
+/* sensor_read_queue items */
+#define SENSOR_TRIGGER_REPORT     1   // Full read of all sensors and attribute update
+#define SENSOR_TRIGGER_SUBSAMPLE  2   // Environmental sample into the oversampling ring only
+#define SENSOR_TRIGGER_DS18B20    3   // Pipelined DS18B20 conversion finished: read and report
+static volatile bool sensor_subsample_queued = false;
+
 /* Network connection status (zigbee_network_connected declared earlier for LED functions) */
 static uint32_t connection_retry_count = 0;
 #define NETWORK_RETRY_SLEEP_DURATION    30      // 30 seconds for network retry
@@ -293,21 +329,6 @@ static uint32_t get_backoff_delay_ms(void)
     return delay;
 }
 
-/* Ensure shared GPIO ISR service exists before adding any handler.
- * This avoids boot-time failures when a deferred init path partially fails.
- */
-static bool ensure_gpio_isr_service_installed(const char *subsystem_tag, const char *subsystem_name)
-{
-    esp_err_t isr_ret = gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
-    if (isr_ret == ESP_OK || isr_ret == ESP_ERR_INVALID_STATE) {
-        return true;
-    }
-
-    ESP_LOGE(subsystem_tag, "Failed to install GPIO ISR service for %s: %s",
-             subsystem_name, esp_err_to_name(isr_ret));
-    return false;
-}
-
 /* Button action tracking (no state needed for action-based buttons) */
 
 /********************* Define functions **************************/
@@ -320,25 +341,14 @@ static void periodic_sensor_report_callback(void *arg);
 static void heartbeat_callback(void *arg);
 static void start_periodic_reading(void);
 static void stop_periodic_reading(void);
-static void rain_gauge_init(void);
-static void rain_gauge_isr_handler(void *arg);
-static void rain_gauge_task(void *arg);
-static void rain_flush_timer_callback(void *arg);
-static void rain_gauge_request_flush(bool force_nvs, bool force_attribute);
-static void rain_gauge_flush_totals(bool save_to_nvs, bool update_attribute);
-static void rain_gauge_enable_isr(void);
-static void rain_gauge_disable_isr(void);
-static void pulse_counter_init(void);
-static void pulse_counter_isr_handler(void *arg);
-static void pulse_counter_task(void *arg);
-static void pulse_flush_timer_callback(void *arg);
-static void pulse_counter_request_flush(bool force_nvs, bool force_attribute);
-static void pulse_counter_flush_totals(bool save_to_nvs, bool update_attribute);
-static void pulse_counter_enable_isr(void);
-static void pulse_counter_disable_isr(void);
-static void ds18b20_init(void);
+static void counter_publish(size_t index, const counter_channel_config_t *ch, float total, uint32_t pulses);
+static void configure_policy_reporting(uint8_t param);
+static esp_zb_uint48_t counter_summation(const counter_channel_config_t *ch, uint32_t pulses);
+static uint16_t rain_rate_to_zb(float mm_h);
+static void rain_rate_report(void);
+static void ds18b20_setup(void);
+static void ds18b20_start_pipelined(void);
 static void ds18b20_read_and_report(uint8_t param);
-static esp_err_t battery_adc_init(void);
 static void battery_read_and_report(uint8_t param);
 static esp_err_t deferred_driver_init(void)
 {
@@ -363,37 +373,35 @@ static esp_err_t deferred_driver_init(void)
         ESP_LOGE(TAG, "Failed to create I2C bus");
         return ESP_FAIL;
     }
+    /* Sensor layer owns the bus from here on; it recreates it during bus recovery */
+    sensor_set_bus_config(I2C_NUM_0, &i2c_cfg);
     
-    /* Initialize sensor layer: prefer BME280; if not present, try AHT20 + BMP280 combo */
+    /* Initialize sensor layer: every registered driver whose chip answers is used,
+     * each channel is served by the best chip present */
     esp_err_t ret = sensor_init(i2c_bus);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "No supported environmental sensor found on I2C bus (ret=%s) - continuing without sensors", esp_err_to_name(ret));
     } else {
-        sensor_type_t st = sensor_get_type();
-        if (st == SENSOR_TYPE_BME280) {
-            ESP_LOGI(TAG, "Detected BME280 sensor on ESP32-H2 (SDA:GPIO10, SCL:GPIO11)");
-        } else if (st == SENSOR_TYPE_AHT20_BMP280) {
-            ESP_LOGI(TAG, "Detected AHT20 + BMP280 sensor combo on ESP32-H2 (SDA:GPIO10, SCL:GPIO11)");
-        } else {
-            ESP_LOGI(TAG, "Sensor layer initialized (unknown type=%d)", st);
-        }
+        ESP_LOGI(TAG, "Detected %s on ESP32-H2 (SDA:GPIO10, SCL:GPIO11)", sensor_get_description());
     }
     
-    /* Initialize rain gauge */
-    rain_gauge_init();
-    
-    /* Initialize pulse counter (GPIO13) */
-    pulse_counter_init();
+    /* Samples from before this boot cannot be time-aligned with esp_timer */
+    sensor_oversample_reset();
     
-    /* Initialize DS18B20 temperature sensor (GPIO24) */
-    ds18b20_init();
+    /* Count the rain tip that woke the chip before the input is armed */
+    if (check_wake_reason() == WAKE_REASON_RAIN) {
+        counter_channel_count_wake_pulse(COUNTER_RAIN);
+    }
     
-    /* Initialize battery ADC */
-    ret = battery_adc_init();
+    /* Start rain gauge (GPIO12) and pulse counter (GPIO13): one task, queue and flush timer */
+    ret = counter_channel_start(counter_publish);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Battery ADC initialization failed, will use simulated values");
+        ESP_LOGE(TAG, "Failed to start counter channels: %s", esp_err_to_name(ret));
     }
     
+    /* Initialize DS18B20 temperature sensor (GPIO24) */
+    ds18b20_setup();
+    
     return ESP_OK;
 }
 
@@ -432,6 +440,93 @@ static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
     ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, , TAG, "Failed to start Zigbee commissioning");
 }
 
+/* Close the configuration window once its traffic has gone quiet (or the cap is reached) */
+static void config_window_check(uint8_t param)
+{
+    (void)param;  // Unused
+    if (!config_window_active) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    int64_t quiet_ms = (now - config_window_last_us) / 1000;
+    int64_t open_ms = (now - config_window_start_us) / 1000;
+    const int64_t cap_ms = INITIAL_CONFIG_DELAY_SEC * 1000LL;
+    if (quiet_ms < CONFIG_WINDOW_IDLE_MS && open_ms < cap_ms) {
+        // Next check at the end of the quiet time, but never past the cap
+        int64_t next_ms = CONFIG_WINDOW_IDLE_MS - quiet_ms;
+        if (next_ms > cap_ms - open_ms) {
+            next_ms = cap_ms - open_ms;
+        }
+        esp_zb_scheduler_alarm((esp_zb_callback_t)config_window_check, 0, (uint32_t)next_ms);
+        return;
+    }
+    config_window_active = false;
+    poll_control_fast_poll_stop(POLL_CONTROL_REASON_JOIN);
+    ESP_LOGI(TAG, "Initial config window closed after %lld ms (%u configuration frames, %s)", open_ms,
+             config_window_events, quiet_ms >= CONFIG_WINDOW_IDLE_MS ? "traffic quiet" : "time limit");
+}
+
+/* Join: fast-poll until the interview and configuration traffic stops */
+static void config_window_open(void)
+{
+    config_window_active = true;
+    config_window_start_us = esp_timer_get_time();
+    config_window_last_us = config_window_start_us;
+    config_window_events = 0;
+    poll_control_fast_poll(POLL_CONTROL_REASON_JOIN, INITIAL_CONFIG_DELAY_SEC * 1000U);
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)config_window_check, 0);
+    esp_zb_scheduler_alarm((esp_zb_callback_t)config_window_check, 0, CONFIG_WINDOW_IDLE_MS);
+    ESP_LOGI(TAG, "Fast polling for initial config (until %d ms quiet, at most %d s)", CONFIG_WINDOW_IDLE_MS,
+             INITIAL_CONFIG_DELAY_SEC);
+}
+
+/* Configuration traffic seen: keep the window open */
+static void config_window_activity(const char *what)
+{
+    if (!config_window_active) {
+        return;
+    }
+    config_window_last_us = esp_timer_get_time();
+    config_window_events++;
+    ESP_LOGD(TAG, "Config traffic: %s", what);
+}
+
+/* ZCL profile-wide command id of an APS payload, -1 for cluster-specific or short frames */
+static int config_window_zcl_global_cmd(const esp_zb_apsde_data_ind_t *ind)
+{
+    if (ind->asdu == NULL || ind->asdu_length < 3 || (ind->asdu[0] & 0x03) != 0x00) {
+        return -1;
+    }
+    // Frame control, [manufacturer code,] sequence number, command id
+    size_t cmd_offset = (ind->asdu[0] & 0x04) ? 4 : 2;
+    return cmd_offset < ind->asdu_length ? ind->asdu[cmd_offset] : -1;
+}
+
+/* Coordinator configuration frames keep the window open: Basic cluster access (interview),
+ * Configure Reporting and bind requests. Other traffic (e.g. default responses, reads of
+ * measured values) does not; the frame is always left to the stack */
+static bool config_window_aps_indication(esp_zb_apsde_data_ind_t ind)
+{
+    if (!config_window_active || ind.src_short_addr != 0x0000) {
+        return false;
+    }
+    if (ind.profile_id == 0x0000) {
+        if (ind.cluster_id == CONFIG_ZDO_BIND_REQ || ind.cluster_id == CONFIG_ZDO_UNBIND_REQ) {
+            config_window_activity("bind request");
+        }
+        return false;
+    }
+    if (ind.cluster_id == ESP_ZB_ZCL_CLUSTER_ID_BASIC) {
+        config_window_activity("Basic cluster access");
+        return false;
+    }
+    int cmd = config_window_zcl_global_cmd(&ind);
+    if (cmd == CONFIG_ZCL_CMD_CONFIG_REPORT || cmd == CONFIG_ZCL_CMD_READ_REPORT) {
+        config_window_activity("configure reporting");
+    }
+    return false;
+}
+
 /**
  * @brief Configure local reporting for analog input endpoints (EP2 and EP3)
  * 
@@ -450,6 +545,7 @@ static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
 static void bind_req_cb(esp_zb_zdp_status_t zdo_status, void *user_ctx)
 {
     const char *endpoint_name = (const char *)user_ctx;
+    config_window_activity("bind response");
     if (zdo_status == ESP_ZB_ZDP_STATUS_SUCCESS) {
         ESP_LOGI(TAG, "✅ Binding created for %s analog input cluster", endpoint_name);
     } else {
@@ -483,79 +579,159 @@ static void configure_analog_input_reporting(uint8_t param)
     esp_zb_ieee_addr_t our_ieee;
     esp_zb_get_long_address(our_ieee);
     
-    /* Create binding for EP2 (rain gauge) */
-    esp_zb_zdo_bind_req_param_t rain_bind_req = {0};
-    rain_bind_req.req_dst_addr = esp_zb_get_short_address();  // Send bind request to ourselves
-    memcpy(rain_bind_req.src_address, our_ieee, sizeof(esp_zb_ieee_addr_t));
-    rain_bind_req.src_endp = HA_ESP_RAIN_GAUGE_ENDPOINT;
-    rain_bind_req.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-    rain_bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
-    memcpy(rain_bind_req.dst_address_u.addr_long, coordinator_ieee, sizeof(esp_zb_ieee_addr_t));
-    rain_bind_req.dst_endp = 1;  // Coordinator endpoint
-    
-    esp_zb_zdo_device_bind_req(&rain_bind_req, bind_req_cb, (void*)"rain gauge");
-    
-    /* Create binding for EP3 (pulse counter) */
-    esp_zb_zdo_bind_req_param_t pulse_bind_req = {0};
-    pulse_bind_req.req_dst_addr = esp_zb_get_short_address();  // Send bind request to ourselves
-    memcpy(pulse_bind_req.src_address, our_ieee, sizeof(esp_zb_ieee_addr_t));
-    pulse_bind_req.src_endp = HA_ESP_PULSE_COUNTER_ENDPOINT;
-    pulse_bind_req.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-    pulse_bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
-    memcpy(pulse_bind_req.dst_address_u.addr_long, coordinator_ieee, sizeof(esp_zb_ieee_addr_t));
-    pulse_bind_req.dst_endp = 1;  // Coordinator endpoint
-    
-    esp_zb_zdo_device_bind_req(&pulse_bind_req, bind_req_cb, (void*)"pulse counter");
-    
-    /* Reportable change threshold for float values */
-    float rain_reportable_change = 0.3f;    // Report when rain changes by 0.3mm 
-    float pulse_reportable_change = 1.0f;   // Report when pulse count changes by 1
-    
-    /* Configure reporting for EP2 (rain gauge) */
-    esp_zb_zcl_config_report_cmd_t rain_report_cmd = {0};
-    rain_report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = esp_zb_get_short_address();  // Send to self
-    rain_report_cmd.zcl_basic_cmd.dst_endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT;
-    rain_report_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT;
-    rain_report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
-    rain_report_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-    
-    esp_zb_zcl_config_report_record_t rain_record = {
-        .direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
-        .attributeID = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
-        .attrType = ESP_ZB_ZCL_ATTR_TYPE_SINGLE,  // Float type
-        .min_interval = 0,      // No minimum interval - report immediately on change
-        .max_interval = 3600,   // Report at least every hour even if no change
-        .reportable_change = &rain_reportable_change,
-    };
-    rain_report_cmd.record_number = 1;
-    rain_report_cmd.record_field = &rain_record;
-    
-    // Called from Zigbee scheduler alarm - no lock needed (already in Zigbee task context)
-    esp_zb_zcl_config_report_cmd_req(&rain_report_cmd);
-    ESP_LOGI(RAIN_TAG, "📋 Rain gauge reporting configured: change=%.1f mm, max_interval=3600s", rain_reportable_change);
-
-    /* Configure reporting for EP3 (pulse counter) */
-    esp_zb_zcl_config_report_cmd_t pulse_report_cmd = {0};
-    pulse_report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = esp_zb_get_short_address();  // Send to self
-    pulse_report_cmd.zcl_basic_cmd.dst_endpoint = HA_ESP_PULSE_COUNTER_ENDPOINT;
-    pulse_report_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_PULSE_COUNTER_ENDPOINT;
-    pulse_report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
-    pulse_report_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-
-    esp_zb_zcl_config_report_record_t pulse_record = {
+    for (size_t i = 0; i < counter_channel_count(); i++) {
+        const counter_channel_config_t *ch = counter_channel_get_config(i);
+
+        /* Bind the channel's analog input to the coordinator */
+        esp_zb_zdo_bind_req_param_t bind_req = {0};
+        bind_req.req_dst_addr = esp_zb_get_short_address();  // Send bind request to ourselves
+        memcpy(bind_req.src_address, our_ieee, sizeof(esp_zb_ieee_addr_t));
+        bind_req.src_endp = ch->endpoint;
+        bind_req.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
+        bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
+        memcpy(bind_req.dst_address_u.addr_long, coordinator_ieee, sizeof(esp_zb_ieee_addr_t));
+        bind_req.dst_endp = 1;  // Coordinator endpoint
+
+        esp_zb_zdo_device_bind_req(&bind_req, bind_req_cb, (void *)ch->name);
+
+        /* Reportable change threshold for float values (from the channel table) */
+        float reportable_change = ch->reportable_change;
+
+        esp_zb_zcl_config_report_cmd_t report_cmd = {0};
+        report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = esp_zb_get_short_address();  // Send to self
+        report_cmd.zcl_basic_cmd.dst_endpoint = ch->endpoint;
+        report_cmd.zcl_basic_cmd.src_endpoint = ch->endpoint;
+        report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        report_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
+
+        esp_zb_zcl_config_report_record_t record = {
+            .direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
+            .attributeID = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
+            .attrType = ESP_ZB_ZCL_ATTR_TYPE_SINGLE,  // Float type
+            .min_interval = 0,      // No minimum interval - report immediately on change
+            .max_interval = 3600,   // Report at least every hour even if no change
+            .reportable_change = &reportable_change,
+        };
+        report_cmd.record_number = 1;
+        report_cmd.record_field = &record;
+
+        // Called from Zigbee scheduler alarm - no lock needed (already in Zigbee task context)
+        esp_zb_zcl_config_report_cmd_req(&report_cmd);
+        ESP_LOGI(ch->name, "📋 EP%u reporting configured: change=%.2f, max_interval=3600s", ch->endpoint, reportable_change);
+
+        /* Same total as an exact uint48 summation (Metering, 1e-6 units) */
+        bind_req.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING;
+        esp_zb_zdo_device_bind_req(&bind_req, bind_req_cb, (void *)ch->name);
+
+        uint64_t summation_change = (uint64_t)llroundf(reportable_change * COUNTER_MICRO_PER_UNIT);
+        esp_zb_uint48_t summation_reportable_change = {
+            .low = (uint32_t)summation_change,
+            .high = (uint16_t)(summation_change >> 32),
+        };
+        esp_zb_zcl_config_report_record_t summation_record = {
+            .direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
+            .attributeID = ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
+            .attrType = ESP_ZB_ZCL_ATTR_TYPE_U48,
+            .min_interval = 0,
+            .max_interval = 3600,
+            .reportable_change = &summation_reportable_change,
+        };
+        report_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_METERING;
+        report_cmd.record_field = &summation_record;
+        esp_zb_zcl_config_report_cmd_req(&report_cmd);
+    }
+
+    /* Rain rate cluster on EP2: the firmware only moves these attributes on an intensity
+     * change, so any change (1 = 0.1 mm/h) is reported immediately */
+    esp_zb_zdo_bind_req_param_t rate_bind_req = {0};
+    rate_bind_req.req_dst_addr = esp_zb_get_short_address();
+    memcpy(rate_bind_req.src_address, our_ieee, sizeof(esp_zb_ieee_addr_t));
+    rate_bind_req.src_endp = HA_ESP_RAIN_GAUGE_ENDPOINT;
+    rate_bind_req.cluster_id = CAELUM_RAIN_RATE_CLUSTER_ID;
+    rate_bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
+    memcpy(rate_bind_req.dst_address_u.addr_long, coordinator_ieee, sizeof(esp_zb_ieee_addr_t));
+    rate_bind_req.dst_endp = 1;
+    esp_zb_zdo_device_bind_req(&rate_bind_req, bind_req_cb, (void *)"rain rate");
+
+    uint16_t rate_change = 1;
+    esp_zb_zcl_config_report_record_t rate_records[3];
+    const uint16_t rate_attrs[3] = { CAELUM_ATTR_RAIN_RATE, CAELUM_ATTR_RAIN_RATE_10MIN, CAELUM_ATTR_RAIN_RATE_1H };
+    for (int i = 0; i < 3; i++) {
+        rate_records[i] = (esp_zb_zcl_config_report_record_t) {
+            .direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
+            .attributeID = rate_attrs[i],
+            .attrType = ESP_ZB_ZCL_ATTR_TYPE_U16,
+            .min_interval = 0,
+            .max_interval = 3600,
+            .reportable_change = &rate_change,
+        };
+    }
+    esp_zb_zcl_config_report_cmd_t rate_report_cmd = {0};
+    rate_report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = esp_zb_get_short_address();
+    rate_report_cmd.zcl_basic_cmd.dst_endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT;
+    rate_report_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT;
+    rate_report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+    rate_report_cmd.clusterID = CAELUM_RAIN_RATE_CLUSTER_ID;
+    rate_report_cmd.record_number = 3;
+    rate_report_cmd.record_field = rate_records;
+    esp_zb_zcl_config_report_cmd_req(&rate_report_cmd);
+    ESP_LOGI(TAG, "📋 Rain rate reporting configured on EP%d (change-driven)", HA_ESP_RAIN_GAUGE_ENDPOINT);
+}
+
+/* Send a local Configure Reporting for one policy-governed attribute */
+static void configure_policy_attr_reporting(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, uint8_t attr_type,
+                                            report_policy_id_t policy)
+{
+    /* Any change is reported at once: only values approved by the policy reach the attribute */
+    uint16_t any_change = 1;
+    esp_zb_zcl_config_report_record_t record = {
         .direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
-        .attributeID = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
-        .attrType = ESP_ZB_ZCL_ATTR_TYPE_SINGLE,  // Float type
-        .min_interval = 0,      // No minimum interval - report immediately on change
-        .max_interval = 3600,   // Report at least every hour even if no change
-        .reportable_change = &pulse_reportable_change,
+        .attributeID = attr_id,
+        .attrType = attr_type,
+        .min_interval = 0,
+        .max_interval = report_policy_get(policy)->param[REPORT_POLICY_MAX_INTERVAL],
+        .reportable_change = &any_change,
     };
-    pulse_report_cmd.record_number = 1;
-    pulse_report_cmd.record_field = &pulse_record;
+    esp_zb_zcl_config_report_cmd_t report_cmd = {0};
+    report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = esp_zb_get_short_address();
+    report_cmd.zcl_basic_cmd.dst_endpoint = endpoint;
+    report_cmd.zcl_basic_cmd.src_endpoint = endpoint;
+    report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+    report_cmd.clusterID = cluster_id;
+    report_cmd.record_number = 1;
+    report_cmd.record_field = &record;
+    esp_zb_zcl_config_report_cmd_req(&report_cmd);
+}
+
+/**
+ * @brief Local reporting for the values governed by the on-device report policy
+ *
+ * Re-sent on every join and after a policy override, so the heartbeat (max interval)
+ * does not depend on a coordinator configuration that may not have survived a reboot.
+ */
+static void configure_policy_reporting(uint8_t param)
+{
+    (void)param;  // Unused
 
-    // Called from Zigbee scheduler alarm - no lock needed (already in Zigbee task context)
-    esp_zb_zcl_config_report_cmd_req(&pulse_report_cmd);
-    ESP_LOGI(PULSE_TAG, "📋 Pulse counter reporting configured: change=%.1f, max_interval=3600s", pulse_reportable_change);
+    configure_policy_attr_reporting(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                                    ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16,
+                                    REPORT_POLICY_TEMPERATURE);
+    configure_policy_attr_reporting(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
+                                    ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                    REPORT_POLICY_HUMIDITY);
+    configure_policy_attr_reporting(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT,
+                                    ESP_ZB_ZCL_ATTR_PRESSURE_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16,
+                                    REPORT_POLICY_PRESSURE);
+    configure_policy_attr_reporting(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0020,
+                                    ESP_ZB_ZCL_ATTR_TYPE_U8, REPORT_POLICY_BATTERY_VOLTAGE);
+    configure_policy_attr_reporting(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0021,
+                                    ESP_ZB_ZCL_ATTR_TYPE_U8, REPORT_POLICY_BATTERY_PERCENT);
+    for (uint8_t probe = 0; probe < ds18b20_endpoint_count; probe++) {
+        configure_policy_attr_reporting(HA_ESP_DS18B20_ENDPOINT + probe, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                                        ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16,
+                                        REPORT_POLICY_PROBE_TEMPERATURE);
+    }
+    ESP_LOGI(TAG, "📋 Policy reporting configured (heartbeat from the on-device report policy)");
 }
 
 void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
@@ -573,9 +749,10 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         ESP_LOGW(TAG, "Device left the Zigbee network - will attempt to rejoin");
         debug_led_stop_blink();
         zigbee_network_connected = false;
-        rain_gauge_disable_isr();
-        pulse_counter_disable_isr();
+        counter_channel_set_online(false);
         stop_periodic_reading();
+        poll_control_stop();
+        config_window_active = false;
 
         /* Reset fast retry counter and backoff, then schedule rejoin */
         connection_retry_count = 0;
@@ -634,36 +811,30 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
             connection_retry_count = 0;
             backoff_attempt = 0;
             
-            /* Prevent light sleep during initial configuration period.
-             * Acquire PM lock so esp_zb_sleep_now() becomes a no-op (fast polling). */
-            network_join_time_us = esp_timer_get_time();
-            if (config_pm_lock != NULL) {
-                esp_pm_lock_acquire(config_pm_lock);
-                ESP_LOGI(TAG, "PM lock acquired - sleep blocked for %d seconds for initial config", INITIAL_CONFIG_DELAY_SEC);
-            }
-            
-            /* Enable rain gauge now that we're connected */
-            rain_gauge_enable_isr();
-            ESP_LOGI(RAIN_TAG, "Rain gauge enabled - device connected to Zigbee network");
+            /* Long polling and check-ins from the Poll Control settings; fast polling
+             * for the initial configuration period */
+            poll_control_start();
+            config_window_open();
             
-            /* Enable pulse counter now that we're connected */
-            pulse_counter_enable_isr();
-            ESP_LOGI(PULSE_TAG, "Pulse counter enabled - device connected to Zigbee network");
+            /* Enable rain gauge and pulse counter now that we're connected */
+            counter_channel_set_online(true);
             
             /* Configure local reporting for analog input endpoints (EP2 and EP3)
              * This ensures the Zigbee stack knows to send reports when values change,
              * regardless of whether Z2M has sent a Configure Reporting command. */
             esp_zb_scheduler_alarm((esp_zb_callback_t)configure_analog_input_reporting, 0, 1000); // Configure in 1 second
+            esp_zb_scheduler_alarm((esp_zb_callback_t)configure_policy_reporting, 0, 1500);
+            
+            /* Fresh session: the next sample of every value goes on air */
+            report_policy_reset();
             
             /* Schedule sensor data reporting after first connection 
              * Update attributes (but don't force reports) so coordinator can read current values.
              * Actual reports will be sent based on local and coordinator's reporting configuration. */
             ESP_LOGI(TAG, "📊 Scheduling initial sensor data updates after network join");
             esp_zb_scheduler_alarm((esp_zb_callback_t)initial_sensor_read_trigger, 0, 2000); // Trigger via queue in 2 seconds
-            // Queue rain gauge flush to publish current total after network join
-            rain_gauge_request_flush(false, true);
-            // Queue pulse counter flush to publish current total after network join
-            pulse_counter_request_flush(false, true);
+            // Queue counter flush to publish current totals after network join
+            counter_channel_request_flush(COUNTER_CHANNEL_ALL, false, true);
             // Battery is read by sensor_read_task (triggered above via initial_sensor_read_trigger)
             
             /* Start periodic sensor reading timer for 15-minute intervals.
@@ -684,16 +855,14 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
             zigbee_network_connected = false;
             connection_retry_count++;
             
-            /* Disable rain gauge when not connected */
-            rain_gauge_disable_isr();
-            ESP_LOGW(RAIN_TAG, "Rain gauge disabled - not connected to network");
-            
-            /* Disable pulse counter when not connected */
-            pulse_counter_disable_isr();
-            ESP_LOGW(PULSE_TAG, "Pulse counter disabled - not connected to network");
+            /* Disable rain gauge and pulse counter when not connected */
+            counter_channel_set_online(false);
+            ESP_LOGW(TAG, "Counter channels disabled - not connected to network");
             
             /* Stop periodic sensor reading timer when disconnected */
             stop_periodic_reading();
+            poll_control_stop();
+            config_window_active = false;
             
             /* Check if max fast retries reached → switch to exponential backoff */
             if (connection_retry_count >= MAX_CONNECTION_RETRIES) {
@@ -722,19 +891,20 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
          * stack's internal critical sections and causes a vPortExitCritical crash.
          * PM locks prevent actual light sleep when we need to stay awake. */
 
-        /* Release config PM lock once the initial configuration period expires */
-        if (network_join_time_us > 0) {
-            int64_t time_since_join_us = esp_timer_get_time() - network_join_time_us;
-            int64_t config_period_us = (int64_t)INITIAL_CONFIG_DELAY_SEC * 1000000LL;
-
-            if (time_since_join_us >= config_period_us) {
-                if (config_pm_lock != NULL) {
-                    esp_pm_lock_release(config_pm_lock);
-                    ESP_LOGI(TAG, "Initial config period complete - PM lock released, sleep enabled");
-                }
-                network_join_time_us = 0;
+#if SENSOR_OVERSAMPLE_ENABLE
+        /* Piggy-back an intermediate sample (X1, filter off) on this wake-up (keep-alive poll)
+         * instead of scheduling a dedicated one; the sensor task runs while the stack sleeps */
+        if (zigbee_network_connected && !esp_zb_ota_is_active() && !sensor_subsample_queued &&
+            sensor_read_queue != NULL && sensor_oversample_due()) {
+            uint8_t trigger = SENSOR_TRIGGER_SUBSAMPLE;
+            if (xQueueSend(sensor_read_queue, &trigger, 0) == pdTRUE) {
+                sensor_subsample_queued = true;
             }
         }
+#endif
+
+        /* Updates whose flush found the Zigbee lock busy */
+        attr_queue_drain();
 
         esp_zb_sleep_now();
         break;
@@ -762,26 +932,72 @@ static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t
         
         float new_value = message->attribute.data.value ? *(float*)message->attribute.data.value : 0.0f;
         
-        if (message->info.dst_endpoint == HA_ESP_RAIN_GAUGE_ENDPOINT) {
-            /* Reset rain gauge counter */
-            ESP_LOGI(RAIN_TAG, "🔄 Rain gauge reset from Z2M: %.2f mm -> %.2f mm", total_rainfall_mm, new_value);
-            total_rainfall_mm = new_value;
-            rain_pulse_count = (uint32_t)(new_value / RAIN_MM_PER_PULSE);  // Recalculate pulse count
-            
-            /* Save to NVS immediately */
-            save_rainfall_data(total_rainfall_mm, rain_pulse_count);
-            ESP_LOGI(RAIN_TAG, "💾 Rain gauge value saved to NVS: %.2f mm (%lu pulses)", total_rainfall_mm, rain_pulse_count);
-            
-        } else if (message->info.dst_endpoint == HA_ESP_PULSE_COUNTER_ENDPOINT) {
-            /* Reset pulse counter */
-            ESP_LOGI(PULSE_TAG, "🔄 Pulse counter reset from Z2M: %.2f -> %.2f", total_pulse_count_value, new_value);
-            total_pulse_count_value = new_value;
-            pulse_counter_count = (uint32_t)new_value;  // Update pulse count
-            
-            /* Save to NVS immediately */
-            save_pulse_counter_data(total_pulse_count_value, pulse_counter_count);
-            ESP_LOGI(PULSE_TAG, "💾 Pulse counter value saved to NVS: %.2f (%lu pulses)", total_pulse_count_value, pulse_counter_count);
+        int channel = counter_channel_find_endpoint(message->info.dst_endpoint);
+        if (channel >= 0) {
+            /* Reset the counter; applied and saved by the counter task */
+            ESP_LOGI(TAG, "🔄 EP%d total set from Z2M: %.2f", message->info.dst_endpoint, new_value);
+            counter_channel_set_total((uint8_t)channel, new_value);
+        }
+    }
+    
+    
+    /* Measurement profile selected from Z2M: persist it and let the sensor task pick it
+     * up at the next measurement (no I2C traffic from the Zigbee task) */
+    if (message->info.dst_endpoint == HA_ESP_BME280_ENDPOINT &&
+        message->info.cluster == CAELUM_CONFIG_CLUSTER_ID &&
+        message->attribute.id == CAELUM_ATTR_MEASUREMENT_PROFILE) {
+        
+        uint8_t new_profile = message->attribute.data.value ? *(uint8_t *)message->attribute.data.value : 0xFF;
+        const sensor_profile_t *profile = sensor_profile_get((sensor_profile_id_t)new_profile);
+        esp_err_t err = profile ? sensor_profile_save((sensor_profile_id_t)new_profile) : ESP_ERR_INVALID_ARG;
+        if (err != ESP_OK) {
+            /* The stack already stored the written value: put the profile in use back */
+            uint8_t current = (uint8_t)sensor_get_profile();
+            esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                         CAELUM_ATTR_MEASUREMENT_PROFILE, &current, false);
+            ESP_LOGE(TAG, "Measurement profile %u rejected (%s) - keeping %s", new_profile, esp_err_to_name(err),
+                     sensor_profile_get((sensor_profile_id_t)current)->name);
+            return err;
+        }
+        sensor_set_profile((sensor_profile_id_t)new_profile);
+        
+        uint16_t energy = profile->energy_uj;
+        esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                     CAELUM_ATTR_PROFILE_ENERGY_UJ, &energy, false);
+        ESP_LOGI(TAG, "📐 Measurement profile set from Z2M: %s (~%u uJ/sample)", profile->name, energy);
+    }
+    
+    /* Poll Control intervals written by the coordinator: validate, apply and persist */
+    if (message->info.dst_endpoint == HA_ESP_BME280_ENDPOINT &&
+        message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL) {
+        ret = poll_control_attribute_written(message->attribute.id, message->attribute.data.value);
+    }
+    
+    /* Report policy override: persist it and refresh the local heartbeat configuration */
+    if (message->info.dst_endpoint == HA_ESP_BME280_ENDPOINT &&
+        message->info.cluster == CAELUM_CONFIG_CLUSTER_ID &&
+        message->attribute.id >= CAELUM_ATTR_POLICY(0, 0) &&
+        message->attribute.id < CAELUM_ATTR_POLICY(REPORT_POLICY_COUNT, 0)) {
+        
+        report_policy_id_t policy = (report_policy_id_t)((message->attribute.id >> 4) & 0x0F);
+        report_policy_param_t policy_param = (report_policy_param_t)(message->attribute.id & 0x0F);
+        uint16_t value = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : 0;
+        esp_err_t err = report_policy_set(policy, policy_param, value);
+        if (err != ESP_OK) {
+            /* The stack already stored the written value: put the active parameter back */
+            if ((unsigned)policy_param < REPORT_POLICY_PARAM_COUNT) {
+                uint16_t current = report_policy_get(policy)->param[policy_param];
+                esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID,
+                                             ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, message->attribute.id, &current, false);
+            }
+            ESP_LOGE(TAG, "Report policy attribute 0x%04x = %u rejected: %s", message->attribute.id, value,
+                     esp_err_to_name(err));
+            return err;
         }
+        if (policy_param == REPORT_POLICY_MAX_INTERVAL) {
+            esp_zb_scheduler_alarm((esp_zb_callback_t)configure_policy_reporting, 0, 100);
+        }
+        ESP_LOGI(TAG, "📐 Report policy %s: parameter %d = %u", report_policy_get(policy)->name, policy_param, value);
     }
     
     return ret;
@@ -800,6 +1016,12 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     case ESP_ZB_CORE_OTA_UPGRADE_QUERY_IMAGE_RESP_CB_ID:
         ret = zb_ota_query_image_resp_handler(*(esp_zb_zcl_ota_upgrade_query_image_resp_message_t *)message);
         break;
+    case ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID:
+        config_window_activity("configure reporting response");
+        break;
+    case ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID:
+        ret = poll_control_command_handler((esp_zb_zcl_privilege_command_message_t *)message);
+        break;
     case ESP_ZB_CORE_REPORT_ATTR_CB_ID:
         {
             esp_zb_zcl_report_attr_message_t *report_attr_message = (esp_zb_zcl_report_attr_message_t *)message;
@@ -810,13 +1032,10 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
                                     *(float*)report_attr_message->attribute.data.value : 0.0f;
                 
                 if (report_attr_message->attribute.id == ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID) {
-                    /* Check which endpoint this is from */
-                    if (report_attr_message->dst_endpoint == HA_ESP_RAIN_GAUGE_ENDPOINT) {
-                        /* This is rain gauge total rainfall */
-                        ESP_LOGI(TAG, "📡 Rain: %.2f mm", analog_value);
-                    } else if (report_attr_message->dst_endpoint == HA_ESP_PULSE_COUNTER_ENDPOINT) {
-                        /* This is pulse counter total */
-                        ESP_LOGI(TAG, "📡 Pulse: %.2f", analog_value);
+                    /* Check which counter channel this is from */
+                    int channel = counter_channel_find_endpoint(report_attr_message->dst_endpoint);
+                    if (channel >= 0) {
+                        ESP_LOGI(TAG, "📡 %s: %.2f", counter_channel_get_config(channel)->name, analog_value);
                     }
                 }
             } else if (report_attr_message->cluster == ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT) {
@@ -824,8 +1043,10 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
                                  *(int16_t*)report_attr_message->attribute.data.value : 0;
                 if (report_attr_message->src_endpoint == HA_ESP_BME280_ENDPOINT) {
                     ESP_LOGI(TAG, "📡 BME280 Temp: %.1f°C", temp_raw / 100.0f);
-                } else if (report_attr_message->src_endpoint == HA_ESP_DS18B20_ENDPOINT) {
-                    ESP_LOGI(TAG, "📡 DS18B20 Temp: %.1f°C", temp_raw / 100.0f);
+                } else if (report_attr_message->src_endpoint >= HA_ESP_DS18B20_ENDPOINT &&
+                           report_attr_message->src_endpoint < HA_ESP_DS18B20_ENDPOINT + ds18b20_endpoint_count) {
+                    ESP_LOGI(TAG, "📡 DS18B20 #%d Temp: %.1f°C", report_attr_message->src_endpoint - HA_ESP_DS18B20_ENDPOINT,
+                             temp_raw / 100.0f);
                 }
             } else if (report_attr_message->cluster == ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT) {
                 uint16_t hum_raw = report_attr_message->attribute.data.value ? 
@@ -861,7 +1082,7 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
  * For Sleepy End Device (SED) mode with automatic sleep:
  * - DO NOT use scheduler alarms for continuous operations
  * - The Zigbee stack handles sleep/wake automatically via ESP_ZB_COMMON_SIGNAL_CAN_SLEEP
- * - Device wakes naturally every keep_alive interval (7.5s) to poll parent
+ * - Device wakes naturally every keep_alive (Poll Control long poll, 7.5s default) to poll parent
  * - Continuous alarms prevent the CAN_SLEEP signal from ever triggering
  * - Reports are now triggered on-demand or by external events (rain gauge, etc)
  */
@@ -879,9 +1100,11 @@ static void esp_zb_task(void *pvParameters)
     // Initialize Zigbee stack as Sleepy End Device (SED)
     esp_zb_cfg_t zb_nwk_cfg = ESP_ZB_ZED_CONFIG();
     
-    // Configure as Sleepy End Device for low power operation
+    // Configure as Sleepy End Device for low power operation; keep-alive = persisted long poll interval
+    poll_control_init(ZIGBEE_SLEEP_THRESHOLD_MS);
+    uint32_t keep_alive_ms = poll_control_long_poll_ms();
     zb_nwk_cfg.nwk_cfg.zed_cfg.ed_timeout = ZIGBEE_ED_TIMEOUT;
-    zb_nwk_cfg.nwk_cfg.zed_cfg.keep_alive = ZIGBEE_KEEP_ALIVE_MS;
+    zb_nwk_cfg.nwk_cfg.zed_cfg.keep_alive = keep_alive_ms;
 
     /* CRITICAL: Enable sleep BEFORE esp_zb_init() — the ZBOSS stack sets up
      * internal critical section state for sleep during init. Enabling after
@@ -896,38 +1119,37 @@ static void esp_zb_task(void *pvParameters)
     esp_zb_sleep_set_threshold(ZIGBEE_SLEEP_THRESHOLD_MS);
     
     /* Validate timing configuration to prevent sleep conflicts */
-    if (ZIGBEE_SLEEP_THRESHOLD_MS >= ZIGBEE_KEEP_ALIVE_MS) {
-        ESP_LOGW(TAG, "⚠️ WARNING: Sleep threshold (%d ms) should be < keep_alive (%d ms) to avoid timing conflicts!", 
-                 ZIGBEE_SLEEP_THRESHOLD_MS, ZIGBEE_KEEP_ALIVE_MS);
+    if (ZIGBEE_SLEEP_THRESHOLD_MS >= keep_alive_ms) {
+        ESP_LOGW(TAG, "⚠️ WARNING: Sleep threshold (%d ms) should be < keep_alive (%lu ms) to avoid timing conflicts!", 
+                 ZIGBEE_SLEEP_THRESHOLD_MS, (unsigned long)keep_alive_ms);
     }
     
     ESP_LOGI(TAG, "🔋 Configured as Sleepy End Device (SED) - rx_on_when_idle=false");
-    ESP_LOGI(TAG, "📡 Keep-alive poll interval: %d ms (%.1f sec)", 
-             ZIGBEE_KEEP_ALIVE_MS, ZIGBEE_KEEP_ALIVE_MS / 1000.0f);
+    ESP_LOGI(TAG, "📡 Keep-alive poll interval: %lu ms (%.1f sec)", 
+             (unsigned long)keep_alive_ms, keep_alive_ms / 1000.0f);
     ESP_LOGI(TAG, "💤 Sleep threshold: %d ms (%.1f sec) - production optimized", 
              ZIGBEE_SLEEP_THRESHOLD_MS, ZIGBEE_SLEEP_THRESHOLD_MS / 1000.0f);
     ESP_LOGI(TAG, "⏱️  Parent timeout: 64 minutes");
     ESP_LOGI(TAG, "⚡ Power profile: 0.68mA sleep, 12mA transmit, ~0.83mA average");
     
-    /* Load rainfall data from NVS BEFORE creating clusters so we can initialize with correct value */
-    float loaded_rainfall = 0.0f;
-    uint32_t loaded_pulses = 0;
-    load_rainfall_data(&loaded_rainfall, &loaded_pulses);
-    total_rainfall_mm = roundf(loaded_rainfall * 100.0f) / 100.0f;
-    rain_pulse_count = loaded_pulses;
-    if (loaded_rainfall > 0.0f || loaded_pulses > 0) {
-        ESP_LOGI(TAG, "📂 Pre-loaded rainfall for cluster init: %.2f mm (%lu pulses)", total_rainfall_mm, rain_pulse_count);
-    }
+    /* Load counter totals (RTC, else NVS) BEFORE creating clusters so the endpoints start with the correct value */
+    rain_rate_init(RAIN_MM_PER_PULSE);
+    counter_channel_init(counter_channels, sizeof(counter_channels) / sizeof(counter_channels[0]));
     
-    /* Load pulse counter data from RTC/NVS BEFORE creating clusters */
-    float loaded_pulse_value = 0.0f;
-    uint32_t loaded_pulse_count = 0;
-    load_pulse_counter_data(&loaded_pulse_value, &loaded_pulse_count);
-    total_pulse_count_value = roundf(loaded_pulse_value * 100.0f) / 100.0f;
-    pulse_counter_count = loaded_pulse_count;
-    if (loaded_pulse_value > 0.0f || loaded_pulse_count > 0) {
-        ESP_LOGI(TAG, "📂 Pre-loaded pulse counter for cluster init: %.2f (%lu pulses)", total_pulse_count_value, pulse_counter_count);
-    }
+    /* Report policy defaults + NVS overrides, exposed on the configuration cluster */
+    report_policy_init();
+    
+    /* Load measurement profile BEFORE creating clusters; sensor_init() applies it to the drivers */
+    sensor_profile_id_t loaded_profile = SENSOR_PROFILE_DEFAULT;
+    sensor_profile_load(&loaded_profile);
+    sensor_set_profile(loaded_profile);
+    ESP_LOGI(TAG, "📐 Measurement profile: %s", sensor_profile_get(loaded_profile)->name);
+    
+    /* Load DS18B20 probe table BEFORE creating clusters: one temperature endpoint per known probe */
+    ds18b20_roms_load(&ds18b20_probes);
+    ds18b20_endpoint_count = ds18b20_probes.count > 1 ? ds18b20_probes.count : 1;
+    ESP_LOGI(TAG, "🌡️ DS18B20 probe endpoints: %u (EP%d-EP%d)", ds18b20_endpoint_count, HA_ESP_DS18B20_ENDPOINT,
+             HA_ESP_DS18B20_ENDPOINT + ds18b20_endpoint_count - 1);
     
     /* Create endpoint list */
     esp_zb_ep_list_t *esp_zb_ep_list = esp_zb_ep_list_create();
@@ -1016,6 +1238,47 @@ static void esp_zb_task(void *pvParameters)
     ESP_ERROR_CHECK(esp_zb_pressure_meas_cluster_add_attr(esp_zb_pressure_cluster, ESP_ZB_ZCL_ATTR_PRESSURE_MEASUREMENT_MAX_VALUE_ID, &pressure_max));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_pressure_meas_cluster(esp_zb_bme280_clusters, esp_zb_pressure_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     
+    /* Add manufacturer-specific configuration cluster: writable measurement profile
+     * (persisted in NVS) plus the estimated energy per sample of that profile */
+    uint8_t profile_value = (uint8_t)loaded_profile;
+    uint16_t profile_energy = sensor_profile_get(loaded_profile)->energy_uj;
+    esp_zb_attribute_list_t *esp_zb_config_cluster = esp_zb_zcl_attr_list_create(CAELUM_CONFIG_CLUSTER_ID);
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_MEASUREMENT_PROFILE,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &profile_value));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_PROFILE_ENERGY_UJ,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &profile_energy));
+    
+    /* Sensor diagnostics: error/retry/recovery counters since boot, refreshed every report cycle */
+    uint32_t sensor_errors = 0;
+    uint32_t sensor_retries = 0;
+    uint16_t bus_recoveries = 0;
+    uint16_t incomplete_cycles = 0;
+    char sensor_diag[CAELUM_SENSOR_DIAG_MAX_LEN + 1] = { 0 };  // Length-prefixed, empty
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_SENSOR_ERRORS,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &sensor_errors));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_SENSOR_RETRIES,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &sensor_retries));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_BUS_RECOVERIES,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &bus_recoveries));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_INCOMPLETE_CYCLES,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &incomplete_cycles));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_SENSOR_DIAG,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, sensor_diag));
+    
+    /* Report policy: deadband, hysteresis, min and max interval of every governed value */
+    for (int policy = 0; policy < REPORT_POLICY_COUNT; policy++) {
+        for (int param = 0; param < REPORT_POLICY_PARAM_COUNT; param++) {
+            uint16_t value = report_policy_get((report_policy_id_t)policy)->param[param];
+            ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_config_cluster, CAELUM_ATTR_POLICY(policy, param),
+                                                                  ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &value));
+        }
+    }
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(esp_zb_bme280_clusters, esp_zb_config_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+    
+    /* Poll Control server: coordinator-driven check-in, long/short poll and fast-poll windows */
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_poll_control_cluster(esp_zb_bme280_clusters, poll_control_cluster_create(),
+                                                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+    
     /* Add Identify cluster for BME280 endpoint */
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_bme280_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     
@@ -1093,108 +1356,114 @@ static void esp_zb_task(void *pvParameters)
         .app_device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
         .app_device_version = 0
     };
-    esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_bme280_clusters, endpoint_bme280_config);    /* Create rain gauge sensor endpoint */
-    esp_zb_cluster_list_t *esp_zb_rain_clusters = esp_zb_zcl_cluster_list_create();
-    
-    /* Basic cluster intentionally omitted for rain gauge endpoint (EP2).
-     * We expose only the Analog Input cluster on this endpoint so the coordinator
-     * does not attempt to read device-level Basic attributes here.
-     */
-    
-    /* Create Analog Input cluster for rain gauge with REPORTING flag
-     * Present value must have REPORTING flag for reporting config persistence */
-    float rain_present_value = total_rainfall_mm;  // Initialize with loaded value from NVS
-    esp_zb_attribute_list_t *esp_zb_rain_analog_cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT);
-    ESP_ERROR_CHECK(esp_zb_cluster_add_attr(esp_zb_rain_analog_cluster, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-                                            ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_SINGLE,
-                                            ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &rain_present_value));
-    
-    /* Add description attribute */
-    char rain_description[] = "\x0E""Rainfall Total";  // Length-prefixed: 14 bytes + "Rainfall Total"
-    esp_zb_analog_input_cluster_add_attr(esp_zb_rain_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_DESCRIPTION_ID, rain_description);
-    
-    /* Add engineering units attribute (mm) */
-    uint16_t engineering_units = 0;  // 0 = dimensionless, could use custom units
-    esp_zb_analog_input_cluster_add_attr(esp_zb_rain_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_ENGINEERING_UNITS_ID, &engineering_units);
-    
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_analog_input_cluster(esp_zb_rain_clusters, esp_zb_rain_analog_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    /* Add Identify cluster for rain gauge endpoint */
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_rain_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    esp_zb_endpoint_config_t endpoint_rain_config = {
-        .endpoint = HA_ESP_RAIN_GAUGE_ENDPOINT,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .app_device_id = ESP_ZB_HA_SIMPLE_SENSOR_DEVICE_ID,
-        .app_device_version = 0
-    };
-    esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_rain_clusters, endpoint_rain_config);
+    esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_bme280_clusters, endpoint_bme280_config);
 
-    /* Create pulse counter sensor endpoint (GPIO13) */
-    esp_zb_cluster_list_t *esp_zb_pulse_clusters = esp_zb_zcl_cluster_list_create();
-    
-    /* Basic cluster intentionally omitted for pulse counter endpoint (EP3).
-     * We expose only the Analog Input cluster on this endpoint so the coordinator
-     * does not attempt to read device-level Basic attributes here.
-     */
-    
-    /* Create Analog Input cluster for pulse counter with REPORTING flag
-     * Present value must have REPORTING flag for reporting config persistence */
-    float pulse_present_value = total_pulse_count_value;  // Initialize with loaded value from NVS
-    esp_zb_attribute_list_t *esp_zb_pulse_analog_cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT);
-    ESP_ERROR_CHECK(esp_zb_cluster_add_attr(esp_zb_pulse_analog_cluster, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-                                            ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_SINGLE,
-                                            ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &pulse_present_value));
-    
-    /* Add description attribute */
-    char pulse_description[] = "\x0D""Pulse Counter";  // Length-prefixed: 13 bytes + "Pulse Counter"
-    esp_zb_analog_input_cluster_add_attr(esp_zb_pulse_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_DESCRIPTION_ID, pulse_description);
-    
-    /* Add engineering units attribute */
-    uint16_t pulse_engineering_units = 0;  // 0 = dimensionless
-    esp_zb_analog_input_cluster_add_attr(esp_zb_pulse_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_ENGINEERING_UNITS_ID, &pulse_engineering_units);
-    
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_analog_input_cluster(esp_zb_pulse_clusters, esp_zb_pulse_analog_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    /* Add Identify cluster for pulse counter endpoint */
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_pulse_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    esp_zb_endpoint_config_t endpoint_pulse_config = {
-        .endpoint = HA_ESP_PULSE_COUNTER_ENDPOINT,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .app_device_id = ESP_ZB_HA_SIMPLE_SENSOR_DEVICE_ID,
-        .app_device_version = 0
-    };
-    esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_pulse_clusters, endpoint_pulse_config);
+    /* Create counter endpoints (EP2 rain gauge, EP3 pulse counter), one per channel table row */
+    for (uint8_t i = 0; i < counter_channel_count(); i++) {
+        const counter_channel_config_t *ch = counter_channel_get_config(i);
+        esp_zb_cluster_list_t *esp_zb_counter_clusters = esp_zb_zcl_cluster_list_create();
+        
+        /* Basic cluster intentionally omitted for counter endpoints.
+         * We expose only the Analog Input cluster on this endpoint so the coordinator
+         * does not attempt to read device-level Basic attributes here.
+         */
+        
+        /* Create Analog Input cluster with REPORTING flag
+         * Present value must have REPORTING flag for reporting config persistence */
+        float present_value = 0.0f;
+        uint32_t pulses = 0;
+        counter_channel_get_total(i, &present_value, &pulses);  // Initialize with loaded value from RTC/NVS
+        esp_zb_attribute_list_t *esp_zb_counter_analog_cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT);
+        ESP_ERROR_CHECK(esp_zb_cluster_add_attr(esp_zb_counter_analog_cluster, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
+                                                ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_SINGLE,
+                                                ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &present_value));
+        
+        /* Add description attribute (length-prefixed string from the table) */
+        esp_zb_analog_input_cluster_add_attr(esp_zb_counter_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_DESCRIPTION_ID,
+                                             (void *)ch->description);
+        
+        /* Add engineering units attribute */
+        uint16_t engineering_units = 0;  // 0 = dimensionless, could use custom units
+        esp_zb_analog_input_cluster_add_attr(esp_zb_counter_analog_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_ENGINEERING_UNITS_ID, &engineering_units);
+        
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_analog_input_cluster(esp_zb_counter_clusters, esp_zb_counter_analog_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        
+        /* Metering cluster: the same total as an exact uint48 summation in 1e-6 units
+         * (Multiplier 1 / Divisor 1e6), so large totals are never rounded like the float */
+        esp_zb_metering_cluster_cfg_t metering_cfg = {
+            .current_summation_delivered = counter_summation(ch, pulses),
+            .status = 0,
+            .uint_of_measure = ch->metering_unit,
+            .summation_formatting = 0xBA,       // Suppress leading zeros, 7 integer digits, 2 decimals
+            .metering_device_type = ch->metering_device_type,
+        };
+        esp_zb_attribute_list_t *esp_zb_metering_cluster = esp_zb_metering_cluster_create(&metering_cfg);
+        uint32_t metering_multiplier = 1;
+        uint32_t metering_divisor = COUNTER_MICRO_PER_UNIT;
+        esp_zb_metering_cluster_add_attr(esp_zb_metering_cluster, ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID, &metering_multiplier);
+        esp_zb_metering_cluster_add_attr(esp_zb_metering_cluster, ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID, &metering_divisor);
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_metering_cluster(esp_zb_counter_clusters, esp_zb_metering_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        
+        /* Rain gauge endpoint: rain rate cluster, seeded from the RTC tip window */
+        if (i == COUNTER_RAIN) {
+            rain_rate_t rate;
+            rain_rate_poll(&rate);
+            rain_rate_commit(&rate);
+            uint16_t rain_rate = rain_rate_to_zb(rate.instant_mm_h);
+            uint16_t rain_rate_10min = rain_rate_to_zb(rate.rate_10min_mm_h);
+            uint16_t rain_rate_1h = rain_rate_to_zb(rate.rate_1h_mm_h);
+            esp_zb_attribute_list_t *esp_zb_rain_rate_cluster = esp_zb_zcl_attr_list_create(CAELUM_RAIN_RATE_CLUSTER_ID);
+            ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_rain_rate_cluster, CAELUM_ATTR_RAIN_RATE,
+                                                                  ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &rain_rate));
+            ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_rain_rate_cluster, CAELUM_ATTR_RAIN_RATE_10MIN,
+                                                                  ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &rain_rate_10min));
+            ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(esp_zb_rain_rate_cluster, CAELUM_ATTR_RAIN_RATE_1H,
+                                                                  ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &rain_rate_1h));
+            ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(esp_zb_counter_clusters, esp_zb_rain_rate_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        }
+        
+        /* Add Identify cluster for the counter endpoint */
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_counter_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        
+        esp_zb_endpoint_config_t endpoint_counter_config = {
+            .endpoint = ch->endpoint,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_SIMPLE_SENSOR_DEVICE_ID,
+            .app_device_version = 0
+        };
+        esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_counter_clusters, endpoint_counter_config);
+    }
 
-    /* Create DS18B20 temperature sensor endpoint (GPIO24) */
-    esp_zb_cluster_list_t *esp_zb_ds18b20_clusters = esp_zb_zcl_cluster_list_create();
-    
-    /* Create Temperature Measurement cluster for DS18B20 with REPORTING flag
-     * Must manually create cluster to ensure REPORTING flag is set for persistence */
-    int16_t ds18b20_temp_value = (int16_t)(ds18b20_last_temp * 100);  // Initialize with last known value
-    int16_t ds18b20_temp_min = -5000;     // -50°C
-    int16_t ds18b20_temp_max = 12500;     // 125°C
-    
-    esp_zb_attribute_list_t *esp_zb_ds18b20_temperature_cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT);
-    ESP_ERROR_CHECK(esp_zb_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-                                            ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16,
-                                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &ds18b20_temp_value));
-    ESP_ERROR_CHECK(esp_zb_temperature_meas_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID, &ds18b20_temp_min));
-    ESP_ERROR_CHECK(esp_zb_temperature_meas_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID, &ds18b20_temp_max));
-    
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_temperature_meas_cluster(esp_zb_ds18b20_clusters, esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    /* Add Identify cluster for DS18B20 endpoint */
-    ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_ds18b20_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
-    
-    esp_zb_endpoint_config_t endpoint_ds18b20_config = {
-        .endpoint = HA_ESP_DS18B20_ENDPOINT,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .app_device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
-        .app_device_version = 0
-    };
-    esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_ds18b20_clusters, endpoint_ds18b20_config);
+    /* Create DS18B20 temperature sensor endpoints (GPIO24), one per probe in the table */
+    for (uint8_t probe = 0; probe < ds18b20_endpoint_count; probe++) {
+        esp_zb_cluster_list_t *esp_zb_ds18b20_clusters = esp_zb_zcl_cluster_list_create();
+        
+        /* Create Temperature Measurement cluster for DS18B20 with REPORTING flag
+         * Must manually create cluster to ensure REPORTING flag is set for persistence */
+        int16_t ds18b20_temp_value = (int16_t)(ds18b20_last_temp[probe] * 100);  // Initialize with last known value
+        int16_t ds18b20_temp_min = -5000;     // -50°C
+        int16_t ds18b20_temp_max = 12500;     // 125°C
+        
+        esp_zb_attribute_list_t *esp_zb_ds18b20_temperature_cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT);
+        ESP_ERROR_CHECK(esp_zb_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                                                ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16,
+                                                ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &ds18b20_temp_value));
+        ESP_ERROR_CHECK(esp_zb_temperature_meas_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID, &ds18b20_temp_min));
+        ESP_ERROR_CHECK(esp_zb_temperature_meas_cluster_add_attr(esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID, &ds18b20_temp_max));
+        
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_temperature_meas_cluster(esp_zb_ds18b20_clusters, esp_zb_ds18b20_temperature_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        
+        /* Add Identify cluster for DS18B20 endpoint */
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(esp_zb_ds18b20_clusters, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        
+        esp_zb_endpoint_config_t endpoint_ds18b20_config = {
+            .endpoint = HA_ESP_DS18B20_ENDPOINT + probe,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+            .app_device_version = 0
+        };
+        esp_zb_ep_list_add_ep(esp_zb_ep_list, esp_zb_ds18b20_clusters, endpoint_ds18b20_config);
+    }
 
     /* Endpoint 4 (Sleep Configuration) removed in light sleep mode.
      * Device uses automatic sleep/wake with standard Zigbee reporting configuration.
@@ -1218,6 +1487,8 @@ static void esp_zb_task(void *pvParameters)
 
     esp_zb_device_register(esp_zb_ep_list);
     esp_zb_core_action_handler_register(zb_action_handler);
+    esp_zb_aps_data_indication_handler_register(config_window_aps_indication);
+    ESP_ERROR_CHECK(poll_control_register(HA_ESP_BME280_ENDPOINT));
     
     /* Debug: Verify REPORTING flag is set on critical attributes
      * According to ESP Zigbee SDK docs (section 5.7.4): Use esp_zb_zcl_get_attribute() to verify
@@ -1249,20 +1520,15 @@ static void esp_zb_task(void *pvParameters)
                  (attr->access & ESP_ZB_ZCL_ATTR_ACCESS_REPORTING) ? "✅ REPORTING" : "❌ NO REPORTING");
     }
     
-    // Check rain gauge
-    attr = esp_zb_zcl_get_attribute(HA_ESP_RAIN_GAUGE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID);
-    if (attr) {
-        ESP_LOGI(TAG, "  Rain gauge: access=0x%02x %s", attr->access,
-                 (attr->access & ESP_ZB_ZCL_ATTR_ACCESS_REPORTING) ? "✅ REPORTING" : "❌ NO REPORTING");
-    }
-    
-    // Check pulse counter
-    attr = esp_zb_zcl_get_attribute(HA_ESP_PULSE_COUNTER_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID);
-    if (attr) {
-        ESP_LOGI(TAG, "  Pulse counter: access=0x%02x %s", attr->access,
-                 (attr->access & ESP_ZB_ZCL_ATTR_ACCESS_REPORTING) ? "✅ REPORTING" : "❌ NO REPORTING");
+    // Check counter channels (rain gauge, pulse counter)
+    for (uint8_t i = 0; i < counter_channel_count(); i++) {
+        const counter_channel_config_t *ch = counter_channel_get_config(i);
+        attr = esp_zb_zcl_get_attribute(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
+                                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID);
+        if (attr) {
+            ESP_LOGI(TAG, "  %s: access=0x%02x %s", ch->name, attr->access,
+                     (attr->access & ESP_ZB_ZCL_ATTR_ACCESS_REPORTING) ? "✅ REPORTING" : "❌ NO REPORTING");
+        }
     }
     
     // Check DS18B20 temperature
@@ -1344,7 +1610,7 @@ static void factory_reset_device(uint8_t param)
  * sensor drivers use vTaskDelay() which must not run in Zigbee scheduler context. */
 static void initial_sensor_read_trigger(uint8_t param)
 {
-    uint8_t trigger = 1;
+    uint8_t trigger = SENSOR_TRIGGER_REPORT;
     if (sensor_read_queue != NULL) {
         xQueueSend(sensor_read_queue, &trigger, 0);
     }
@@ -1353,6 +1619,42 @@ static void initial_sensor_read_trigger(uint8_t param)
 /* Sensor reading task - runs in dedicated FreeRTOS task context
  * This is CRITICAL because sensor I2C operations contain vTaskDelay() which
  * CANNOT be called from Zigbee scheduler context - causes deadlocks! */
+/* Attribute changes of the current sensor cycle go through the attribute queue:
+ * no Zigbee lock wait here, the Zigbee task applies them in one pass */
+static void sensor_cycle_stage(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, const void *value, size_t len)
+{
+    attr_queue_push(endpoint, cluster_id, attr_id, value, len);
+}
+
+/* Stage a value only if the report policy lets it go on air */
+static bool sensor_cycle_stage_policy(report_policy_id_t policy, uint8_t channel, int32_t policy_value,
+                                      uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, const void *value, size_t len)
+{
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000ULL);
+    if (!report_policy_check(policy, channel, policy_value, now_s)) {
+        return false;
+    }
+    sensor_cycle_stage(endpoint, cluster_id, attr_id, value, len);
+    return true;
+}
+
+/* Upper bound for a synchronous commit (Zigbee lock wait + drain) */
+#define SENSOR_COMMIT_WAIT_MS 500
+
+/* Hand the staged values to the Zigbee task. With wait, return only once they are
+ * written and their reports handed to the stack (what a loaded battery sample needs) */
+static void sensor_cycle_commit(bool wait)
+{
+    if (!wait) {
+        attr_queue_flush();
+        return;
+    }
+    esp_err_t ret = attr_queue_flush_wait(SENSOR_COMMIT_WAIT_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Staged values not written within %d ms (%s)", SENSOR_COMMIT_WAIT_MS, esp_err_to_name(ret));
+    }
+}
+
 static void sensor_read_task(void *arg)
 {
     uint8_t trigger;
@@ -1361,129 +1663,142 @@ static void sensor_read_task(void *arg)
     for (;;) {
         // Wait for trigger from periodic timer
         if (xQueueReceive(sensor_read_queue, &trigger, portMAX_DELAY)) {
+            if (trigger == SENSOR_TRIGGER_SUBSAMPLE) {
+                /* X1, filter off: the ring does the averaging; the report cycle restores the profile */
+                sensor_sample_t sample = { 0 };
+                sensor_set_subsample(true);
+                if (sensor_wake_and_measure(&sample) == ESP_OK) {
+                    sensor_oversample_push(&sample);
+                }
+                sensor_set_subsample(false);
+                sensor_subsample_queued = false;
+                continue;
+            }
+            
+            if (trigger == SENSOR_TRIGGER_DS18B20) {
+                ds18b20_read_and_report(0);
+                sensor_cycle_commit(false);
+                continue;
+            }
+            
             ESP_LOGI(TAG, "📊 Sensor read task triggered");
             
-            // Perform sensor reads with proper task delays
+            // DS18B20 converts in the background while the I2C sensors are read
+            ds18b20_start_pipelined();
             bme280_read_and_report(0);
-            ds18b20_read_and_report(0);
+            // Sensor clusters to the Zigbee task (one frame per cluster); a loaded battery
+            // sample waits until their reports are handed to the stack
+            sensor_cycle_commit(BATTERY_MEASURE_UNDER_LOAD);
             
-            // Update rain gauge and pulse counter
-            rain_gauge_request_flush(false, true);
-            pulse_counter_request_flush(false, true);
+            // Update rain gauge and pulse counter; let the rain rate decay while dry
+            counter_channel_request_flush(COUNTER_CHANNEL_ALL, false, true);
+            rain_rate_report();
             
             // Battery reading
             battery_read_and_report(0);
+            sensor_cycle_commit(false);
             
             ESP_LOGI(TAG, "✅ Sensor read task complete");
         }
     }
 }
 
+/* Publish the sensor layer error counters on the configuration cluster */
+static void sensor_update_diag_attributes(void)
+{
+    sensor_stats_t stats;
+    sensor_get_stats(&stats);
+    char diag[CAELUM_SENSOR_DIAG_MAX_LEN + 1];
+    size_t len = sensor_format_stats(diag + 1, sizeof(diag) - 1);
+    diag[0] = (char)len;  // ZCL char string: length prefix
+
+    /* Staged with the rest of the cycle: one frame for the whole configuration cluster */
+    uint16_t recoveries = stats.bus_recoveries;
+    uint16_t incomplete = stats.incomplete;
+    sensor_cycle_stage(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, CAELUM_ATTR_SENSOR_ERRORS,
+                       &stats.errors, sizeof(stats.errors));
+    sensor_cycle_stage(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, CAELUM_ATTR_SENSOR_RETRIES,
+                       &stats.retries, sizeof(stats.retries));
+    sensor_cycle_stage(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, CAELUM_ATTR_BUS_RECOVERIES,
+                       &recoveries, sizeof(recoveries));
+    sensor_cycle_stage(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, CAELUM_ATTR_INCOMPLETE_CYCLES,
+                       &incomplete, sizeof(incomplete));
+    sensor_cycle_stage(HA_ESP_BME280_ENDPOINT, CAELUM_CONFIG_CLUSTER_ID, CAELUM_ATTR_SENSOR_DIAG, diag, len + 1);
+
+    if (stats.errors || stats.bus_recoveries) {
+        ESP_LOGI(TAG, "🩺 Sensor diagnostics: %lu errors, %lu retries, %u recoveries, %u incomplete [%s]",
+                 (unsigned long)stats.errors, (unsigned long)stats.retries, stats.bus_recoveries,
+                 stats.incomplete, diag + 1);
+    }
+}
+
 /* BME280 sensor reading and reporting functions */
 static void bme280_read_and_report(uint8_t param)
 {
-    float temperature = 0.0f, humidity = 0.0f, pressure = 0.0f;
+    sensor_sample_t sample = { 0 };
     esp_err_t ret;
-    bool force_report = false;  // Never force - reporting config persisted via REPORTING flag
 
-    /* Wake sensors and trigger measurement if required */
-    ret = sensor_wake_and_measure();
+    /* Start all conversions in parallel, sleep until the slowest is due, then collect
+     * every channel from a single conversion per chip.
+     * Runs in sensor_read_task context, so blocking here lets the CPU light-sleep. */
+    ret = sensor_wake_and_measure(&sample);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "sensor_wake_and_measure() returned %s - will try to read cached/last values", esp_err_to_name(ret));
+        ESP_LOGW(TAG, "sensor_wake_and_measure() returned %s - no fresh sample this cycle", esp_err_to_name(ret));
     }
 
-    /* Wait for BMP280 pressure conversion to complete (~10-15ms for osrs=1)
-     * This delay is needed when using SHT41+BMP280 combo because:
-     * 1. sht41_trigger_measurement() triggers+waits+reads (includes 10ms delay internally)
-     * 2. bmp280_trigger_measurement() only triggers (no delay)
-     * 3. We need to wait before calling bmp280_read_pressure_no_trigger()
-     * The SHT41 already waited 10ms, so we add an additional 10ms here to ensure
-     * BMP280 conversion is complete (total ~20ms, more than enough for both sensors)
-     * 
-     * CRITICAL: Use busy-wait instead of vTaskDelay() because this function runs
-     * in Zigbee scheduler context. vTaskDelay() can cause deadlocks! */
-    sensor_type_t sensor_type = sensor_get_type();
-    if (sensor_type == SENSOR_TYPE_SHT41_BMP280 || sensor_type == SENSOR_TYPE_AHT20_BMP280) {
-        esp_rom_delay_us(10000); // 10ms busy-wait for BMP280 pressure conversion
+#if SENSOR_OVERSAMPLE_ENABLE
+    /* Average with the intermediate samples taken since the last report */
+    sensor_oversample_push(&sample);
+    uint32_t averaged = sensor_oversample_reduce(&sample, PERIODIC_READING_INTERVAL_MS + SENSOR_OVERSAMPLE_INTERVAL_MS);
+    if (averaged > 1) {
+        ESP_LOGI(TAG, "📉 Reporting average of %lu samples", (unsigned long)averaged);
     }
+#endif
 
-    /* Read temperature */
-    ret = sensor_read_temperature(&temperature);
-    if (ret == ESP_OK) {
+    /* Temperature */
+    if (sample.valid & SENSOR_CH_TEMPERATURE) {
+        float temperature = sample.temperature_c;
         int16_t temp_centidegrees = (int16_t)(temperature * 100);
-        if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-            ret = esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-                                               ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-                                               &temp_centidegrees, force_report);
-            esp_zb_lock_release();
-        } else {
-            ret = ESP_FAIL;
-        }
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "🌡️ Temperature: %.2f°C (attribute updated)", temperature);
-
-            static float last_logged_temp = -999.0f;
-            if (fabsf(temperature - last_logged_temp) > 0.5f) {
-                last_logged_temp = temperature;
-            }
-        } else {
-            ESP_LOGE(TAG, "Failed to update temperature attribute: %s", esp_err_to_name(ret));
-        }
+        board_temperature_c = temperature;
+        bool staged = sensor_cycle_stage_policy(REPORT_POLICY_TEMPERATURE, 0, temp_centidegrees, HA_ESP_BME280_ENDPOINT,
+                                                ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+                                                &temp_centidegrees, sizeof(temp_centidegrees));
+        ESP_LOGI(TAG, "🌡️ Temperature: %.2f°C [%s] (%s)", temperature, sensor_source_name(sample.temperature_src),
+                 staged ? "staged" : "held back by policy");
     } else {
-        ESP_LOGW(TAG, "sensor_read_temperature failed: %s", esp_err_to_name(ret));
+        ESP_LOGW(TAG, "Temperature not available this cycle");
     }
 
-    /* Read humidity (may be unavailable on some sensor combos) */
-    ret = sensor_read_humidity(&humidity);
-    if (ret == ESP_OK) {
+    /* Humidity (may be unavailable on some sensor combos) */
+    if (sample.valid & SENSOR_CH_HUMIDITY) {
+        float humidity = sample.humidity_pct;
         uint16_t hum_centipercent = (uint16_t)(humidity * 100);
-        if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-            ret = esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
-                                               ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
-                                               &hum_centipercent, force_report);
-            esp_zb_lock_release();
-        } else {
-            ret = ESP_FAIL;
-        }
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "💧 Humidity: %.2f%% (attribute updated)", humidity);
-
-            static float last_logged_hum = -999.0f;
-            if (fabsf(humidity - last_logged_hum) > 2.0f) {
-                last_logged_hum = humidity;
-            }
-        } else {
-            ESP_LOGE(TAG, "Failed to update humidity attribute: %s", esp_err_to_name(ret));
-        }
-    } else if (ret == ESP_ERR_NOT_SUPPORTED || ret == ESP_ERR_NOT_FOUND) {
-        ESP_LOGD(TAG, "Humidity not available from detected sensor (code=%s)", esp_err_to_name(ret));
+        bool staged = sensor_cycle_stage_policy(REPORT_POLICY_HUMIDITY, 0, hum_centipercent, HA_ESP_BME280_ENDPOINT,
+                                                ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
+                                                ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
+                                                &hum_centipercent, sizeof(hum_centipercent));
+        ESP_LOGI(TAG, "💧 Humidity: %.2f%% [%s] (%s)", humidity, sensor_source_name(sample.humidity_src),
+                 staged ? "staged" : "held back by policy");
     } else {
-        ESP_LOGW(TAG, "sensor_read_humidity failed: %s", esp_err_to_name(ret));
+        ESP_LOGD(TAG, "Humidity not available from detected sensor");
     }
 
-    /* Read pressure */
-    ret = sensor_read_pressure(&pressure);
-    if (ret == ESP_OK) {
+    /* Pressure */
+    if (sample.valid & SENSOR_CH_PRESSURE) {
+        float pressure = sample.pressure_hpa;
         int16_t pressure_zigbee = (int16_t)(pressure * 10); // hPa -> 0.1 kPa units
-        if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-            ret = esp_zb_zcl_set_attribute_val(HA_ESP_BME280_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT,
-                                               ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_PRESSURE_MEASUREMENT_VALUE_ID,
-                                               &pressure_zigbee, force_report);
-            esp_zb_lock_release();
-        } else {
-            ret = ESP_FAIL;
-        }
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "🌪️  Pressure: %.2f hPa (raw: %d x0.1kPa - attribute updated)", pressure, pressure_zigbee);
-        } else {
-            ESP_LOGE(TAG, "Failed to update pressure attribute: %s", esp_err_to_name(ret));
-        }
-    } else if (ret == ESP_ERR_NOT_SUPPORTED || ret == ESP_ERR_NOT_FOUND) {
-        ESP_LOGW(TAG, "⚠️  Pressure not available from detected sensor (code=%s)", esp_err_to_name(ret));
+        bool staged = sensor_cycle_stage_policy(REPORT_POLICY_PRESSURE, 0, pressure_zigbee, HA_ESP_BME280_ENDPOINT,
+                                                ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT,
+                                                ESP_ZB_ZCL_ATTR_PRESSURE_MEASUREMENT_VALUE_ID,
+                                                &pressure_zigbee, sizeof(pressure_zigbee));
+        ESP_LOGI(TAG, "🌪️  Pressure: %.2f hPa [%s] (raw: %d x0.1kPa - %s)", pressure,
+                 sensor_source_name(sample.pressure_src), pressure_zigbee, staged ? "staged" : "held back by policy");
     } else {
-        ESP_LOGW(TAG, "sensor_read_pressure failed: %s", esp_err_to_name(ret));
+        ESP_LOGW(TAG, "Pressure not available this cycle");
     }
     
+    sensor_update_diag_attributes();
+    
     /* BME280 automatically returns to sleep mode after forced measurement.
      * No explicit sleep call needed - sensor is already in low-power state. */
     
@@ -1496,7 +1811,7 @@ static void bme280_read_and_report(uint8_t param)
      * configure automatic reporting, while coordinator config can provide
      * additional event-driven reporting based on value changes.
      */
-    ESP_LOGI(TAG, "📊 Sensor data reported. Device will enter light sleep until next event.");
+    ESP_LOGI(TAG, "📊 Sensor data staged for this cycle's report.");
     
     static uint32_t report_count = 0;
     report_count++;
@@ -1520,7 +1835,7 @@ static void periodic_sensor_report_callback(void *arg)
         /* CRITICAL: Trigger sensor reading task instead of using Zigbee scheduler.
          * Sensor I2C operations contain vTaskDelay() which CANNOT be called from
          * Zigbee scheduler context - causes deadlocks and device freeze! */
-        uint8_t trigger = 1;
+        uint8_t trigger = SENSOR_TRIGGER_REPORT;
         if (sensor_read_queue != NULL) {
             xQueueSend(sensor_read_queue, &trigger, 0);
         }
@@ -1612,662 +1927,284 @@ static void stop_periodic_reading(void)
     }
 }
 
-/* Rain gauge implementation */
-static void IRAM_ATTR rain_gauge_isr_handler(void *arg)
+/* Exact channel total as a Metering summation (1e-6 units, saturating at 48 bits) */
+static esp_zb_uint48_t counter_summation(const counter_channel_config_t *ch, uint32_t pulses)
 {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-
-    // ISR-safe: just increment a counter for debugging (can view in logs after interrupt)
-    static uint32_t isr_trigger_count = 0;
-    isr_trigger_count++;
-
-    /* Prepare event with ISR tick for accurate timing */
-    rain_evt_t evt = {
-        .type = RAIN_EVENT_PULSE,
-        .tick = xTaskGetTickCountFromISR(),
-        .force_nvs = false,
-        .force_attribute = false,
-    };
-    
-    /* Only queue event if there's space - prevents overflow from rapid pulses */
-    if (xQueueSendFromISR(rain_gauge_evt_queue, &evt, &xHigherPriorityTaskWoken) != pdPASS) {
-        /* Queue full - pulse will be lost but prevents crash */
-        static uint32_t queue_overflow_count = 0;
-        queue_overflow_count++;
-    }
-    
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
+    uint64_t micro = counter_channel_micro_units(ch, pulses);
+    if (micro > 0xFFFFFFFFFFFFULL) {
+        micro = 0xFFFFFFFFFFFFULL;
     }
+    return (esp_zb_uint48_t){ .low = (uint32_t)micro, .high = (uint16_t)(micro >> 32) };
 }
 
-static void rain_gauge_task(void *arg)
+/* Counter channel publisher (counter task): set the channel's Analog Input present value
+ * and Metering summation. Only the network connection is checked, not the online state,
+ * so periodic forced updates still reach the stack while the GPIO interrupts are disabled. */
+static void counter_publish(size_t index, const counter_channel_config_t *ch, float total, uint32_t pulses)
 {
-    rain_evt_t evt;
-    TickType_t last_pulse_time = 0;
-    uint32_t pending_pulse_count = 0;
-    bool pending_nvs_flush = false;
-    bool pending_attr_flush = false;
-    const TickType_t DEBOUNCE_TIME = pdMS_TO_TICKS(200); // 200ms debounce
-
-    ESP_LOGI(RAIN_TAG, "Rain gauge task started, waiting for events...");
-
-    for (;;) {
-        // Use 10 second timeout instead of portMAX_DELAY to allow watchdog and health checks
-        if (xQueueReceive(rain_gauge_evt_queue, &evt, pdMS_TO_TICKS(10000))) {
-            switch (evt.type) {
-            case RAIN_EVENT_PULSE: {
-                TickType_t current_time = evt.tick;
-
-                if ((current_time - last_pulse_time) > DEBOUNCE_TIME) {
-                    last_pulse_time = current_time;
-                    pending_pulse_count++;
-                    rain_pulse_count++;
-                    total_rainfall_mm += RAIN_MM_PER_PULSE;
-                    total_rainfall_mm = roundf(total_rainfall_mm * 100.0f) / 100.0f;
-
-                    ESP_LOGI(RAIN_TAG, "🌧️ Rain pulse #%u: %.2f mm total (+%.2f mm)",
-                             rain_pulse_count, total_rainfall_mm, RAIN_MM_PER_PULSE);
-                    
-                    pending_nvs_flush = true;
-                    if (rain_gauge_enabled && zigbee_network_connected) {
-                        pending_attr_flush = true;
-                    }
-
-                    if (pending_pulse_count >= RAIN_PULSE_FLUSH_THRESHOLD) {
-                        ESP_LOGD(RAIN_TAG, "Pulse threshold reached (%u) - flushing totals", pending_pulse_count);
-                        rain_gauge_flush_totals(pending_nvs_flush, pending_attr_flush);
-                        pending_pulse_count = 0;
-                        pending_nvs_flush = false;
-                        pending_attr_flush = false;
-                        if (rain_flush_timer != NULL) {
-                            esp_timer_stop(rain_flush_timer);
-                        }
-                    } else {
-                        if (rain_flush_timer != NULL) {
-                            esp_timer_stop(rain_flush_timer);
-                            esp_timer_start_once(rain_flush_timer, RAIN_FLUSH_INTERVAL_US);
-                        }
-                    }
-                } else {
-                    ESP_LOGD(RAIN_TAG, "Pulse ignored - debounce active (%u ms)",
-                             pdTICKS_TO_MS(current_time - last_pulse_time));
-                }
-                break;
-            }
-
-            case RAIN_EVENT_FLUSH: {
-                bool do_nvs = pending_nvs_flush || evt.force_nvs;
-                bool do_attr = pending_attr_flush || evt.force_attribute;
+    if (!zigbee_network_connected) {
+        ESP_LOGW(ch->name, "Skipping Zigbee update - network not connected");
+        return;
+    }
 
-                if (do_nvs || do_attr) {
-                    rain_gauge_flush_totals(do_nvs, do_attr);
-                    pending_pulse_count = 0;
-                    pending_nvs_flush = false;
-                    pending_attr_flush = false;
-                }
-                if (rain_flush_timer != NULL) {
-                    esp_timer_stop(rain_flush_timer);
-                }
-                break;
-            }
+    esp_zb_uint48_t summation = counter_summation(ch, pulses);
+    esp_err_t ret = attr_queue_push(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
+                                    ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID, &total, sizeof(total));
+    if (ret == ESP_OK) {
+        ret = attr_queue_push(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                              ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID, &summation, sizeof(summation));
+    }
+    attr_queue_flush();
 
-            default:
-                break;
-            }
-        }
+    if (ret == ESP_OK) {
+        ESP_LOGI(ch->name, "📡 EP%u attribute queued: %.2f (%lu pulses)", ch->endpoint, total, (unsigned long)pulses);
+    } else {
+        ESP_LOGE(ch->name, "❌ Failed to queue attribute: %s", esp_err_to_name(ret));
     }
 }
 
-static void rain_flush_timer_callback(void *arg)
+/* Rain rate attributes (0.1 mm/h) on EP2. Only set when rain_rate_poll() sees an
+ * intensity change, so the configured reportable change of 1 sends them at once
+ * during bursts and nothing at all while it stays dry. */
+static uint16_t rain_rate_to_zb(float mm_h)
 {
-    rain_gauge_request_flush(false, false);
+    long v = lroundf(mm_h * 10.0f);
+    return v > 0xFFFE ? 0xFFFE : (uint16_t)v;
 }
 
-static void rain_gauge_request_flush(bool force_nvs, bool force_attribute)
+static void rain_rate_report(void)
 {
-    if (rain_gauge_evt_queue == NULL) {
+    rain_rate_t rate;
+    if (!rain_rate_poll(&rate) || !zigbee_network_connected) {
         return;
     }
-
-    rain_evt_t evt = {
-        .type = RAIN_EVENT_FLUSH,
-        .tick = xTaskGetTickCount(),
-        .force_nvs = force_nvs,
-        .force_attribute = force_attribute,
-    };
-
-    if (xQueueSend(rain_gauge_evt_queue, &evt, 0) != pdPASS) {
-        ESP_LOGW(RAIN_TAG, "Failed to queue rain flush event (queue full)");
+    uint16_t instant = rain_rate_to_zb(rate.instant_mm_h);
+    uint16_t rate_10min = rain_rate_to_zb(rate.rate_10min_mm_h);
+    uint16_t rate_1h = rain_rate_to_zb(rate.rate_1h_mm_h);
+    esp_err_t ret = attr_queue_push(HA_ESP_RAIN_GAUGE_ENDPOINT, CAELUM_RAIN_RATE_CLUSTER_ID, CAELUM_ATTR_RAIN_RATE,
+                                    &instant, sizeof(instant));
+    if (ret == ESP_OK) {
+        ret = attr_queue_push(HA_ESP_RAIN_GAUGE_ENDPOINT, CAELUM_RAIN_RATE_CLUSTER_ID, CAELUM_ATTR_RAIN_RATE_10MIN,
+                              &rate_10min, sizeof(rate_10min));
     }
-}
-
-static void rain_gauge_flush_totals(bool save_to_nvs, bool update_attribute)
-{
-    float rounded_rainfall = roundf(total_rainfall_mm * 100.0f) / 100.0f;
-
-    if (save_to_nvs) {
-        ESP_LOGI(RAIN_TAG, "💾 Flushing rain totals to storage: %.2f mm (%u pulses)",
-                 rounded_rainfall, rain_pulse_count);
-        save_rainfall_data(rounded_rainfall, rain_pulse_count);
+    if (ret == ESP_OK) {
+        ret = attr_queue_push(HA_ESP_RAIN_GAUGE_ENDPOINT, CAELUM_RAIN_RATE_CLUSTER_ID, CAELUM_ATTR_RAIN_RATE_1H,
+                              &rate_1h, sizeof(rate_1h));
     }
-
-    if (update_attribute) {
-        /* Only check network connection, not ISR enabled state
-         * This allows periodic updates even when ISR is temporarily disabled */
-        if (!zigbee_network_connected) {
-            ESP_LOGW(RAIN_TAG, "Skipping Zigbee update - network not connected");
-            return;
-        }
-
-        if (!esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-            ESP_LOGW(RAIN_TAG, "Failed to acquire Zigbee lock for rain attribute update");
-            return;
-        }
-        esp_err_t ret = esp_zb_zcl_set_attribute_val(
-            HA_ESP_RAIN_GAUGE_ENDPOINT,
-            ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-            ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
-            &rounded_rainfall,
-            false);
-        esp_zb_lock_release();
-
-        if (ret == ESP_OK) {
-            ESP_LOGI(RAIN_TAG, "📡 Rain gauge attribute updated: %.2f mm (%u pulses)", rounded_rainfall, rain_pulse_count);
-        } else {
-            ESP_LOGE(RAIN_TAG, "❌ Failed to update rain attribute: %s", esp_err_to_name(ret));
-        }
+    attr_queue_flush();
+    if (ret != ESP_OK) {
+        return;                         // Not committed: the next poll tries again
     }
+    rain_rate_commit(&rate);
+    ESP_LOGI(TAG, "🌧️ Rain rate: %.1f mm/h now, %.1f mm/h (10 min), %.1f mm/h (1 h)",
+             rate.instant_mm_h, rate.rate_10min_mm_h, rate.rate_1h_mm_h);
 }
 
-static void rain_gauge_enable_isr(void)
+/* Rain channel hook (counter task): every accepted tip goes into the rate window */
+static void rain_tips_recorded(size_t index, uint32_t tips, uint32_t tick_ms)
 {
-    ESP_LOGI(RAIN_TAG, "🔧 Enabling rain gauge ISR on GPIO%d (installed: %s)", RAIN_GAUGE_GPIO, rain_gauge_isr_installed ? "YES" : "NO");
+    rain_rate_record(tips, tick_ms);
+    rain_rate_report();
+}
 
-    if (rain_gauge_evt_queue == NULL) {
-        ESP_LOGE(RAIN_TAG, "Cannot enable rain gauge ISR: event queue not initialized");
-        return;
-    }
+/* Battery monitoring functions */
+static const char *BATTERY_TAG = "BATTERY";
 
-    if (!ensure_gpio_isr_service_installed(RAIN_TAG, "rain gauge")) {
-        return;
-    }
-    
-    // Set enabled flag first
-    rain_gauge_enabled = true;
-    
-    // Add ISR handler (will succeed even if already added)
-    esp_err_t ret = gpio_isr_handler_add(RAIN_GAUGE_GPIO, rain_gauge_isr_handler, NULL);
-    if (ret == ESP_OK) {
-        rain_gauge_isr_installed = true;
-        ESP_LOGI(RAIN_TAG, "✅ Rain gauge ISR enabled successfully on GPIO%d", RAIN_GAUGE_GPIO);
-        /* Ensure interrupt line is enabled so events will be delivered */
-        gpio_intr_enable(RAIN_GAUGE_GPIO);
-    } else if (ret == ESP_ERR_INVALID_STATE) {
-        // ISR already installed - this is fine
-        rain_gauge_isr_installed = true;
-        ESP_LOGI(RAIN_TAG, "✅ Rain gauge ISR already installed, now enabled");
-        /* Make sure the interrupt line is enabled in case it was disabled */
-        gpio_intr_enable(RAIN_GAUGE_GPIO);
-    } else {
-        ESP_LOGE(RAIN_TAG, "❌ Failed to enable rain gauge ISR: %s", esp_err_to_name(ret));
-    }
-    
-    // Test GPIO level at enable time
-    int current_level = gpio_get_level(RAIN_GAUGE_GPIO);
-    ESP_LOGI(RAIN_TAG, "🔌 Current GPIO%d level at enable: %d", RAIN_GAUGE_GPIO, current_level);
+#define BATTERY_READ_INTERVAL_SEC    3600    // ADC read once per hour
+#define BATTERY_NVS_CHECKPOINT_SEC   86400   // Rewrite unchanged values to NVS at most once a day
+#define BATTERY_NVS_PCT_HYSTERESIS   4       // Zigbee percentage units (0.5% each) that count as a change
+#define BATTERY_STATE_MAGIC          0xBA77E001
+
+/* Last battery reading, kept in RTC memory so the 5-minute cycles that skip the
+ * ADC do not touch NVS. NVS only gets the values when they really change or at
+ * the daily checkpoint; it seeds this record after a cold boot. */
+typedef struct {
+    uint32_t magic;
+    uint32_t read_time_sec;     // esp_timer seconds of the last ADC read
+    uint32_t persist_time_sec;  // esp_timer seconds of the last NVS write
+    float voltage;
+    float percentage;
+    uint8_t zb_voltage;
+    uint8_t zb_percentage;
+    uint8_t nvs_zb_voltage;     // Values last committed to NVS
+    uint8_t nvs_zb_percentage;
+    uint32_t crc;
+} battery_state_t;
+
+static RTC_DATA_ATTR battery_state_t battery_state;
+
+static uint32_t battery_state_crc(const battery_state_t *state)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(battery_state_t, crc));
 }
 
-static void rain_gauge_disable_isr(void)
+static bool battery_state_valid(void)
 {
-    if (rain_gauge_isr_installed) {
-        /* Do not remove the ISR handler here; removing the handler causes a
-         * gap where pulses cannot be queued. Instead, disable the GPIO
-         * interrupt line so the handler remains installed and can capture
-         * events when re-enabled. */
-        gpio_intr_disable(RAIN_GAUGE_GPIO);
-        rain_gauge_enabled = false;
-        ESP_LOGI(RAIN_TAG, "Rain gauge interrupts disabled (handler kept)");
-    } else {
-        rain_gauge_enabled = false;
-        ESP_LOGI(RAIN_TAG, "Rain gauge ISR already disabled");
-    }
+    return battery_state.magic == BATTERY_STATE_MAGIC &&
+           battery_state.crc == battery_state_crc(&battery_state);
+}
 
-    /* Persist any accumulated rainfall before going idle */
-    rain_gauge_request_flush(true, false);
+static void battery_state_seal(void)
+{
+    battery_state.magic = BATTERY_STATE_MAGIC;
+    battery_state.crc = battery_state_crc(&battery_state);
 }
 
-/* Battery monitoring functions */
-static const char *BATTERY_TAG = "BATTERY";
+/* Seed the RTC record from NVS (one namespace open). Returns false if NVS holds no
+ * reading either, i.e. the device has never measured its battery. */
+static bool battery_state_load_nvs(void)
+{
+    memset(&battery_state, 0, sizeof(battery_state));
+    nvs_handle_t nvs_handle;
+    if (nvs_open("storage", NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(float);
+    bool found = nvs_get_u8(nvs_handle, "batt_zb_v", &battery_state.zb_voltage) == ESP_OK;
+    nvs_get_u8(nvs_handle, "batt_zb_p", &battery_state.zb_percentage);
+    nvs_get_blob(nvs_handle, "batt_v", &battery_state.voltage, &len);
+    len = sizeof(float);
+    nvs_get_blob(nvs_handle, "batt_pct", &battery_state.percentage, &len);
+    nvs_close(nvs_handle);
+    battery_state.nvs_zb_voltage = battery_state.zb_voltage;
+    battery_state.nvs_zb_percentage = battery_state.zb_percentage;
+    if (found) {
+        battery_state_seal();
+    }
+    return found;
+}
 
-#define BATTERY_ADC_CHANNEL     ADC_CHANNEL_4    // GPIO4 on ESP32-H2
-#define BATTERY_ADC_UNIT        ADC_UNIT_1       // ADC1 on ESP32-H2
-#define BATTERY_ADC_ATTEN       ADC_ATTEN_DB_12  // 0-3.1V range (ESP32-H2: actually 0-2.5V)
-
-// For Li-Ion battery monitoring via voltage divider:
-// Hardware: R1=100kΩ, R2=100kΩ → theoretical divider = 2.0
-// However, ESP32-H2 ADC calibration has issues with DB_12 attenuation
-// Empirical calibration: ADC reads 1300mV when actual is 2085mV
-// Correction factor: 2085/1300 = 1.604
-#define BATTERY_VOLTAGE_DIVIDER 2.0f             // Hardware divider (R1≈R2≈100kΩ)
-#define BATTERY_ADC_CORRECTION  1.604f           // ADC calibration correction for ESP32-H2
-#define BATTERY_MIN_VOLTAGE     2.7f             // Li-Ion minimum safe voltage (V)
-#define BATTERY_MAX_VOLTAGE     4.2f             // Li-Ion maximum voltage (V)
-
-// ADC handles
-static adc_oneshot_unit_handle_t adc_handle = NULL;
-static adc_cali_handle_t adc_cali_handle = NULL;
-
-// Initialize ADC for battery monitoring
-static esp_err_t battery_adc_init(void)
+/* Write the reading to NVS in one commit if it moved by a Zigbee voltage step or
+ * BATTERY_NVS_PCT_HYSTERESIS, or the checkpoint interval has passed */
+static void battery_state_persist(uint32_t now_sec)
 {
-    // Configure ADC1
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = BATTERY_ADC_UNIT,
-        .ulp_mode = ADC_ULP_MODE_DISABLE,
-    };
-    esp_err_t ret = adc_oneshot_new_unit(&init_config, &adc_handle);
-    if (ret == ESP_ERR_NOT_FOUND || ret == ESP_ERR_INVALID_STATE) {
-        // ADC already initialized - try to continue without creating new unit
-        ESP_LOGW(BATTERY_TAG, "ADC1 already in use, attempting to use without calibration");
-        adc_handle = NULL;  // Will use fallback in battery_read_and_report
-        return ESP_OK;  // Don't fail, just use simulated values
-    } else if (ret != ESP_OK) {
-        ESP_LOGE(BATTERY_TAG, "Failed to initialize ADC unit: %s", esp_err_to_name(ret));
-        return ret;
-    }
-    
-    // Configure ADC channel
-    adc_oneshot_chan_cfg_t chan_config = {
-        .atten = BATTERY_ADC_ATTEN,
-        .bitwidth = ADC_BITWIDTH_DEFAULT,
-    };
-    ret = adc_oneshot_config_channel(adc_handle, BATTERY_ADC_CHANNEL, &chan_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(BATTERY_TAG, "Failed to configure ADC channel: %s", esp_err_to_name(ret));
-        return ret;
-    }
-    
-    // Initialize ADC calibration
-#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
-    adc_cali_curve_fitting_config_t cali_config = {
-        .unit_id = BATTERY_ADC_UNIT,
-        .atten = BATTERY_ADC_ATTEN,
-        .bitwidth = ADC_BITWIDTH_DEFAULT,
-    };
-    ret = adc_cali_create_scheme_curve_fitting(&cali_config, &adc_cali_handle);
-    if (ret == ESP_OK) {
-        ESP_LOGI(BATTERY_TAG, "ADC calibration scheme: Curve Fitting");
+    int pct_delta = abs((int)battery_state.zb_percentage - (int)battery_state.nvs_zb_percentage);
+    bool changed = battery_state.zb_voltage != battery_state.nvs_zb_voltage ||
+                   pct_delta >= BATTERY_NVS_PCT_HYSTERESIS;
+    bool checkpoint = battery_state.persist_time_sec == 0 || now_sec < battery_state.persist_time_sec ||
+                      now_sec - battery_state.persist_time_sec >= BATTERY_NVS_CHECKPOINT_SEC;
+    if (!changed && !checkpoint) {
+        ESP_LOGI(BATTERY_TAG, "💾 Battery values unchanged (%u, %u) - NVS write skipped",
+                 battery_state.zb_voltage, battery_state.zb_percentage);
+        return;
     }
-#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
-    adc_cali_line_fitting_config_t cali_config = {
-        .unit_id = BATTERY_ADC_UNIT,
-        .atten = BATTERY_ADC_ATTEN,
-        .bitwidth = ADC_BITWIDTH_DEFAULT,
-    };
-    ret = adc_cali_create_scheme_line_fitting(&cali_config, &adc_cali_handle);
-    if (ret == ESP_OK) {
-        ESP_LOGI(BATTERY_TAG, "ADC calibration scheme: Line Fitting");
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(BATTERY_TAG, "⚠️  NVS not available: %s", esp_err_to_name(err));
+        return;
     }
-#endif
-    
-    if (ret != ESP_OK) {
-        ESP_LOGW(BATTERY_TAG, "ADC calibration failed, using raw values: %s", esp_err_to_name(ret));
-        adc_cali_handle = NULL;
+    nvs_set_u32(nvs_handle, "batt_time", battery_state.read_time_sec);
+    nvs_set_u8(nvs_handle, "batt_zb_v", battery_state.zb_voltage);
+    nvs_set_u8(nvs_handle, "batt_zb_p", battery_state.zb_percentage);
+    nvs_set_blob(nvs_handle, "batt_v", &battery_state.voltage, sizeof(float));
+    nvs_set_blob(nvs_handle, "batt_pct", &battery_state.percentage, sizeof(float));
+    err = nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    if (err == ESP_OK) {
+        battery_state.nvs_zb_voltage = battery_state.zb_voltage;
+        battery_state.nvs_zb_percentage = battery_state.zb_percentage;
+        battery_state.persist_time_sec = now_sec;
+        ESP_LOGI(BATTERY_TAG, "💾 Battery values saved to NVS (%s)", changed ? "changed" : "checkpoint");
     }
-    
-    ESP_LOGI(BATTERY_TAG, "✅ Battery ADC initialized on GPIO4 (ADC1_CH4)");
-    return ESP_OK;
 }
 
 static void battery_read_and_report(uint8_t param)
 {
     // param: Always 0 (normal update - coordinator controls reporting)
-    // Forced reports fail after reboot because reporting config is not persisted
-    bool force_report = false;
+    // Attributes are staged and committed with the sensor cycle batch
     
     ESP_LOGI(BATTERY_TAG, "🔧 battery_read_and_report() called");
     
     /* Power optimization: Read battery only once per hour (time-based) to save ~360µAh/day
      * This ensures we read once per hour regardless of wake reason (rain vs timer).
-     * Uses NVS to persist timestamp across deep sleep. */
-    
-    const uint32_t BATTERY_READ_INTERVAL_SEC = 3600;  // 1 hour
+     * The last reading lives in RTC memory; NVS is only consulted after a cold boot. */
     
     // Get current time since boot (in seconds)
     uint32_t current_time_sec = (uint32_t)(esp_timer_get_time() / 1000000ULL);
     
     ESP_LOGI(BATTERY_TAG, "🕐 Current time since boot: %lu seconds", current_time_sec);
     
-    // Read last battery reading timestamp from NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("storage", NVS_READONLY, &nvs_handle);
-    uint32_t last_battery_read_time = 0;
     bool first_reading = false;
     bool force_read = false;
     
-    if (err == ESP_OK) {
-        err = nvs_get_u32(nvs_handle, "batt_time", &last_battery_read_time);
-        if (err != ESP_OK) {
-            first_reading = true;  // Key doesn't exist - this is the first reading
-            ESP_LOGI(BATTERY_TAG, "📝 No previous battery timestamp in NVS - first reading");
+    if (!battery_state_valid()) {
+        // Cold boot: seed the record from NVS so persistence can compare against it
+        if (battery_state_load_nvs()) {
+            ESP_LOGI(BATTERY_TAG, "📝 Battery state seeded from NVS (%u, %u) - forcing battery read",
+                     battery_state.zb_voltage, battery_state.zb_percentage);
+            force_read = true;
         } else {
-            ESP_LOGI(BATTERY_TAG, "📝 Last battery timestamp from NVS: %lu seconds", last_battery_read_time);
-            
-            // Check for reboot: if saved timestamp is close to current boot time (within 30 seconds),
-            // it means we rebooted and should force a reading
-            if (last_battery_read_time < 30 && current_time_sec < 30) {
-                ESP_LOGI(BATTERY_TAG, "🔄 Recent boot detected (both times < 30s) - forcing battery read");
-                force_read = true;
-            }
+            ESP_LOGI(BATTERY_TAG, "📝 No previous battery reading - first reading");
+            first_reading = true;
         }
-        nvs_close(nvs_handle);
+    } else if (battery_state.read_time_sec > current_time_sec) {
+        // Timer restarted (deep sleep or reset with RTC memory retained)
+        ESP_LOGI(BATTERY_TAG, "🔄 Device rebooted (timer reset detected) - forcing battery read");
+        force_read = true;
     } else {
-        first_reading = true;  // NVS not available - assume first reading
-        ESP_LOGW(BATTERY_TAG, "⚠️  NVS not available - assuming first reading");
-    }
-    
-    // Check if enough time has elapsed (skip interval check on first reading or forced read)
-    if (!first_reading && !force_read) {
-        // Handle potential timer overflow on reboot: if last_battery_read_time is much larger
-        // than current_time_sec, it means we rebooted and should read battery
-        if (last_battery_read_time > current_time_sec) {
-            ESP_LOGI(BATTERY_TAG, "🔄 Device rebooted (timer reset detected) - forcing battery read");
-            force_read = true;
-        } else {
-            uint32_t elapsed_sec = current_time_sec - last_battery_read_time;
-            ESP_LOGI(BATTERY_TAG, "⏱️  Elapsed time: %lu seconds (need %lu for next reading)", 
-                     elapsed_sec, BATTERY_READ_INTERVAL_SEC);
-            if (elapsed_sec < BATTERY_READ_INTERVAL_SEC) {
-                ESP_LOGI(BATTERY_TAG, "⏭️  Skipping battery read (%lu sec since last, need %lu)", 
-                         elapsed_sec, BATTERY_READ_INTERVAL_SEC);
-                // Read last battery values from NVS and update Zigbee attributes
-                float battery_voltage = 0.0f;
-                float percentage = 0.0f;
-                uint8_t zigbee_voltage = 0;
-                uint8_t zigbee_percentage = 0;
-                esp_err_t nvs_err = nvs_open("storage", NVS_READONLY, &nvs_handle);
-                if (nvs_err == ESP_OK) {
-                    nvs_get_u8(nvs_handle, "batt_zb_v", &zigbee_voltage);
-                    nvs_get_u8(nvs_handle, "batt_zb_p", &zigbee_percentage);
-                    nvs_get_blob(nvs_handle, "batt_v", &battery_voltage, &(size_t){sizeof(float)});
-                    nvs_get_blob(nvs_handle, "batt_pct", &percentage, &(size_t){sizeof(float)});
-                    nvs_close(nvs_handle);
-                }
-                // Update Zigbee attributes with last known values
-                if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-                    esp_zb_zcl_set_attribute_val(
-                        HA_ESP_BME280_ENDPOINT,
-                        ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                        0x0020,
-                        &zigbee_voltage,
-                        force_report);
-                    esp_zb_zcl_set_attribute_val(
-                        HA_ESP_BME280_ENDPOINT,
-                        ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                        0x0021,
-                        &zigbee_percentage,
-                        force_report);
-                    esp_zb_lock_release();
-                }
-                ESP_LOGI(BATTERY_TAG, "🔁 Restored battery values from NVS: %.2fV (%.0f%%) - Zigbee: %u, %u",
-                         battery_voltage, percentage, zigbee_voltage, zigbee_percentage);
-                return;  // Skip this reading
-            }
-            ESP_LOGI(BATTERY_TAG, "🔋 Reading battery (last read %lu sec ago)", elapsed_sec);
+        uint32_t elapsed_sec = current_time_sec - battery_state.read_time_sec;
+        ESP_LOGI(BATTERY_TAG, "⏱️  Elapsed time: %lu seconds (need %lu for next reading)",
+                 elapsed_sec, (uint32_t)BATTERY_READ_INTERVAL_SEC);
+        if (elapsed_sec < BATTERY_READ_INTERVAL_SEC) {
+            ESP_LOGI(BATTERY_TAG, "⏭️  Skipping battery read (%lu sec since last, need %lu)",
+                     elapsed_sec, (uint32_t)BATTERY_READ_INTERVAL_SEC);
+            // Update Zigbee attributes with last known values
+            uint8_t zigbee_voltage = battery_state.zb_voltage;
+            uint8_t zigbee_percentage = battery_state.zb_percentage;
+            sensor_cycle_stage_policy(REPORT_POLICY_BATTERY_VOLTAGE, 0, zigbee_voltage, HA_ESP_BME280_ENDPOINT,
+                                      ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0020, &zigbee_voltage, sizeof(zigbee_voltage));
+            sensor_cycle_stage_policy(REPORT_POLICY_BATTERY_PERCENT, 0, zigbee_percentage, HA_ESP_BME280_ENDPOINT,
+                                      ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0021, &zigbee_percentage, sizeof(zigbee_percentage));
+            ESP_LOGI(BATTERY_TAG, "🔁 Restored battery values from RTC: %.2fV (%.0f%%) - Zigbee: %u, %u",
+                     battery_state.voltage, battery_state.percentage, zigbee_voltage, zigbee_percentage);
+            return;  // Skip this reading
         }
+        ESP_LOGI(BATTERY_TAG, "🔋 Reading battery (last read %lu sec ago)", elapsed_sec);
     }
     if (first_reading) {
         ESP_LOGI(BATTERY_TAG, "🔋 Reading battery (first reading after boot/pairing)");
     } else if (force_read) {
         ESP_LOGI(BATTERY_TAG, "🔋 Reading battery (forced after reboot)");
     }
-    // Time to read battery - update timestamp in NVS
-    err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (err == ESP_OK) {
-        nvs_set_u32(nvs_handle, "batt_time", current_time_sec);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-    }
+#if BATTERY_MEASURE_UNDER_LOAD
+    /* The sensor task's synchronous commit returned just before this: the sensor
+     * attributes are written and their reports are queued for TX */
+    const battery_measure_mode_t mode = BATTERY_MEASURE_LOADED;
+#else
+    const battery_measure_mode_t mode = BATTERY_MEASURE_IDLE;
+#endif
     float battery_voltage = 0.0f;
-    /* Re-init ADC if it was released after previous read */
-    if (adc_handle == NULL) {
-        battery_adc_init();
-    }
-    if (adc_handle == NULL) {
-        ESP_LOGE(BATTERY_TAG, "ADC not initialized, using simulated value");
-        battery_voltage = 3.7f;  // Fallback simulated value
-    } else {
-        /* Power optimization: Reduced from 10 to 3 samples (better accuracy, still low power) */
-        const int num_samples = 3;
-        int voltage_sum = 0;
-        int raw_sum = 0;
-        for (int i = 0; i < num_samples; i++) {
-            int adc_raw;
-            esp_err_t ret = adc_oneshot_read(adc_handle, BATTERY_ADC_CHANNEL, &adc_raw);
-            if (ret != ESP_OK) {
-                ESP_LOGE(BATTERY_TAG, "ADC read failed: %s", esp_err_to_name(ret));
-                battery_voltage = 3.7f;  // Fallback value
-                goto skip_adc;
-            }
-            raw_sum += adc_raw;  // Track raw ADC values for debugging
-            int voltage_mv;
-            if (adc_cali_handle != NULL) {
-                ret = adc_cali_raw_to_voltage(adc_cali_handle, adc_raw, &voltage_mv);
-                if (ret != ESP_OK) {
-                    ESP_LOGE(BATTERY_TAG, "ADC calibration failed: %s", esp_err_to_name(ret));
-                    // Fallback: rough calculation
-                    voltage_mv = (adc_raw * 2500) / 4095;
-                }
-                // Apply ESP32-H2 ADC correction factor (empirically determined)
-                voltage_mv = (int)((float)voltage_mv * BATTERY_ADC_CORRECTION);
-            } else {
-                // No calibration available
-                voltage_mv = (adc_raw * 2500) / 4095;
-                voltage_mv = (int)((float)voltage_mv * BATTERY_ADC_CORRECTION);
-            }
-            voltage_sum += voltage_mv;
-            /* Power optimization: Removed 10ms delay - ADC can sample back-to-back (saves ~90% overhead) */
+    esp_err_t err = battery_measure(mode, &battery_voltage);
+    if (err != ESP_OK) {
+        ESP_LOGE(BATTERY_TAG, "Battery measurement failed: %s", esp_err_to_name(err));
+        if (!battery_state_valid()) {
+            return;  // Nothing to report, retry next cycle
         }
-        // Calculate average voltage at ADC input (in volts)
-        float adc_voltage = (voltage_sum / num_samples) / 1000.0f;
-        int avg_raw = raw_sum / num_samples;
-        // Apply voltage divider multiplier to get actual battery voltage
-        battery_voltage = adc_voltage * BATTERY_VOLTAGE_DIVIDER;
-        ESP_LOGI(BATTERY_TAG, "📊 ADC raw avg: %d, calibrated: %dmV (%.3fV) → Battery: %.2fV", 
-                 avg_raw, voltage_sum / num_samples, adc_voltage, battery_voltage);
-    }
-skip_adc:
-    // Calculate battery percentage (0-100%) using Li-Ion discharge curve
-    // Li-Ion voltage curve is fairly linear between 3.0V-4.2V
-    float percentage = ((battery_voltage - BATTERY_MIN_VOLTAGE) / (BATTERY_MAX_VOLTAGE - BATTERY_MIN_VOLTAGE)) * 100.0f;
-    if (percentage > 100.0f) percentage = 100.0f;
-    if (percentage < 0.0f) percentage = 0.0f;
+        battery_voltage = battery_state.voltage;  // Keep the last good reading
+    }
+    // Li-Ion discharge curve lookup, compensated with the onboard temperature
+    float percentage = battery_soc_percent(battery_voltage, board_temperature_c);
     // Zigbee uses different units:
     // - Battery voltage: 0.1V units (e.g., 30 = 3.0V)
     // - Battery percentage: 0-200 scale (200 = 100%, 100 = 50%)
-    uint8_t zigbee_voltage = (uint8_t)(battery_voltage * 10.0f);
-    uint8_t zigbee_percentage = (uint8_t)(percentage * 2.0f);
-    // Store last measured values in NVS
-    err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (err == ESP_OK) {
-        nvs_set_u8(nvs_handle, "batt_zb_v", zigbee_voltage);
-        nvs_set_u8(nvs_handle, "batt_zb_p", zigbee_percentage);
-        nvs_set_blob(nvs_handle, "batt_v", &battery_voltage, sizeof(float));
-        nvs_set_blob(nvs_handle, "batt_pct", &percentage, sizeof(float));
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-    }
-    // Update battery voltage (0x0020) and percentage (0x0021) attributes
-    if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-        esp_err_t ret = esp_zb_zcl_set_attribute_val(
-            HA_ESP_BME280_ENDPOINT,
-            ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-            0x0020,
-            &zigbee_voltage,
-            force_report
-        );
-        if (ret != ESP_OK) {
-            ESP_LOGE(BATTERY_TAG, "❌ Failed to update battery voltage: %s", esp_err_to_name(ret));
-        }
-        ret = esp_zb_zcl_set_attribute_val(
-            HA_ESP_BME280_ENDPOINT,
-            ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-            0x0021,
-            &zigbee_percentage,
-            force_report
-        );
-        if (ret != ESP_OK) {
-            ESP_LOGE(BATTERY_TAG, "❌ Failed to update battery percentage: %s", esp_err_to_name(ret));
-        }
-        esp_zb_lock_release();
-    } else {
-        ESP_LOGW(BATTERY_TAG, "Failed to acquire Zigbee lock for battery attribute update");
-    }
-    ESP_LOGI(BATTERY_TAG, "🔋 Li-Ion Battery: %.2fV (%.0f%%) (attributes updated)",
-             battery_voltage, percentage);
-
-    /* Power optimization: release ADC peripheral so it can power down during sleep */
-    if (adc_handle != NULL) {
-        adc_oneshot_del_unit(adc_handle);
-        adc_handle = NULL;
-    }
-    if (adc_cali_handle != NULL) {
-#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
-        adc_cali_delete_scheme_curve_fitting(adc_cali_handle);
-#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
-        adc_cali_delete_scheme_line_fitting(adc_cali_handle);
-#endif
-        adc_cali_handle = NULL;
-    }
-}
-
-/* Rain gauge initialization and handlers */
-static void rain_gauge_init(void)
-{
-    ESP_LOGI(RAIN_TAG, "Initializing rain gauge on GPIO%d (disabled until network connection)", RAIN_GAUGE_GPIO);
-    
-    /* Start disabled - will be enabled when connected to network */
-    rain_gauge_enabled = false;
-    
-    /* Note: Rainfall data already loaded in esp_zb_task() before cluster creation.
-     * The global variables total_rainfall_mm and rain_pulse_count are already set.
-     * This ensures the Zigbee cluster is initialized with the correct value. */
-    ESP_LOGI(RAIN_TAG, "Current rainfall total: %.2f mm (%lu pulses)", total_rainfall_mm, rain_pulse_count);
-    
-    /* Check wake reason and count the wake-causing pulse if present. Record
-     * the tick so we can avoid a duplicate count if an ISR event for the
-     * same edge is queued immediately after. */
-    wake_reason_t wake_reason = check_wake_reason();
-    if (wake_reason == WAKE_REASON_RAIN) {
-        rain_pulse_count++;
-        total_rainfall_mm += RAIN_MM_PER_PULSE;
-        total_rainfall_mm = roundf(total_rainfall_mm * 100.0f) / 100.0f; // Round to 2 decimals
-
-        ESP_LOGI(RAIN_TAG, "🌧️ Rain pulse detected during sleep! Pulse #%u, Total: %.2f mm (+%.2f mm)", 
-                 rain_pulse_count, total_rainfall_mm, RAIN_MM_PER_PULSE);
-
-        // Save to NVS immediately when waking from rain
-        save_rainfall_data(total_rainfall_mm, rain_pulse_count);
-    }
-    
-    /* Configure GPIO for rain gauge */
-    gpio_config_t io_conf = {
-        .intr_type = GPIO_INTR_POSEDGE,  // Interrupt on rising edge
-        .pin_bit_mask = (1ULL << RAIN_GAUGE_GPIO),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = 0,   // No pull-up needed
-        .pull_down_en = 1, // Enable internal pull-down for additional noise protection
-    };
-    esp_err_t ret = gpio_config(&io_conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(RAIN_TAG, "Failed to configure GPIO%d: %s", RAIN_GAUGE_GPIO, esp_err_to_name(ret));
-        return;
-    }
-    
-    ESP_LOGI(RAIN_TAG, "✅ GPIO%d configured successfully", RAIN_GAUGE_GPIO);
-    
-    /* Enable GPIO wakeup for light sleep - allows rain pulses to wake device */
-    ret = gpio_wakeup_enable(RAIN_GAUGE_GPIO, GPIO_INTR_HIGH_LEVEL);
-    if (ret == ESP_OK) {
-        ESP_LOGI(RAIN_TAG, "✅ GPIO%d configured as light sleep wake source", RAIN_GAUGE_GPIO);
-    } else {
-        ESP_LOGW(RAIN_TAG, "⚠️ Failed to enable GPIO wake: %s", esp_err_to_name(ret));
-    }
-    
-    // Check initial GPIO state
-    int initial_level = gpio_get_level(RAIN_GAUGE_GPIO);
-    ESP_LOGI(RAIN_TAG, "🔌 Initial GPIO%d level: %d (with pull-down)", RAIN_GAUGE_GPIO, initial_level);
-    
-    /* Create queue for rain events (GPIO pulses + flush requests) */
-    rain_gauge_evt_queue = xQueueCreate(32, sizeof(rain_evt_t));
-    if (!rain_gauge_evt_queue) {
-        ESP_LOGE(RAIN_TAG, "Failed to create event queue");
-        return;
-    }
-
-    /* Create timer used to flush accumulated pulses */
-    const esp_timer_create_args_t flush_timer_args = {
-        .callback = rain_flush_timer_callback,
-        .name = "rain_flush"
-    };
-    if (esp_timer_create(&flush_timer_args, &rain_flush_timer) != ESP_OK) {
-        ESP_LOGE(RAIN_TAG, "Failed to create rain flush timer");
-        return;
-    }
-    
-    /* Install GPIO ISR service if not already installed */
-    esp_err_t isr_ret = gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
-    if (isr_ret == ESP_ERR_INVALID_STATE) {
-        ESP_LOGD(RAIN_TAG, "GPIO ISR service already installed (shared with button driver)");
-    } else if (isr_ret != ESP_OK) {
-        ESP_LOGE(RAIN_TAG, "Failed to install ISR service: %s", esp_err_to_name(isr_ret));
-        return;
-    } else {
-        ESP_LOGD(RAIN_TAG, "GPIO ISR service installed successfully");
-    }
-    
-    /* Install ISR handler now so pulses occurring after wake (but before
-     * Zigbee network reconnect) are captured and queued. We still keep
-     * `rain_gauge_enabled` false so reporting is deferred until connected.
-     */
-    esp_err_t add_ret = gpio_isr_handler_add(RAIN_GAUGE_GPIO, rain_gauge_isr_handler, NULL);
-    if (add_ret == ESP_OK) {
-        rain_gauge_isr_installed = true;
-        /* CRITICAL: Enable GPIO interrupt immediately after installing handler!
-         * Without this, pulses won't be detected even though handler is installed. */
-        gpio_intr_enable(RAIN_GAUGE_GPIO);
-        ESP_LOGI(RAIN_TAG, "✅ ISR handler installed early on GPIO%d (will count pulses while offline)", RAIN_GAUGE_GPIO);
-    } else if (add_ret == ESP_ERR_INVALID_STATE) {
-        /* Already installed by some other initialization path - treat as installed */
-        rain_gauge_isr_installed = true;
-        /* Make sure interrupt is enabled even if handler was already present */
-        gpio_intr_enable(RAIN_GAUGE_GPIO);
-        ESP_LOGI(RAIN_TAG, "ℹ️ ISR handler already present for GPIO%d (counting will occur)", RAIN_GAUGE_GPIO);
-    } else {
-        ESP_LOGW(RAIN_TAG, "⚠️ Failed to add ISR handler early: %s - pulses while offline may be missed", esp_err_to_name(add_ret));
-    }
-    ESP_LOGI(RAIN_TAG, "Rain gauge GPIO configured; ISR installed and interrupt enabled for offline counting");
-    
-    /* Create rain gauge task */
-    BaseType_t rain_task_ret = xTaskCreate(rain_gauge_task, "rain_gauge_task", 4096, NULL, 5, NULL);
-    if (rain_task_ret != pdPASS) {
-        ESP_LOGE(RAIN_TAG, "Failed to create rain gauge task");
-        return;
-    }
-    
-    /* Add continuous GPIO monitoring for debugging */
-    ESP_LOGI(RAIN_TAG, "Rain gauge initialized successfully. Current total: %.2f mm", total_rainfall_mm);
-    ESP_LOGI(RAIN_TAG, "🔧 GPIO%d monitoring: level=%d, pull-down=enabled, trigger=RISING_EDGE", 
-             RAIN_GAUGE_GPIO, gpio_get_level(RAIN_GAUGE_GPIO));
-    
-    /* Initial rain value will be reported after network join (see signal handler) */
-    ESP_LOGI(RAIN_TAG, "Rain gauge ready - initial report will occur after network connection");
+    uint8_t zigbee_voltage = (uint8_t)lroundf(battery_voltage * 10.0f);
+    uint8_t zigbee_percentage = (uint8_t)lroundf(percentage * 2.0f);
+    // Keep the reading in RTC memory; NVS only on real change or at the checkpoint
+    battery_state.read_time_sec = current_time_sec;
+    battery_state.voltage = battery_voltage;
+    battery_state.percentage = percentage;
+    battery_state.zb_voltage = zigbee_voltage;
+    battery_state.zb_percentage = zigbee_percentage;
+    battery_state_persist(current_time_sec);
+    battery_state_seal();
+    // Battery voltage (0x0020) and percentage (0x0021): one Power Configuration frame
+    sensor_cycle_stage_policy(REPORT_POLICY_BATTERY_VOLTAGE, 0, zigbee_voltage, HA_ESP_BME280_ENDPOINT,
+                              ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0020, &zigbee_voltage, sizeof(zigbee_voltage));
+    sensor_cycle_stage_policy(REPORT_POLICY_BATTERY_PERCENT, 0, zigbee_percentage, HA_ESP_BME280_ENDPOINT,
+                              ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, 0x0021, &zigbee_percentage, sizeof(zigbee_percentage));
+    ESP_LOGI(BATTERY_TAG, "🔋 Li-Ion Battery: %.2fV (%.0f%%) (staged)", battery_voltage, percentage);
 }
 
 void app_main(void)
@@ -2280,13 +2217,10 @@ void app_main(void)
     
     /* Initialize OTA */
     ESP_ERROR_CHECK(esp_zb_ota_init());
-
-    /* Create PM lock for initial config period (prevents sleep after network join) */
-    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "config_no_sleep", &config_pm_lock) != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to create config PM lock");
-        config_pm_lock = NULL;
-    }
     
+    /* Attribute update ring, drained by the Zigbee task */
+    attr_queue_init();
+
     /* Initialize power management for light sleep */
     ESP_ERROR_CHECK(esp_zb_power_save_init());
     
@@ -2353,457 +2287,82 @@ void app_main(void)
     xTaskCreate(esp_zb_task, "Zigbee_main", 4096, NULL, 5, NULL);
 }
 
-/* Pulse counter implementation (GPIO13) - identical to rain gauge but for general pulse counting */
-
-static void IRAM_ATTR pulse_counter_isr_handler(void *arg)
-{
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-
-    // ISR-safe: just increment a counter for debugging
-    static uint32_t isr_trigger_count = 0;
-    isr_trigger_count++;
-
-    /* Prepare event with ISR tick for accurate timing */
-    pulse_evt_t evt = {
-        .type = PULSE_EVENT_PULSE,
-        .tick = xTaskGetTickCountFromISR(),
-        .force_nvs = false,
-        .force_attribute = false,
-    };
-    
-    /* Only queue event if there's space - prevents overflow from rapid pulses */
-    if (xQueueSendFromISR(pulse_counter_evt_queue, &evt, &xHigherPriorityTaskWoken) != pdPASS) {
-        /* Queue full - pulse will be lost but prevents crash */
-        static uint32_t queue_overflow_count = 0;
-        queue_overflow_count++;
-    }
-    
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
-    }
-}
-
-static void pulse_counter_task(void *arg)
-{
-    pulse_evt_t evt;
-    TickType_t last_pulse_time = 0;
-    uint32_t pending_pulse_count = 0;
-    bool pending_nvs_flush = false;
-    bool pending_attr_flush = false;
-    const TickType_t DEBOUNCE_TIME = pdMS_TO_TICKS(200); // 200ms debounce
-
-    ESP_LOGI(PULSE_TAG, "Pulse counter task started, waiting for events...");
-
-    for (;;) {
-        // Use 10 second timeout instead of portMAX_DELAY to allow watchdog and health checks
-        if (xQueueReceive(pulse_counter_evt_queue, &evt, pdMS_TO_TICKS(10000))) {
-            switch (evt.type) {
-            case PULSE_EVENT_PULSE: {
-                TickType_t current_time = evt.tick;
-
-                if ((current_time - last_pulse_time) > DEBOUNCE_TIME) {
-                    last_pulse_time = current_time;
-                    pending_pulse_count++;
-                    pulse_counter_count++;
-                    total_pulse_count_value += PULSE_COUNTER_VALUE;
-                    total_pulse_count_value = roundf(total_pulse_count_value * 100.0f) / 100.0f;
-
-                    ESP_LOGI(PULSE_TAG, "⚡ Pulse #%u: %.2f total (+%.2f)",
-                             pulse_counter_count, total_pulse_count_value, PULSE_COUNTER_VALUE);
-                    
-                    pending_nvs_flush = true;
-                    if (pulse_counter_enabled && zigbee_network_connected) {
-                        pending_attr_flush = true;
-                    }
-
-                    if (pending_pulse_count >= RAIN_PULSE_FLUSH_THRESHOLD) {
-                        ESP_LOGD(PULSE_TAG, "Pulse threshold reached (%u) - flushing totals", pending_pulse_count);
-                        pulse_counter_flush_totals(pending_nvs_flush, pending_attr_flush);
-                        pending_pulse_count = 0;
-                        pending_nvs_flush = false;
-                        pending_attr_flush = false;
-                        if (pulse_flush_timer != NULL) {
-                            esp_timer_stop(pulse_flush_timer);
-                        }
-                    } else {
-                        if (pulse_flush_timer != NULL) {
-                            esp_timer_stop(pulse_flush_timer);
-                            esp_timer_start_once(pulse_flush_timer, RAIN_FLUSH_INTERVAL_US);
-                        }
-                    }
-                } else {
-                    ESP_LOGD(PULSE_TAG, "Pulse ignored - debounce active (%u ms)",
-                             pdTICKS_TO_MS(current_time - last_pulse_time));
-                }
-                break;
-            }
-
-            case PULSE_EVENT_FLUSH: {
-                bool do_nvs = pending_nvs_flush || evt.force_nvs;
-                bool do_attr = pending_attr_flush || evt.force_attribute;
-
-                if (do_nvs || do_attr) {
-                    pulse_counter_flush_totals(do_nvs, do_attr);
-                    pending_pulse_count = 0;
-                    pending_nvs_flush = false;
-                    pending_attr_flush = false;
-                }
-                if (pulse_flush_timer != NULL) {
-                    esp_timer_stop(pulse_flush_timer);
-                }
-                break;
-            }
-
-            default:
-                break;
-            }
-        }
-    }
-}
-
-static void pulse_flush_timer_callback(void *arg)
-{
-    pulse_counter_request_flush(false, false);
-}
-
-static void pulse_counter_request_flush(bool force_nvs, bool force_attribute)
-{
-    if (pulse_counter_evt_queue == NULL) {
-        return;
-    }
-
-    pulse_evt_t evt = {
-        .type = PULSE_EVENT_FLUSH,
-        .tick = xTaskGetTickCount(),
-        .force_nvs = force_nvs,
-        .force_attribute = force_attribute,
-    };
+/********************* DS18B20 Temperature Sensor Functions **************************/
 
-    if (xQueueSend(pulse_counter_evt_queue, &evt, 0) != pdPASS) {
-        ESP_LOGW(PULSE_TAG, "Failed to queue pulse flush event (queue full)");
-    }
-}
+/* Pipelined conversion: Convert T is issued at the start of a report cycle (in
+ * parallel with the I2C sensors) and a one-shot timer queues the scratchpad read
+ * once the conversion time has passed. sensor_read_task is free and the CPU can
+ * light-sleep for the whole 94-750 ms conversion. */
+static esp_timer_handle_t ds18b20_collect_timer = NULL;
 
-static void pulse_counter_flush_totals(bool save_to_nvs, bool update_attribute)
+static void ds18b20_collect_timer_callback(void *arg)
 {
-    float rounded_pulse_value = roundf(total_pulse_count_value * 100.0f) / 100.0f;
-
-    if (save_to_nvs) {
-        ESP_LOGI(PULSE_TAG, "💾 Flushing pulse totals to storage: %.2f (%u pulses)",
-                 rounded_pulse_value, pulse_counter_count);
-        
-        /* Save to RTC memory and NVS using sleep_manager (same as rain gauge) */
-        save_pulse_counter_data(rounded_pulse_value, pulse_counter_count);
-    }
-
-    if (update_attribute) {
-        /* Only check network connection, not ISR enabled state
-         * This allows periodic updates even when ISR is temporarily disabled */
-        if (!zigbee_network_connected) {
-            ESP_LOGW(PULSE_TAG, "Skipping Zigbee update - network not connected");
-            return;
-        }
-
-        if (!esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-            ESP_LOGW(PULSE_TAG, "Failed to acquire Zigbee lock for pulse attribute update");
-            return;
-        }
-        esp_err_t ret = esp_zb_zcl_set_attribute_val(
-            HA_ESP_PULSE_COUNTER_ENDPOINT,
-            ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-            ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
-            &rounded_pulse_value,
-            false);
-        esp_zb_lock_release();
-
-        if (ret == ESP_OK) {
-            ESP_LOGI(PULSE_TAG, "📡 Pulse counter attribute updated: %.2f (%u pulses)", rounded_pulse_value, pulse_counter_count);
-        } else {
-            ESP_LOGE(PULSE_TAG, "❌ Failed to update pulse attribute: %s", esp_err_to_name(ret));
-        }
+    (void)arg;
+    uint8_t trigger = SENSOR_TRIGGER_DS18B20;
+    if (sensor_read_queue != NULL && xQueueSend(sensor_read_queue, &trigger, 0) != pdTRUE) {
+        /* Collected at the start of the next report cycle instead */
+        ESP_LOGW(DS18B20_TAG, "Sensor queue full - DS18B20 result deferred to next cycle");
     }
 }
 
-static void pulse_counter_enable_isr(void)
+/**
+ * @brief Issue Convert T without waiting and schedule the scratchpad read
+ *
+ * A result still waiting from an earlier cycle (timer trigger lost) is collected first.
+ */
+static void ds18b20_start_pipelined(void)
 {
-    ESP_LOGI(PULSE_TAG, "🔧 Enabling pulse counter ISR on GPIO%d (installed: %s)", PULSE_COUNTER_GPIO, pulse_counter_isr_installed ? "YES" : "NO");
-
-    if (pulse_counter_evt_queue == NULL) {
-        ESP_LOGE(PULSE_TAG, "Cannot enable pulse counter ISR: event queue not initialized");
-        return;
-    }
-
-    if (!ensure_gpio_isr_service_installed(PULSE_TAG, "pulse counter")) {
+    if (!ds18b20_available) {
         return;
     }
-    
-    // Set enabled flag first
-    pulse_counter_enabled = true;
-    
-    // Add ISR handler (will succeed even if already added)
-    esp_err_t ret = gpio_isr_handler_add(PULSE_COUNTER_GPIO, pulse_counter_isr_handler, NULL);
-    if (ret == ESP_OK) {
-        pulse_counter_isr_installed = true;
-        ESP_LOGI(PULSE_TAG, "✅ Pulse counter ISR enabled successfully on GPIO%d", PULSE_COUNTER_GPIO);
-        /* Ensure interrupt line is enabled so events will be delivered */
-        gpio_intr_enable(PULSE_COUNTER_GPIO);
-    } else if (ret == ESP_ERR_INVALID_STATE) {
-        // ISR already installed - this is fine
-        pulse_counter_isr_installed = true;
-        ESP_LOGI(PULSE_TAG, "✅ Pulse counter ISR already installed, now enabled");
-        /* Make sure the interrupt line is enabled in case it was disabled */
-        gpio_intr_enable(PULSE_COUNTER_GPIO);
-    } else {
-        ESP_LOGE(PULSE_TAG, "❌ Failed to enable pulse counter ISR: %s", esp_err_to_name(ret));
+    if (ds18b20_is_conversion_ready()) {
+        ds18b20_read_and_report(0);
+    } else if (ds18b20_is_conversion_pending()) {
+        return;  // Timer already armed
     }
     
-    // Test GPIO level at enable time
-    int current_level = gpio_get_level(PULSE_COUNTER_GPIO);
-    ESP_LOGI(PULSE_TAG, "🔌 Current GPIO%d level at enable: %d", PULSE_COUNTER_GPIO, current_level);
-}
-
-static void pulse_counter_disable_isr(void)
-{
-    if (pulse_counter_isr_installed) {
-        /* Disable the GPIO interrupt line but keep handler installed */
-        gpio_intr_disable(PULSE_COUNTER_GPIO);
-        pulse_counter_enabled = false;
-        ESP_LOGI(PULSE_TAG, "Pulse counter interrupts disabled (handler kept)");
-    } else {
-        pulse_counter_enabled = false;
-        ESP_LOGI(PULSE_TAG, "Pulse counter ISR already disabled");
-    }
-
-    /* Persist any accumulated pulses before going idle */
-    pulse_counter_request_flush(true, false);
-}
-
-static void pulse_counter_init(void)
-{
-    ESP_LOGI(PULSE_TAG, "Initializing pulse counter on GPIO%d (disabled until network connection)", PULSE_COUNTER_GPIO);
-    
-    /* Start disabled - will be enabled when connected to network */
-    pulse_counter_enabled = false;
-    
-    /* Load pulse counter data from RTC memory or NVS (same as rain gauge) */
-    load_pulse_counter_data(&total_pulse_count_value, &pulse_counter_count);
-    
-    ESP_LOGI(PULSE_TAG, "Current pulse counter total: %.2f (%lu pulses)", total_pulse_count_value, pulse_counter_count);
-    
-    /* Configure GPIO for pulse counter */
-    gpio_config_t io_conf = {
-        .intr_type = GPIO_INTR_POSEDGE,  // Interrupt on rising edge
-        .pin_bit_mask = (1ULL << PULSE_COUNTER_GPIO),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = 0,   // No pull-up needed
-        .pull_down_en = 1, // Enable internal pull-down for additional noise protection
-    };
-    esp_err_t ret = gpio_config(&io_conf);
+    uint32_t conv_us = 0;
+    esp_err_t ret = ds18b20_start_conversion(&conv_us);
     if (ret != ESP_OK) {
-        ESP_LOGE(PULSE_TAG, "Failed to configure GPIO%d: %s", PULSE_COUNTER_GPIO, esp_err_to_name(ret));
-        return;
-    }
-    
-    ESP_LOGI(PULSE_TAG, "✅ GPIO%d configured successfully", PULSE_COUNTER_GPIO);
-    
-    /* Enable GPIO wakeup for light sleep */
-    ret = gpio_wakeup_enable(PULSE_COUNTER_GPIO, GPIO_INTR_HIGH_LEVEL);
-    if (ret == ESP_OK) {
-        ESP_LOGI(PULSE_TAG, "✅ GPIO%d configured as light sleep wake source", PULSE_COUNTER_GPIO);
-    } else {
-        ESP_LOGW(PULSE_TAG, "⚠️ Failed to enable GPIO wake: %s", esp_err_to_name(ret));
-    }
-    
-    // Check initial GPIO state
-    int initial_level = gpio_get_level(PULSE_COUNTER_GPIO);
-    ESP_LOGI(PULSE_TAG, "🔌 Initial GPIO%d level: %d (with pull-down)", PULSE_COUNTER_GPIO, initial_level);
-    
-    /* Create queue for pulse events */
-    pulse_counter_evt_queue = xQueueCreate(32, sizeof(pulse_evt_t));
-    if (!pulse_counter_evt_queue) {
-        ESP_LOGE(PULSE_TAG, "Failed to create event queue");
-        return;
-    }
-
-    /* Create timer used to flush accumulated pulses */
-    const esp_timer_create_args_t flush_timer_args = {
-        .callback = pulse_flush_timer_callback,
-        .name = "pulse_flush"
-    };
-    if (esp_timer_create(&flush_timer_args, &pulse_flush_timer) != ESP_OK) {
-        ESP_LOGE(PULSE_TAG, "Failed to create pulse flush timer");
-        return;
-    }
-    
-    /* Install GPIO ISR service if not already installed */
-    esp_err_t isr_ret = gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
-    if (isr_ret == ESP_ERR_INVALID_STATE) {
-        ESP_LOGD(PULSE_TAG, "GPIO ISR service already installed");
-    } else if (isr_ret != ESP_OK) {
-        ESP_LOGE(PULSE_TAG, "Failed to install ISR service: %s", esp_err_to_name(isr_ret));
+        ESP_LOGW(DS18B20_TAG, "❌ Failed to start conversion: %s", esp_err_to_name(ret));
         return;
     }
-    
-    /* Install ISR handler early so pulses are captured even while offline */
-    esp_err_t add_ret = gpio_isr_handler_add(PULSE_COUNTER_GPIO, pulse_counter_isr_handler, NULL);
-    if (add_ret == ESP_OK) {
-        pulse_counter_isr_installed = true;
-        gpio_intr_enable(PULSE_COUNTER_GPIO);
-        ESP_LOGI(PULSE_TAG, "✅ ISR handler installed early on GPIO%d", PULSE_COUNTER_GPIO);
-    } else if (add_ret == ESP_ERR_INVALID_STATE) {
-        pulse_counter_isr_installed = true;
-        gpio_intr_enable(PULSE_COUNTER_GPIO);
-        ESP_LOGI(PULSE_TAG, "ℹ️ ISR handler already present for GPIO%d", PULSE_COUNTER_GPIO);
-    } else {
-        ESP_LOGW(PULSE_TAG, "⚠️ Failed to add ISR handler early: %s", esp_err_to_name(add_ret));
-    }
-    
-    /* Create pulse counter task */
-    BaseType_t pulse_task_ret = xTaskCreate(pulse_counter_task, "pulse_counter_task", 4096, NULL, 5, NULL);
-    if (pulse_task_ret != pdPASS) {
-        ESP_LOGE(PULSE_TAG, "Failed to create pulse counter task");
-        return;
-    }
-    
-    ESP_LOGI(PULSE_TAG, "Pulse counter initialized successfully. Current total: %.2f", total_pulse_count_value);
-    ESP_LOGI(PULSE_TAG, "🔧 GPIO%d monitoring: level=%d, pull-down=enabled, trigger=RISING_EDGE", 
-             PULSE_COUNTER_GPIO, gpio_get_level(PULSE_COUNTER_GPIO));
-    ESP_LOGI(PULSE_TAG, "Pulse counter ready - initial report will occur after network connection");
-}
-
-/********************* DS18B20 Temperature Sensor Functions **************************/
-
-/* DS18B20 1-Wire Commands */
-#define DS18B20_CMD_SKIP_ROM        0xCC
-#define DS18B20_CMD_CONVERT_T       0x44
-#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
-
-/* Spinlock protecting µs-level 1-Wire time slots from interrupt preemption */
-static portMUX_TYPE ds18b20_mux = portMUX_INITIALIZER_UNLOCKED;
-
-/**
- * @brief 1-Wire reset pulse - pull bus low for 480us, wait for presence pulse
- * @return true if device present, false otherwise
- */
-static bool ds18b20_reset(void)
-{
-    /* Pull bus low for reset pulse - long enough that interrupt extension is safe */
-    gpio_set_level(DS18B20_GPIO, 0);
-    esp_rom_delay_us(480);  // Reset pulse (480-960us)
-
-    /* Presence-detection window is tight: sample between 60-240us after release.
-     * Disable interrupts so a stray ISR can't push us past the window. */
-    portENTER_CRITICAL(&ds18b20_mux);
-    gpio_set_level(DS18B20_GPIO, 1);
-    esp_rom_delay_us(70);
-    int level = gpio_get_level(DS18B20_GPIO);
-    portEXIT_CRITICAL(&ds18b20_mux);
-
-    esp_rom_delay_us(410);  // Complete reset cycle (outside critical section)
-    return (level == 0);  // Device pulls line low if present
-}
-
-/**
- * @brief Write a bit on 1-Wire bus
- */
-static void ds18b20_write_bit(uint8_t bit)
-{
-    /* The critical window is the low-pulse duration (1-15us for '1', 60-120us for '0').
-     * Hold interrupts off for the pulse only; release before the recovery delay. */
-    if (bit) {
-        portENTER_CRITICAL(&ds18b20_mux);
-        gpio_set_level(DS18B20_GPIO, 0);
-        esp_rom_delay_us(6);
-        gpio_set_level(DS18B20_GPIO, 1);
-        portEXIT_CRITICAL(&ds18b20_mux);
-        esp_rom_delay_us(64);   // Recovery (outside critical section)
-    } else {
-        portENTER_CRITICAL(&ds18b20_mux);
-        gpio_set_level(DS18B20_GPIO, 0);
-        esp_rom_delay_us(60);
-        gpio_set_level(DS18B20_GPIO, 1);
-        portEXIT_CRITICAL(&ds18b20_mux);
-        esp_rom_delay_us(10);   // Recovery (outside critical section)
-    }
-}
-
-/**
- * @brief Read a bit from 1-Wire bus
- */
-static uint8_t ds18b20_read_bit(void)
-{
-    /* The DS18B20 must be sampled within 15us of the falling edge.
-     * Any interrupt firing between the low pulse and the sample corrupts the bit.
-     * Keep the critical window to just the 13us that matter; recovery is outside. */
-    portENTER_CRITICAL(&ds18b20_mux);
-    gpio_set_level(DS18B20_GPIO, 0);
-    esp_rom_delay_us(3);
-    gpio_set_level(DS18B20_GPIO, 1);
-    esp_rom_delay_us(10);
-    uint8_t bit = gpio_get_level(DS18B20_GPIO);
-    portEXIT_CRITICAL(&ds18b20_mux);
-
-    esp_rom_delay_us(53);  // Slot recovery (outside critical section)
-    return bit;
-}
-
-/**
- * @brief Write a byte on 1-Wire bus (LSB first)
- */
-static void ds18b20_write_byte(uint8_t byte)
-{
-    for (int i = 0; i < 8; i++) {
-        ds18b20_write_bit(byte & 0x01);
-        byte >>= 1;
-    }
-}
-
-/**
- * @brief Read a byte from 1-Wire bus (LSB first)
- */
-static uint8_t ds18b20_read_byte(void)
-{
-    uint8_t byte = 0;
-    for (int i = 0; i < 8; i++) {
-        byte >>= 1;
-        if (ds18b20_read_bit()) {
-            byte |= 0x80;
-        }
+    esp_timer_stop(ds18b20_collect_timer);
+    ret = esp_timer_start_once(ds18b20_collect_timer, conv_us);
+    if (ret != ESP_OK) {
+        ESP_LOGW(DS18B20_TAG, "Failed to arm collect timer: %s", esp_err_to_name(ret));
     }
-    return byte;
+    ESP_LOGD(DS18B20_TAG, "Conversion started, collecting in %lu ms", (unsigned long)(conv_us / 1000));
 }
 
 /**
  * @brief Initialize DS18B20 temperature sensor on 1-Wire bus
  * 
- * Configures GPIO24 for 1-Wire communication and verifies DS18B20 presence.
+ * Sets up the RMT 1-Wire bus on GPIO24, enumerates the probes with Search ROM,
+ * merges them into the persisted probe table and programs the resolution
+ * (DS18B20_RESOLUTION_BITS) of every probe.
  * If sensor is not detected, logs warning and continues (allows device to work without DS18B20).
  * Implements retry logic with increased delays to handle sensors that need more power-up time.
  */
-static void ds18b20_init(void)
+static void ds18b20_setup(void)
 {
     ESP_LOGI(DS18B20_TAG, "Initializing DS18B20 on GPIO%d...", DS18B20_GPIO);
     
-    /* Configure GPIO as open-drain output (external 4.7kΩ pull-up resistor on PCB)
-     * Important: Internal pull-up DISABLED because hardware has external resistor */
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << DS18B20_GPIO),
-        .mode = GPIO_MODE_INPUT_OUTPUT_OD,  // Open-drain mode for 1-Wire
-        .pull_up_en = GPIO_PULLUP_DISABLE,   // External pull-up present (4.7kΩ to 3.3V)
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    const esp_timer_create_args_t collect_timer_args = {
+        .callback = ds18b20_collect_timer_callback,
+        .name = "ds18b20_collect",
     };
-    gpio_config(&io_conf);
-    
-    /* Set initial state high (idle) */
-    gpio_set_level(DS18B20_GPIO, 1);
+    if (ds18b20_collect_timer == NULL && esp_timer_create(&collect_timer_args, &ds18b20_collect_timer) != ESP_OK) {
+        ds18b20_available = false;
+        ESP_LOGE(DS18B20_TAG, "Failed to create collect timer - sensor disabled");
+        return;
+    }
     
     /* Test presence of DS18B20 with retry logic
      * Some sensors need more time to power up, especially with longer cables or marginal power */
     const int MAX_RETRIES = 5;
     const int RETRY_DELAYS_MS[] = {0, 10, 50, 100, 200};  // First attempt immediate, then progressive backoff
-    bool detected = false;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
     
     for (int retry = 0; retry < MAX_RETRIES; retry++) {
         if (retry > 0) {
@@ -2812,112 +2371,71 @@ static void ds18b20_init(void)
             vTaskDelay(pdMS_TO_TICKS(RETRY_DELAYS_MS[retry]));  // Allow bus to stabilize
         }
         
-        if (ds18b20_reset()) {
-            detected = true;
-            if (retry > 0) {
-                ESP_LOGI(DS18B20_TAG, "✅ DS18B20 detected on GPIO%d (attempt %d/%d after %dms delay)", 
-                         DS18B20_GPIO, retry + 1, MAX_RETRIES, RETRY_DELAYS_MS[retry]);
-            } else {
-                ESP_LOGI(DS18B20_TAG, "✅ DS18B20 detected on GPIO%d (first attempt)", DS18B20_GPIO);
-            }
+        ret = ds18b20_init(DS18B20_GPIO);
+        if (ret == ESP_OK) {
+            ESP_LOGI(DS18B20_TAG, "✅ 1-Wire presence on GPIO%d (attempt %d/%d)", DS18B20_GPIO, retry + 1, MAX_RETRIES);
             break;
-        } else {
-            if (retry < MAX_RETRIES - 1) {
-                ESP_LOGI(DS18B20_TAG, "❌ No response on attempt %d/%d, will retry...", 
-                         retry + 1, MAX_RETRIES);
-            } else {
-                ESP_LOGI(DS18B20_TAG, "❌ No response after %d attempts - giving up", MAX_RETRIES);
-            }
         }
+        ESP_LOGI(DS18B20_TAG, "❌ No response on attempt %d/%d (%s)", retry + 1, MAX_RETRIES, esp_err_to_name(ret));
     }
     
-    if (detected) {
-        ds18b20_available = true;
-        
-        /* Perform initial temperature reading with retry logic
-         * First conversion after power-up may need more time */
-        ESP_LOGI(DS18B20_TAG, "Performing initial temperature reading...");
-        
-        const int READ_RETRIES = 3;
-        const int CONVERSION_DELAYS_MS[] = {850, 1000, 1200};  // Progressive delays for retry
-        bool reading_success = false;
-        
-        for (int read_attempt = 0; read_attempt < READ_RETRIES && !reading_success; read_attempt++) {
-            if (read_attempt > 0) {
-                ESP_LOGI(DS18B20_TAG, "🔄 Initial read retry %d/%d (longer conversion delay: %dms)", 
-                         read_attempt + 1, READ_RETRIES, CONVERSION_DELAYS_MS[read_attempt]);
-            }
-            
-            /* Start temperature conversion */
-            if (!ds18b20_reset()) {
-                ESP_LOGW(DS18B20_TAG, "❌ Reset failed before conversion (attempt %d)", read_attempt + 1);
-                vTaskDelay(pdMS_TO_TICKS(100));  // Wait before retry
-                continue;
-            }
-            
-            ds18b20_write_byte(DS18B20_CMD_SKIP_ROM);
-            ds18b20_write_byte(DS18B20_CMD_CONVERT_T);
-            vTaskDelay(pdMS_TO_TICKS(CONVERSION_DELAYS_MS[read_attempt]));  // Wait for conversion
-            
-            /* Read scratchpad */
-            if (ds18b20_reset()) {
-                ds18b20_write_byte(DS18B20_CMD_SKIP_ROM);
-                ds18b20_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
-                
-                uint8_t temp_lsb = ds18b20_read_byte();
-                uint8_t temp_msb = ds18b20_read_byte();
-                
-                int16_t raw_temp = (temp_msb << 8) | temp_lsb;
-                float temperature = (float)raw_temp * 0.0625f;
-                
-                if (temperature >= -55.0f && temperature <= 125.0f) {
-                    ds18b20_last_temp = temperature;
-                    reading_success = true;
-                    
-                    if (read_attempt > 0) {
-                        ESP_LOGI(DS18B20_TAG, "✅ Initial temperature reading successful on attempt %d: %.2f°C (raw: 0x%04X)", 
-                                 read_attempt + 1, temperature, raw_temp);
-                    } else {
-                        ESP_LOGI(DS18B20_TAG, "🌡️ Initial temperature reading: %.2f°C (raw: 0x%04X)", temperature, raw_temp);
-                    }
-                    
-                    /* Update Zigbee attribute with initial value */
-                    int16_t temp_centidegrees = (int16_t)(temperature * 100);
-                    esp_err_t attr_ret = esp_zb_zcl_set_attribute_val(HA_ESP_DS18B20_ENDPOINT, 
-                                                                       ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-                                                                       ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, 
-                                                                       ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-                                                                       &temp_centidegrees, false);
-                    if (attr_ret == ESP_OK) {
-                        ESP_LOGI(DS18B20_TAG, "✅ Initial attribute updated");
-                    } else {
-                        ESP_LOGW(DS18B20_TAG, "Failed to update initial attribute: %s", esp_err_to_name(attr_ret));
-                    }
-                } else {
-                    ESP_LOGW(DS18B20_TAG, "❌ Initial reading out of range: %.2f°C (attempt %d)", 
-                             temperature, read_attempt + 1);
-                }
-            } else {
-                ESP_LOGW(DS18B20_TAG, "❌ Reset failed after conversion (attempt %d)", read_attempt + 1);
-            }
-        }
-        
-        if (!reading_success) {
-            ESP_LOGW(DS18B20_TAG, "⚠️ Failed to read initial temperature after %d attempts - will retry on next read cycle", READ_RETRIES);
-        }
-    } else {
+    if (ret != ESP_OK) {
         ds18b20_available = false;
         ESP_LOGW(DS18B20_TAG, "⚠️ No DS18B20 detected on GPIO%d - sensor disabled", DS18B20_GPIO);
+        return;
     }
+    
+    /* Enumerate the probes; new ones get the next free slot (= endpoint) in the persisted table */
+    onewire_rom_t found[DS18B20_MAX_DEVICES];
+    size_t found_count = 0;
+    ret = ds18b20_search(found, DS18B20_MAX_DEVICES, &found_count, false);
+    if (ret != ESP_OK) {
+        ESP_LOGW(DS18B20_TAG, "ROM search failed (%s) - using stored probe table", esp_err_to_name(ret));
+        found_count = 0;
+    }
+    if (ds18b20_roms_merge(&ds18b20_probes, found, found_count)) {
+        ds18b20_roms_save(&ds18b20_probes);
+        if (ds18b20_probes.count > ds18b20_endpoint_count) {
+            ESP_LOGW(DS18B20_TAG, "New probe(s) stored - endpoints for them appear after the next restart");
+        }
+    }
+    
+    ds18b20_present_mask = 0;
+    for (size_t i = 0; i < found_count; i++) {
+        int slot = ds18b20_roms_find(&ds18b20_probes, &found[i]);
+        if (slot >= 0) {
+            ds18b20_present_mask |= 1UL << slot;
+        }
+    }
+    for (uint8_t slot = 0; slot < ds18b20_probes.count; slot++) {
+        const uint8_t *id = ds18b20_probes.rom[slot].id;
+        ESP_LOGI(DS18B20_TAG, "  Probe %u -> EP%d: %02x%02x%02x%02x%02x%02x%02x%02x %s", slot, HA_ESP_DS18B20_ENDPOINT + slot,
+                 id[7], id[6], id[5], id[4], id[3], id[2], id[1], id[0],
+                 (ds18b20_present_mask & (1UL << slot)) ? "" : "(missing)");
+    }
+    
+    /* Match ROM for every probe that has an endpoint; Skip ROM if the search found none
+     * (single probe with a marginal cable still works as before) */
+    size_t attach_count = ds18b20_probes.count < ds18b20_endpoint_count ? ds18b20_probes.count : ds18b20_endpoint_count;
+    ds18b20_attach(ds18b20_probes.rom, attach_count);
+    if (attach_count == 0) {
+        ds18b20_present_mask = 1;
+    }
+    ds18b20_set_resolution(DS18B20_RESOLUTION_BITS);
+    
+    /* First reading arrives through the pipeline; nothing blocks here */
+    ds18b20_available = true;
+    ds18b20_start_pipelined();
 }
 
 /**
- * @brief Read DS18B20 temperature and update Zigbee attribute
+ * @brief Collect the pipelined DS18B20 conversion and update Zigbee attribute
  * 
  * @param param Unused parameter (required for esp_zb_scheduler_alarm callback)
  * 
- * Reads temperature from DS18B20 sensor and updates Temperature Measurement cluster
- * attribute on endpoint 4. Logs warning if sensor is not available.
+ * Reads the scratchpad of every probe for the conversion started by
+ * ds18b20_start_pipelined() and updates the Temperature Measurement cluster
+ * attribute of its endpoint (4 + probe slot).
  */
 static void ds18b20_read_and_report(uint8_t param)
 {
@@ -2929,73 +2447,42 @@ static void ds18b20_read_and_report(uint8_t param)
         return;
     }
     
-    ESP_LOGI(DS18B20_TAG, "Starting DS18B20 temperature measurement...");
-    
-    /* Reset and check presence */
-    ESP_LOGD(DS18B20_TAG, "Sending reset pulse...");
-    if (!ds18b20_reset()) {
-        ESP_LOGW(DS18B20_TAG, "❌ DS18B20 not responding to reset");
-        return;
-    }
-    ESP_LOGD(DS18B20_TAG, "✓ Device present");
-    
-    /* Start temperature conversion */
-    ESP_LOGD(DS18B20_TAG, "Starting temperature conversion...");
-    ds18b20_write_byte(DS18B20_CMD_SKIP_ROM);  // Skip ROM (single device)
-    ds18b20_write_byte(DS18B20_CMD_CONVERT_T);  // Convert T command
-    
-    /* Wait for conversion (750ms for 12-bit resolution) */
-    ESP_LOGD(DS18B20_TAG, "Waiting 800ms for conversion...");
-    vTaskDelay(pdMS_TO_TICKS(800));
-    
-    /* Read scratchpad */
-    ESP_LOGD(DS18B20_TAG, "Reading scratchpad...");
-    if (!ds18b20_reset()) {
-        ESP_LOGW(DS18B20_TAG, "❌ DS18B20 not responding after conversion");
-        return;
-    }
-    
-    ds18b20_write_byte(DS18B20_CMD_SKIP_ROM);
-    ds18b20_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
-    
-    /* Read temperature bytes (LSB first) */
-    uint8_t temp_lsb = ds18b20_read_byte();
-    uint8_t temp_msb = ds18b20_read_byte();
-    
-    ESP_LOGD(DS18B20_TAG, "Raw bytes: LSB=0x%02X, MSB=0x%02X", temp_lsb, temp_msb);
-    
-    /* Convert to temperature (12-bit resolution: 0.0625°C per bit) */
-    int16_t raw_temp = (temp_msb << 8) | temp_lsb;
-    float temperature = (float)raw_temp * 0.0625f;
-    
-    ESP_LOGI(DS18B20_TAG, "Raw value: %d, Temperature: %.2f°C", raw_temp, temperature);
-    
-    /* Basic sanity check (-55°C to 125°C is DS18B20 range) */
-    if (temperature < -55.0f || temperature > 125.0f) {
-        ESP_LOGW(DS18B20_TAG, "❌ Invalid temperature reading: %.2f°C (out of range)", temperature);
-        return;
-    }
-    
-    /* Update last known temperature */
-    ds18b20_last_temp = temperature;
-    
-    /* Convert to Zigbee format (0.01°C units) */
-    int16_t temp_centidegrees = (int16_t)(temperature * 100);
-    
-    ESP_LOGD(DS18B20_TAG, "Updating Zigbee attribute: %d (0.01°C units)", temp_centidegrees);
-    
-    /* Update Zigbee attribute (false = don't force report, let coordinator config decide) */
-    esp_err_t ret = ESP_FAIL;
-    if (esp_zb_lock_acquire(pdMS_TO_TICKS(1000))) {
-        ret = esp_zb_zcl_set_attribute_val(HA_ESP_DS18B20_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-                                           &temp_centidegrees, false);
-        esp_zb_lock_release();
-    }
-    if (ret == ESP_OK) {
-        ESP_LOGI(DS18B20_TAG, "✅ DS18B20 Temperature: %.2f°C (attribute updated)", temperature);
-    } else {
-        ESP_LOGE(DS18B20_TAG, "❌ Failed to update temperature attribute: %s", esp_err_to_name(ret));
+    /* One broadcast conversion served every probe; read each by Match ROM */
+    for (size_t probe = 0; probe < ds18b20_get_count(); probe++) {
+        if (!(ds18b20_present_mask & (1UL << probe))) {
+            continue;  // Stored probe not on the bus this boot
+        }
+        float temperature = 0.0f;
+        esp_err_t ret = ds18b20_collect(probe, &temperature);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            continue;  // Already collected
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGW(DS18B20_TAG, "❌ Probe %u read failed: %s", (unsigned)probe, esp_err_to_name(ret));
+            continue;
+        }
+        
+        /* Basic sanity check (-55°C to 125°C is DS18B20 range) */
+        if (temperature < -55.0f || temperature > 125.0f) {
+            ESP_LOGW(DS18B20_TAG, "❌ Probe %u invalid temperature reading: %.2f°C (out of range)", (unsigned)probe,
+                     temperature);
+            continue;
+        }
+        
+        /* Update last known temperature */
+        ds18b20_last_temp[probe] = temperature;
+        
+        /* Convert to Zigbee format (0.01°C units) */
+        int16_t temp_centidegrees = (int16_t)(temperature * 100);
+        uint8_t endpoint = HA_ESP_DS18B20_ENDPOINT + probe;
+        
+        /* Staged: the Zigbee task writes every probe in the same drain after the caller's commit */
+        bool staged = sensor_cycle_stage_policy(REPORT_POLICY_PROBE_TEMPERATURE, (uint8_t)probe, temp_centidegrees,
+                                                endpoint, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                                                ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+                                                &temp_centidegrees, sizeof(temp_centidegrees));
+        ESP_LOGI(DS18B20_TAG, "✅ DS18B20 #%u Temperature: %.2f°C (EP%u %s)", (unsigned)probe, temperature, endpoint,
+                 staged ? "staged" : "held back by policy");
     }
 }
 
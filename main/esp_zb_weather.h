@@ -22,10 +22,33 @@
 #define HA_ESP_BME280_ENDPOINT          1                                    /* esp BME280 environmental sensor endpoint */
 #define HA_ESP_RAIN_GAUGE_ENDPOINT      2                                    /* esp rain gauge sensor endpoint */
 #define HA_ESP_PULSE_COUNTER_ENDPOINT   3                                    /* esp pulse counter sensor endpoint (GPIO13) */
-#define HA_ESP_DS18B20_ENDPOINT         4                                    /* esp DS18B20 temperature sensor endpoint (GPIO24) */
-/* Endpoint 5 (Sleep Configuration) removed - light sleep mode uses standard Zigbee reporting */
+#define HA_ESP_DS18B20_ENDPOINT         4                                    /* esp DS18B20 temperature sensor endpoint (GPIO24), first probe */
+/* Further DS18B20 probes on the same bus use endpoints 5.. (HA_ESP_DS18B20_ENDPOINT + slot, up to DS18B20_MAX_DEVICES).
+ * Endpoint 5 (Sleep Configuration) was removed - light sleep mode uses standard Zigbee reporting */
 #define ESP_ZB_PRIMARY_CHANNEL_MASK     ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK /* Zigbee primary channel mask use in the example */
 
+/* Manufacturer-specific device configuration cluster on the primary endpoint */
+#define CAELUM_CONFIG_CLUSTER_ID        0xFC00                               /* Caelum device configuration cluster (server, EP1) */
+#define CAELUM_ATTR_MEASUREMENT_PROFILE 0x0000                               /* enum8 R/W: 0=eco, 1=balanced, 2=precise, 3=standard */
+#define CAELUM_ATTR_PROFILE_ENERGY_UJ   0x0001                               /* uint16 RO: estimated sensor energy per sample (uJ) */
+#define CAELUM_ATTR_SENSOR_ERRORS       0x0010                               /* uint32 RO: sensor bus/CRC/timeout errors since boot */
+#define CAELUM_ATTR_SENSOR_RETRIES      0x0011                               /* uint32 RO: extra conversions spent on retries */
+#define CAELUM_ATTR_BUS_RECOVERIES      0x0012                               /* uint16 RO: I2C bus recoveries since boot */
+#define CAELUM_ATTR_INCOMPLETE_CYCLES   0x0013                               /* uint16 RO: cycles ending with a failed sensor */
+#define CAELUM_ATTR_SENSOR_DIAG         0x0014                               /* char string RO: per-sensor summary "SHT41 ok120 e2 r1;..." */
+#define CAELUM_SENSOR_DIAG_MAX_LEN      48                                   /* Max length of the per-sensor summary string */
+#define CAELUM_ATTR_POLICY_BASE         0x0100                               /* uint16 R/W: report policy, 0x01VP (V = report_policy_id_t, P = parameter) */
+#define CAELUM_ATTR_POLICY(id, param)   (CAELUM_ATTR_POLICY_BASE | ((id) << 4) | (param))
+
+/* Manufacturer-specific rain rate cluster on the rain gauge endpoint (0.1 mm/h units) */
+#define CAELUM_RAIN_RATE_CLUSTER_ID     0xFC01                               /* Caelum rain rate cluster (server, EP2) */
+#define CAELUM_ATTR_RAIN_RATE           0x0000                               /* uint16 RO: instantaneous rain rate */
+#define CAELUM_ATTR_RAIN_RATE_10MIN     0x0001                               /* uint16 RO: rain in the last 10 minutes, per hour */
+#define CAELUM_ATTR_RAIN_RATE_1H        0x0002                               /* uint16 RO: rain in the last hour */
+
+/* Software oversampling: cheap intermediate samples on keep-alive wake-ups, averaged at report time */
+#define SENSOR_OVERSAMPLE_ENABLE        1                                    /* Set to 0 to report single samples only */
+
 /* Debug LED configuration */
 #define DEBUG_LED_ENABLE                1                                    /* Set to 1 to enable LED debug indicator */
 #define DEBUG_LED_TYPE_RGB              1                                    /* Set to 1 for WS2812 RGB LED, 0 for simple GPIO */
@@ -37,7 +60,12 @@
 #define RAIN_WAKE_GPIO                  GPIO_NUM_12                          /* GPIO for rain gauge wake-up */
 #define PULSE_WAKE_GPIO                 GPIO_NUM_13                          /* GPIO for pulse counter wake-up */
 #define DS18B20_GPIO                    GPIO_NUM_24                          /* GPIO for DS18B20 1-Wire temperature sensor */
+#define DS18B20_RESOLUTION_BITS         12                                   /* 9-12 bit: 94 / 188 / 375 / 750 ms conversion (0.5-0.0625°C) */
 #define RAIN_MM_THRESHOLD               1.0f                                 /* Wake up immediately if rain > 1mm */
+#define RAIN_GAUGE_USE_PCNT             0                                    /* 1: count rain tips with PCNT (needs an RC debounce on the reed switch) */
+#define PULSE_COUNTER_USE_PCNT          0                                    /* 1: count GPIO13 pulses with PCNT (high-rate inputs, no wake per edge) */
+#define PULSE_COUNTER_PCNT_THRESHOLD    100                                  /* PCNT backend: flush early every N pulses */
+#define BATTERY_MEASURE_UNDER_LOAD      0                                    /* 1: sample the cell once the sensor reports are written and queued for TX */
 
 /* Basic manufacturer information - now using CMakeLists.txt definitions */
 #define ESP_MANUFACTURER_NAME "\x09""ESPRESSIF"      /* Customized manufacturer name */
@@ -0,0 +1,362 @@
+/*
+ * 1-Wire Bus Master (RMT)
+ *
+ * Design:
+ * - Reset pulses and time slots are RMT symbols clocked out by hardware; the caller
+ *   blocks on the RX/TX done events instead of bit-banging with interrupts masked
+ * - RX and TX share the open-drain pin through loop-back: the captured levels give
+ *   the presence pulse and the read bits (a slave stretches the low phase for a '0')
+ * - Channels are enabled only for one transfer, so their PM lock does not keep the
+ *   chip out of light sleep between transfers
+ * - Reads are chunked to the RX buffer; ROM search walks one branch per call with the
+ *   classic last-discrepancy algorithm
+ */
+
+#include "onewire_rmt.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_rx.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <string.h>
+
+static const char *TAG = "ONEWIRE";
+
+// 1 MHz RMT tick: symbol durations below are in microseconds
+#define ONEWIRE_RMT_RESOLUTION_HZ   1000000
+#define ONEWIRE_RMT_MEM_SYMBOLS     48
+// Largest read per RX transaction (DS18B20 scratchpad is 9 bytes); longer reads are chunked
+#define ONEWIRE_RMT_MAX_RX_BYTES    10
+#define ONEWIRE_RMT_TIMEOUT_MS      50
+
+// Standard-speed timing (DS18B20 datasheet, "1-Wire signaling")
+#define ONEWIRE_RESET_PULSE_US          500     // Master low >= 480 us
+#define ONEWIRE_RESET_WAIT_US           200     // Released: slave waits 15-60 us, then presence 60-240 us
+#define ONEWIRE_PRESENCE_WAIT_MIN_US    15
+#define ONEWIRE_PRESENCE_MIN_US         60
+#define ONEWIRE_SLOT_START_US           2       // Low pulse opening every slot
+#define ONEWIRE_SLOT_BIT_US             60      // Slot length
+#define ONEWIRE_SLOT_RECOVERY_US        2       // Released time between slots
+#define ONEWIRE_SLOT_SAMPLE_US          15      // Slave holds the line low past this for a '0'
+
+static rmt_channel_handle_t s_tx = NULL;
+static rmt_channel_handle_t s_rx = NULL;
+static rmt_encoder_handle_t s_bytes_encoder = NULL;
+static rmt_encoder_handle_t s_copy_encoder = NULL;
+static QueueHandle_t s_rx_queue = NULL;
+static rmt_symbol_word_t s_rx_symbols[ONEWIRE_RMT_MAX_RX_BYTES * 8];
+
+static const rmt_symbol_word_t s_reset_symbol = {
+    .level0 = 0, .duration0 = ONEWIRE_RESET_PULSE_US,
+    .level1 = 1, .duration1 = ONEWIRE_RESET_WAIT_US,
+};
+
+// Write-0 holds the line low for the whole slot; write-1 (also the read slot) releases it early
+static const rmt_symbol_word_t s_bit0_symbol = {
+    .level0 = 0, .duration0 = ONEWIRE_SLOT_START_US + ONEWIRE_SLOT_BIT_US,
+    .level1 = 1, .duration1 = ONEWIRE_SLOT_RECOVERY_US,
+};
+static const rmt_symbol_word_t s_bit1_symbol = {
+    .level0 = 0, .duration0 = ONEWIRE_SLOT_START_US,
+    .level1 = 1, .duration1 = ONEWIRE_SLOT_BIT_US + ONEWIRE_SLOT_RECOVERY_US,
+};
+
+// Bus is released (high) after every transfer
+static const rmt_transmit_config_t s_tx_config = {
+    .loop_count = 0,
+    .flags.eot_level = 1,
+};
+
+// RX ends once the line has been idle longer than the longest level of the sequence:
+// the reset pulse for resets, one slot for reads (keeps per-bit ROM search steps short)
+static const rmt_receive_config_t s_rx_config_reset = {
+    .signal_range_min_ns = 1000000000 / ONEWIRE_RMT_RESOLUTION_HZ,
+    .signal_range_max_ns = (ONEWIRE_RESET_PULSE_US + ONEWIRE_RESET_WAIT_US) * 1000,
+};
+static const rmt_receive_config_t s_rx_config_slots = {
+    .signal_range_min_ns = 1000000000 / ONEWIRE_RMT_RESOLUTION_HZ,
+    .signal_range_max_ns = (ONEWIRE_SLOT_START_US + ONEWIRE_SLOT_BIT_US + ONEWIRE_SLOT_RECOVERY_US + 30) * 1000,
+};
+
+static bool IRAM_ATTR onewire_rmt_rx_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata,
+                                          void *user_ctx)
+{
+    BaseType_t task_woken = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)user_ctx, edata, &task_woken);
+    return task_woken == pdTRUE;
+}
+
+// The channels hold a PM lock while enabled, so they are only enabled for the
+// duration of one transfer and the chip can light-sleep between transfers
+static esp_err_t onewire_rmt_enable(void)
+{
+    ESP_RETURN_ON_ERROR(rmt_enable(s_rx), TAG, "RX enable failed");
+    esp_err_t ret = rmt_enable(s_tx);
+    if (ret != ESP_OK) {
+        rmt_disable(s_rx);
+        ESP_LOGE(TAG, "TX enable failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void onewire_rmt_disable(void)
+{
+    rmt_disable(s_tx);
+    rmt_disable(s_rx);
+}
+
+/* One transfer: optionally arm RX, clock out the payload, block until done.
+ * rx_symbols receives the number of captured symbols (NULL = write only). */
+static esp_err_t onewire_rmt_transfer(rmt_encoder_handle_t encoder, const void *payload, size_t payload_len,
+                                      const rmt_receive_config_t *rx_config, size_t *rx_symbols)
+{
+    if (!s_tx) return ESP_ERR_INVALID_STATE;
+    ESP_RETURN_ON_ERROR(onewire_rmt_enable(), TAG, "enable failed");
+
+    esp_err_t ret = ESP_OK;
+    if (rx_symbols) {
+        xQueueReset(s_rx_queue);
+        ret = rmt_receive(s_rx, s_rx_symbols, sizeof(s_rx_symbols), rx_config);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_transmit(s_tx, encoder, payload, payload_len, &s_tx_config);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_tx_wait_all_done(s_tx, ONEWIRE_RMT_TIMEOUT_MS);
+    }
+    if (ret == ESP_OK && rx_symbols) {
+        rmt_rx_done_event_data_t evt;
+        if (xQueueReceive(s_rx_queue, &evt, pdMS_TO_TICKS(ONEWIRE_RMT_TIMEOUT_MS)) == pdTRUE) {
+            *rx_symbols = evt.num_symbols;
+        } else {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+
+    onewire_rmt_disable();
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Transfer failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t onewire_rmt_init(gpio_num_t gpio)
+{
+    if (s_tx) return ESP_OK;
+
+    s_rx_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    ESP_RETURN_ON_FALSE(s_rx_queue, ESP_ERR_NO_MEM, TAG, "RX queue alloc failed");
+
+    // RX first, then TX with loop-back so both share the pin; open-drain because
+    // slaves pull the line low against the external pull-up
+    rmt_rx_channel_config_t rx_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .gpio_num = gpio,
+        .mem_block_symbols = ONEWIRE_RMT_MEM_SYMBOLS,
+        .resolution_hz = ONEWIRE_RMT_RESOLUTION_HZ,
+    };
+    rmt_tx_channel_config_t tx_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .gpio_num = gpio,
+        .mem_block_symbols = ONEWIRE_RMT_MEM_SYMBOLS,
+        .resolution_hz = ONEWIRE_RMT_RESOLUTION_HZ,
+        .trans_queue_depth = 4,
+        .flags.io_loop_back = true,
+        .flags.io_od_mode = true,
+    };
+    rmt_bytes_encoder_config_t bytes_cfg = {
+        .bit0 = s_bit0_symbol,
+        .bit1 = s_bit1_symbol,
+        .flags.msb_first = 0,
+    };
+    rmt_copy_encoder_config_t copy_cfg = {};
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = onewire_rmt_rx_done,
+    };
+
+    esp_err_t ret = rmt_new_rx_channel(&rx_cfg, &s_rx);
+    if (ret == ESP_OK) ret = rmt_new_tx_channel(&tx_cfg, &s_tx);
+    if (ret == ESP_OK) ret = rmt_new_bytes_encoder(&bytes_cfg, &s_bytes_encoder);
+    if (ret == ESP_OK) ret = rmt_new_copy_encoder(&copy_cfg, &s_copy_encoder);
+    if (ret == ESP_OK) ret = rmt_rx_register_event_callbacks(s_rx, &cbs, s_rx_queue);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "RMT setup on GPIO%d failed: %s", gpio, esp_err_to_name(ret));
+        onewire_rmt_deinit();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "1-Wire bus on GPIO%d (RMT, no CPU bit-banging)", gpio);
+    return ESP_OK;
+}
+
+void onewire_rmt_deinit(void)
+{
+    if (s_bytes_encoder) {
+        rmt_del_encoder(s_bytes_encoder);
+        s_bytes_encoder = NULL;
+    }
+    if (s_copy_encoder) {
+        rmt_del_encoder(s_copy_encoder);
+        s_copy_encoder = NULL;
+    }
+    if (s_tx) {
+        rmt_del_channel(s_tx);
+        s_tx = NULL;
+    }
+    if (s_rx) {
+        rmt_del_channel(s_rx);
+        s_rx = NULL;
+    }
+    if (s_rx_queue) {
+        vQueueDelete(s_rx_queue);
+        s_rx_queue = NULL;
+    }
+}
+
+esp_err_t onewire_rmt_reset(bool *out_present)
+{
+    if (!out_present) return ESP_ERR_INVALID_ARG;
+    *out_present = false;
+
+    size_t n = 0;
+    ESP_RETURN_ON_ERROR(onewire_rmt_transfer(s_copy_encoder, &s_reset_symbol, sizeof(s_reset_symbol),
+                                             &s_rx_config_reset, &n),
+                        TAG, "reset failed");
+
+    // Captured: [reset low | released], [presence low | ...]
+    if (n >= 2 && s_rx_symbols[0].level1 == 1 && s_rx_symbols[0].duration1 > ONEWIRE_PRESENCE_WAIT_MIN_US &&
+        s_rx_symbols[1].level0 == 0 && s_rx_symbols[1].duration0 > ONEWIRE_PRESENCE_MIN_US) {
+        *out_present = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t onewire_rmt_write_bytes(const uint8_t *data, size_t len)
+{
+    if (!data || len == 0) return ESP_ERR_INVALID_ARG;
+    return onewire_rmt_transfer(s_bytes_encoder, data, len, NULL, NULL);
+}
+
+esp_err_t onewire_rmt_read_bytes(uint8_t *data, size_t len)
+{
+    if (!data || len == 0) return ESP_ERR_INVALID_ARG;
+
+    // Read slots are write-1 slots; the slave stretches the low phase for a '0'
+    static const uint8_t ones[ONEWIRE_RMT_MAX_RX_BYTES] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    };
+    while (len > 0) {
+        size_t chunk = len < ONEWIRE_RMT_MAX_RX_BYTES ? len : ONEWIRE_RMT_MAX_RX_BYTES;
+        size_t n = 0;
+        ESP_RETURN_ON_ERROR(onewire_rmt_transfer(s_bytes_encoder, ones, chunk, &s_rx_config_slots, &n), TAG,
+                            "read failed");
+        if (n < chunk * 8) return ESP_ERR_INVALID_RESPONSE;
+
+        memset(data, 0, chunk);
+        for (size_t i = 0; i < chunk * 8; i++) {
+            if (s_rx_symbols[i].duration0 <= ONEWIRE_SLOT_SAMPLE_US) {
+                data[i / 8] |= (uint8_t)(1 << (i % 8));
+            }
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    return ESP_OK;
+}
+
+esp_err_t onewire_rmt_write_bit(uint8_t bit)
+{
+    const rmt_symbol_word_t *symbol = bit ? &s_bit1_symbol : &s_bit0_symbol;
+    return onewire_rmt_transfer(s_copy_encoder, symbol, sizeof(*symbol), NULL, NULL);
+}
+
+esp_err_t onewire_rmt_read_bit(uint8_t *out_bit)
+{
+    if (!out_bit) return ESP_ERR_INVALID_ARG;
+    size_t n = 0;
+    ESP_RETURN_ON_ERROR(onewire_rmt_transfer(s_copy_encoder, &s_bit1_symbol, sizeof(s_bit1_symbol),
+                                             &s_rx_config_slots, &n), TAG, "read failed");
+    if (n < 1) return ESP_ERR_INVALID_RESPONSE;
+    *out_bit = s_rx_symbols[0].duration0 <= ONEWIRE_SLOT_SAMPLE_US ? 1 : 0;
+    return ESP_OK;
+}
+
+void onewire_search_init(onewire_search_t *search)
+{
+    if (search) memset(search, 0, sizeof(*search));
+}
+
+esp_err_t onewire_rmt_search_next(onewire_search_t *search, uint8_t search_cmd, bool *out_found)
+{
+    if (!search || !out_found) return ESP_ERR_INVALID_ARG;
+    *out_found = false;
+    if (search->last_device) return ESP_OK;
+
+    bool present = false;
+    ESP_RETURN_ON_ERROR(onewire_rmt_reset(&present), TAG, "search reset failed");
+    if (!present) {
+        onewire_search_init(search);
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(onewire_rmt_write_bytes(&search_cmd, 1), TAG, "search command failed");
+
+    // Every device sends its ROM bit and its complement; where they disagree (both
+    // read 0) the search branches: below the last discrepancy repeat the previous
+    // choice, at it take 1, above it take 0 and remember the position
+    uint8_t last_zero = 0;
+    for (uint8_t pos = 1; pos <= 64; pos++) {
+        uint8_t id_bit = 0, cmp_bit = 0;
+        ESP_RETURN_ON_ERROR(onewire_rmt_read_bit(&id_bit), TAG, "search read failed");
+        ESP_RETURN_ON_ERROR(onewire_rmt_read_bit(&cmp_bit), TAG, "search read failed");
+        if (id_bit && cmp_bit) {
+            // No device left in this branch (device removed mid-search)
+            onewire_search_init(search);
+            return ESP_OK;
+        }
+
+        uint8_t *byte = &search->rom.id[(pos - 1) / 8];
+        uint8_t mask = (uint8_t)(1 << ((pos - 1) % 8));
+        uint8_t dir;
+        if (id_bit != cmp_bit) {
+            dir = id_bit;
+        } else if (pos < search->last_discrepancy) {
+            dir = (*byte & mask) ? 1 : 0;
+        } else {
+            dir = (pos == search->last_discrepancy) ? 1 : 0;
+        }
+        if (id_bit == cmp_bit && dir == 0) last_zero = pos;
+
+        if (dir) {
+            *byte |= mask;
+        } else {
+            *byte &= (uint8_t)~mask;
+        }
+        ESP_RETURN_ON_ERROR(onewire_rmt_write_bit(dir), TAG, "search write failed");
+    }
+
+    search->last_discrepancy = last_zero;
+    search->last_device = (last_zero == 0);
+    if (onewire_crc8(search->rom.id, sizeof(search->rom.id)) != 0) {
+        ESP_LOGW(TAG, "ROM search CRC mismatch");
+        return ESP_ERR_INVALID_CRC;
+    }
+    *out_found = true;
+    return ESP_OK;
+}
+
+uint8_t onewire_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t byte = *data++;
+        for (int i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 1-Wire bus master on the RMT peripheral. Reset pulses and time slots are encoded
+// as RMT symbols and clocked out by hardware; the calling task blocks on the
+// transfer-done event instead of spinning, and interrupts are never masked.
+// One bus per firmware; calls must come from one task at a time.
+
+// ROM commands
+#define ONEWIRE_CMD_SEARCH_ROM   0xF0
+#define ONEWIRE_CMD_MATCH_ROM    0x55
+#define ONEWIRE_CMD_SKIP_ROM     0xCC
+#define ONEWIRE_CMD_ALARM_SEARCH 0xEC
+
+// 64-bit ROM ID: family code, 48-bit serial, CRC-8 (id[0] first on the wire)
+typedef struct {
+    uint8_t id[8];
+} onewire_rom_t;
+
+// ROM search iterator state (Maxim AN187); zero it or use onewire_search_init() to restart
+typedef struct {
+    onewire_rom_t rom;          // ROM found by the last successful step
+    uint8_t last_discrepancy;   // Bit position (1-64) of the last 0-branch taken, 0 = none
+    bool last_device;           // Every branch has been visited
+} onewire_search_t;
+
+// Claim an RMT TX + RX channel pair on the (externally pulled-up) bus GPIO
+esp_err_t onewire_rmt_init(gpio_num_t gpio);
+
+// Release both channels and the encoders
+void onewire_rmt_deinit(void);
+
+// Reset pulse; *out_present is true if at least one device answered with a presence pulse
+esp_err_t onewire_rmt_reset(bool *out_present);
+
+// Write bytes, LSB first
+esp_err_t onewire_rmt_write_bytes(const uint8_t *data, size_t len);
+
+// Read bytes, LSB first
+esp_err_t onewire_rmt_read_bytes(uint8_t *data, size_t len);
+
+// Single time slots (ROM search)
+esp_err_t onewire_rmt_write_bit(uint8_t bit);
+esp_err_t onewire_rmt_read_bit(uint8_t *out_bit);
+
+// Start a new ROM search
+void onewire_search_init(onewire_search_t *search);
+
+// Find the next device answering search_cmd (ONEWIRE_CMD_SEARCH_ROM or
+// ONEWIRE_CMD_ALARM_SEARCH). *out_found is false once all devices were returned.
+// ESP_ERR_INVALID_CRC if the assembled ROM is corrupt (noise on the cable).
+esp_err_t onewire_rmt_search_next(onewire_search_t *search, uint8_t search_cmd, bool *out_found);
+
+// Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1), 0 over data + its CRC byte means valid
+uint8_t onewire_crc8(const uint8_t *data, size_t len);
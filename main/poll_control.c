@@ -0,0 +1,394 @@
+/*
+ * Poll Control
+ *
+ * Design:
+ * - Server attributes are the single source of the intervals; the four writable ones
+ *   (check-in, long poll, short poll, fast-poll timeout) persist as one NVS blob and
+ *   the long poll is also the keep_alive handed to esp_zb_init()
+ * - Fast polling lowers the stack's poll interval to the short poll instead of holding
+ *   a PM lock: the CPU still light-sleeps between polls (the sleep threshold drops
+ *   with it), the radio just asks the parent more often
+ * - Requesters (coordinator, OTA, post-join window) hold independent deadlines; one
+ *   scheduler alarm fires at the earliest and slow polling resumes when none is left
+ * - Client commands reach us as privilege commands, so the stack does not answer them
+ *   on its own; check-ins are sent to the bound clients from a scheduler alarm
+ * - Everything but init/long_poll_ms/cluster_create runs in the Zigbee task
+ */
+
+#include "poll_control.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include <string.h>
+
+static const char *TAG = "POLL_CONTROL";
+static const char *NVS_NAMESPACE = "poll_ctrl";
+static const char *NVS_KEY = "intervals";
+
+#define POLL_CONTROL_CHECK_IN_MAX_QS    0x6E0000U       // ZCL upper bound (~8 h)
+#define POLL_CONTROL_CHECK_IN_WAIT_MS   3000U           // Fast poll while waiting for a check-in response
+#define POLL_CONTROL_FAST_THRESHOLD_MS  20U             // Smallest sleep threshold the stack accepts
+
+/* Client to server commands */
+#define POLL_CONTROL_CMD_CHECK_IN_RSP       0x00
+#define POLL_CONTROL_CMD_FAST_POLL_STOP     0x01
+#define POLL_CONTROL_CMD_SET_LONG_POLL      0x02
+#define POLL_CONTROL_CMD_SET_SHORT_POLL     0x03
+/* Server to client */
+#define POLL_CONTROL_CMD_CHECK_IN           0x00
+
+typedef struct {
+    uint32_t check_in_qs;
+    uint32_t long_poll_qs;
+    uint16_t short_poll_qs;
+    uint16_t fast_timeout_qs;
+} poll_control_intervals_t;
+
+static const poll_control_intervals_t s_defaults = {
+    .check_in_qs = POLL_CONTROL_CHECK_IN_DEFAULT_QS,
+    .long_poll_qs = POLL_CONTROL_LONG_POLL_DEFAULT_QS,
+    .short_poll_qs = POLL_CONTROL_SHORT_POLL_DEFAULT_QS,
+    .fast_timeout_qs = POLL_CONTROL_FAST_TIMEOUT_DEFAULT_QS,
+};
+
+static poll_control_intervals_t s_intervals;
+static uint32_t s_sleep_threshold_ms;
+static uint8_t s_endpoint;
+static bool s_started;
+static bool s_fast;                                     // Poll rate currently applied
+static int64_t s_deadline_us[POLL_CONTROL_REASON_COUNT]; // 0 = no request
+
+static const char *s_reason_names[POLL_CONTROL_REASON_COUNT] = {
+    [POLL_CONTROL_REASON_CLIENT] = "coordinator",
+    [POLL_CONTROL_REASON_OTA] = "OTA",
+    [POLL_CONTROL_REASON_JOIN] = "join",
+};
+
+static void poll_control_fast_poll_expire(uint8_t param);
+static void poll_control_check_in(uint8_t param);
+
+static bool intervals_valid(const poll_control_intervals_t *iv)
+{
+    if (iv->short_poll_qs < 1 || iv->long_poll_qs < iv->short_poll_qs ||
+        iv->long_poll_qs < POLL_CONTROL_LONG_POLL_MIN_QS || iv->long_poll_qs > POLL_CONTROL_LONG_POLL_MAX_QS) {
+        return false;
+    }
+    if (iv->check_in_qs != 0 && (iv->check_in_qs < POLL_CONTROL_CHECK_IN_MIN_QS || iv->check_in_qs < iv->long_poll_qs ||
+                                 iv->check_in_qs > POLL_CONTROL_CHECK_IN_MAX_QS)) {
+        return false;
+    }
+    return iv->fast_timeout_qs >= 1 && iv->fast_timeout_qs <= POLL_CONTROL_FAST_TIMEOUT_MAX_QS;
+}
+
+static esp_err_t intervals_save(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = nvs_set_blob(nvs_handle, NVS_KEY, &s_intervals, sizeof(s_intervals));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store intervals: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* Mirror the intervals into the server attributes */
+static void intervals_publish(void)
+{
+    esp_zb_zcl_set_attribute_val(s_endpoint, ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POLL_CONTROL_CHECK_IN_INTERVAL_ID, &s_intervals.check_in_qs, false);
+    esp_zb_zcl_set_attribute_val(s_endpoint, ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POLL_CONTROL_LONG_POLL_INTERVAL_ID, &s_intervals.long_poll_qs, false);
+    esp_zb_zcl_set_attribute_val(s_endpoint, ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POLL_CONTROL_SHORT_POLL_INTERVAL_ID, &s_intervals.short_poll_qs, false);
+    esp_zb_zcl_set_attribute_val(s_endpoint, ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POLL_CONTROL_FAST_POLL_TIMEOUT_ID, &s_intervals.fast_timeout_qs, false);
+}
+
+/* Apply the poll rate that matches the active requests */
+static void poll_rate_apply(void)
+{
+    bool fast = poll_control_is_fast_polling();
+    if (fast) {
+        uint32_t short_ms = POLL_CONTROL_QS_TO_MS(s_intervals.short_poll_qs);
+        uint32_t threshold = short_ms / 2 > POLL_CONTROL_FAST_THRESHOLD_MS ? short_ms / 2 : POLL_CONTROL_FAST_THRESHOLD_MS;
+        esp_zb_zdo_pim_set_long_poll_interval(short_ms);
+        esp_zb_sleep_set_threshold(threshold);
+    } else {
+        /* The threshold has to stay below the poll interval, or CAN_SLEEP never comes */
+        uint32_t long_ms = POLL_CONTROL_QS_TO_MS(s_intervals.long_poll_qs);
+        esp_zb_zdo_pim_set_long_poll_interval(long_ms);
+        esp_zb_sleep_set_threshold(s_sleep_threshold_ms < long_ms ? s_sleep_threshold_ms : long_ms / 2);
+    }
+    if (fast != s_fast) {
+        ESP_LOGI(TAG, fast ? "⚡ Fast polling every %lu ms" : "🐢 Long polling every %lu ms",
+                 (unsigned long)POLL_CONTROL_QS_TO_MS(fast ? s_intervals.short_poll_qs : s_intervals.long_poll_qs));
+        s_fast = fast;
+    }
+}
+
+/* Drop expired requests, re-arm the alarm for the earliest remaining one */
+static void fast_poll_reschedule(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t next = 0;
+    for (int r = 0; r < POLL_CONTROL_REASON_COUNT; r++) {
+        if (s_deadline_us[r] != 0 && s_deadline_us[r] <= now) {
+            ESP_LOGI(TAG, "Fast-poll window of %s expired", s_reason_names[r]);
+            s_deadline_us[r] = 0;
+        }
+        if (s_deadline_us[r] != 0 && (next == 0 || s_deadline_us[r] < next)) {
+            next = s_deadline_us[r];
+        }
+    }
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)poll_control_fast_poll_expire, 0);
+    if (next != 0) {
+        esp_zb_scheduler_alarm((esp_zb_callback_t)poll_control_fast_poll_expire, 0,
+                               (uint32_t)((next - now + 999) / 1000));
+    }
+    poll_rate_apply();
+}
+
+static void poll_control_fast_poll_expire(uint8_t param)
+{
+    (void)param;  // Unused
+    fast_poll_reschedule();
+}
+
+static void check_in_schedule(void)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)poll_control_check_in, 0);
+    if (s_started && s_intervals.check_in_qs != 0) {
+        esp_zb_scheduler_alarm((esp_zb_callback_t)poll_control_check_in, 0, POLL_CONTROL_QS_TO_MS(s_intervals.check_in_qs));
+    }
+}
+
+/* Check-in to every bound client, then poll fast for a moment to pick up the response */
+static void poll_control_check_in(uint8_t param)
+{
+    (void)param;  // Unused
+    if (!s_started) {
+        return;
+    }
+    esp_zb_zcl_custom_cluster_cmd_t cmd = {
+        .zcl_basic_cmd.src_endpoint = s_endpoint,
+        .address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL,
+        .custom_cmd_id = POLL_CONTROL_CMD_CHECK_IN,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .data.type = ESP_ZB_ZCL_ATTR_TYPE_NULL,
+    };
+    esp_zb_zcl_custom_cluster_cmd_req(&cmd);
+    ESP_LOGI(TAG, "📣 Check-in sent");
+    poll_control_fast_poll(POLL_CONTROL_REASON_CLIENT, POLL_CONTROL_CHECK_IN_WAIT_MS);
+    check_in_schedule();
+}
+
+/* Validate, store and apply a new interval set */
+static esp_err_t intervals_update(const poll_control_intervals_t *iv)
+{
+    if (!intervals_valid(iv)) {
+        ESP_LOGW(TAG, "Rejected intervals: check-in %lu, long %lu, short %u, fast timeout %u (qs)",
+                 (unsigned long)iv->check_in_qs, (unsigned long)iv->long_poll_qs, iv->short_poll_qs, iv->fast_timeout_qs);
+        intervals_publish();
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool check_in_changed = iv->check_in_qs != s_intervals.check_in_qs;
+    if (memcmp(iv, &s_intervals, sizeof(s_intervals)) == 0) {
+        return ESP_OK;
+    }
+    s_intervals = *iv;
+    intervals_publish();
+    poll_rate_apply();
+    if (check_in_changed) {
+        check_in_schedule();
+    }
+    ESP_LOGI(TAG, "💾 Intervals: check-in %lu s, long %lu ms, short %lu ms, fast timeout %lu s",
+             (unsigned long)(s_intervals.check_in_qs / 4), (unsigned long)POLL_CONTROL_QS_TO_MS(s_intervals.long_poll_qs),
+             (unsigned long)POLL_CONTROL_QS_TO_MS(s_intervals.short_poll_qs), (unsigned long)(s_intervals.fast_timeout_qs / 4));
+    return intervals_save();
+}
+
+esp_err_t poll_control_init(uint32_t sleep_threshold_ms)
+{
+    s_intervals = s_defaults;
+    s_sleep_threshold_ms = sleep_threshold_ms;
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return ESP_OK;      // Nothing stored yet
+    }
+    poll_control_intervals_t stored;
+    size_t size = sizeof(stored);
+    esp_err_t ret = nvs_get_blob(nvs_handle, NVS_KEY, &stored, &size);
+    nvs_close(nvs_handle);
+    if (ret == ESP_OK && size == sizeof(stored) && intervals_valid(&stored)) {
+        s_intervals = stored;
+        ESP_LOGI(TAG, "📂 Intervals loaded from NVS: check-in %lu s, long poll %lu ms",
+                 (unsigned long)(s_intervals.check_in_qs / 4), (unsigned long)POLL_CONTROL_QS_TO_MS(s_intervals.long_poll_qs));
+    } else if (ret != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "Stored intervals invalid - using defaults");
+    }
+    return ESP_OK;
+}
+
+uint32_t poll_control_long_poll_ms(void)
+{
+    return POLL_CONTROL_QS_TO_MS(s_intervals.long_poll_qs);
+}
+
+esp_zb_attribute_list_t *poll_control_cluster_create(void)
+{
+    esp_zb_poll_control_cluster_cfg_t cfg = {
+        .check_in_interval = s_intervals.check_in_qs,
+        .long_poll_interval = s_intervals.long_poll_qs,
+        .short_poll_interval = s_intervals.short_poll_qs,
+        .fast_poll_timeout = s_intervals.fast_timeout_qs,
+        .check_in_interval_min = POLL_CONTROL_CHECK_IN_MIN_QS,
+        .long_poll_interval_min = POLL_CONTROL_LONG_POLL_MIN_QS,
+        .fast_poll_timeout_max = POLL_CONTROL_FAST_TIMEOUT_MAX_QS,
+    };
+    return esp_zb_poll_control_cluster_create(&cfg);
+}
+
+esp_err_t poll_control_register(uint8_t endpoint)
+{
+    static const uint16_t commands[] = {
+        POLL_CONTROL_CMD_CHECK_IN_RSP, POLL_CONTROL_CMD_FAST_POLL_STOP,
+        POLL_CONTROL_CMD_SET_LONG_POLL, POLL_CONTROL_CMD_SET_SHORT_POLL,
+    };
+    s_endpoint = endpoint;
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        ESP_RETURN_ON_ERROR(esp_zb_zcl_add_privilege_command(endpoint, ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, commands[i]),
+                            TAG, "Failed to register command 0x%02x", commands[i]);
+    }
+    return ESP_OK;
+}
+
+void poll_control_start(void)
+{
+    s_started = true;
+    poll_rate_apply();
+    check_in_schedule();
+    ESP_LOGI(TAG, "📡 Long poll %lu ms, check-in every %lu s", (unsigned long)poll_control_long_poll_ms(),
+             (unsigned long)(s_intervals.check_in_qs / 4));
+}
+
+void poll_control_stop(void)
+{
+    s_started = false;
+    memset(s_deadline_us, 0, sizeof(s_deadline_us));
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)poll_control_check_in, 0);
+    fast_poll_reschedule();
+}
+
+void poll_control_fast_poll(poll_control_reason_t reason, uint32_t timeout_ms)
+{
+    if ((unsigned)reason >= POLL_CONTROL_REASON_COUNT) {
+        return;
+    }
+    if (timeout_ms == 0) {
+        timeout_ms = POLL_CONTROL_QS_TO_MS(s_intervals.fast_timeout_qs);
+    }
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    if (s_deadline_us[reason] == 0) {
+        ESP_LOGI(TAG, "Fast poll requested by %s for %lu ms", s_reason_names[reason], (unsigned long)timeout_ms);
+    }
+    if (deadline > s_deadline_us[reason]) {
+        s_deadline_us[reason] = deadline;
+    }
+    fast_poll_reschedule();
+}
+
+void poll_control_fast_poll_stop(poll_control_reason_t reason)
+{
+    if ((unsigned)reason >= POLL_CONTROL_REASON_COUNT || s_deadline_us[reason] == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "Fast poll of %s stopped", s_reason_names[reason]);
+    s_deadline_us[reason] = 0;
+    fast_poll_reschedule();
+}
+
+bool poll_control_is_fast_polling(void)
+{
+    for (int r = 0; r < POLL_CONTROL_REASON_COUNT; r++) {
+        if (s_deadline_us[r] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t poll_control_attribute_written(uint16_t attr_id, const void *value)
+{
+    ESP_RETURN_ON_FALSE(value, ESP_ERR_INVALID_ARG, TAG, "Empty attribute value");
+    poll_control_intervals_t iv = s_intervals;
+    switch (attr_id) {
+    case ESP_ZB_ZCL_ATTR_POLL_CONTROL_CHECK_IN_INTERVAL_ID:
+        iv.check_in_qs = *(const uint32_t *)value;
+        break;
+    case ESP_ZB_ZCL_ATTR_POLL_CONTROL_LONG_POLL_INTERVAL_ID:
+        iv.long_poll_qs = *(const uint32_t *)value;
+        break;
+    case ESP_ZB_ZCL_ATTR_POLL_CONTROL_SHORT_POLL_INTERVAL_ID:
+        iv.short_poll_qs = *(const uint16_t *)value;
+        break;
+    case ESP_ZB_ZCL_ATTR_POLL_CONTROL_FAST_POLL_TIMEOUT_ID:
+        iv.fast_timeout_qs = *(const uint16_t *)value;
+        break;
+    default:
+        return ESP_OK;      // Read-only limits
+    }
+    return intervals_update(&iv);
+}
+
+esp_err_t poll_control_command_handler(const esp_zb_zcl_privilege_command_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    if (message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL) {
+        return ESP_OK;
+    }
+    const uint8_t *data = (const uint8_t *)message->data;
+    poll_control_intervals_t iv = s_intervals;
+
+    switch (message->info.command.id) {
+    case POLL_CONTROL_CMD_CHECK_IN_RSP: {
+        ESP_RETURN_ON_FALSE(data && message->size >= 3, ESP_ERR_INVALID_SIZE, TAG, "Short check-in response");
+        uint16_t timeout_qs = (uint16_t)(data[1] | (data[2] << 8));
+        if (!data[0]) {
+            poll_control_fast_poll_stop(POLL_CONTROL_REASON_CLIENT);
+            return ESP_OK;
+        }
+        ESP_RETURN_ON_FALSE(timeout_qs <= POLL_CONTROL_FAST_TIMEOUT_MAX_QS, ESP_ERR_INVALID_ARG, TAG,
+                            "Fast-poll timeout %u qs above maximum", timeout_qs);
+        /* Replaces the short check-in wait: the requested window starts now */
+        s_deadline_us[POLL_CONTROL_REASON_CLIENT] = 0;
+        poll_control_fast_poll(POLL_CONTROL_REASON_CLIENT, POLL_CONTROL_QS_TO_MS(timeout_qs));
+        return ESP_OK;
+    }
+    case POLL_CONTROL_CMD_FAST_POLL_STOP:
+        poll_control_fast_poll_stop(POLL_CONTROL_REASON_CLIENT);
+        return ESP_OK;
+    case POLL_CONTROL_CMD_SET_LONG_POLL:
+        ESP_RETURN_ON_FALSE(data && message->size >= 4, ESP_ERR_INVALID_SIZE, TAG, "Short Set Long Poll Interval");
+        iv.long_poll_qs = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        return intervals_update(&iv);
+    case POLL_CONTROL_CMD_SET_SHORT_POLL:
+        ESP_RETURN_ON_FALSE(data && message->size >= 2, ESP_ERR_INVALID_SIZE, TAG, "Short Set Short Poll Interval");
+        iv.short_poll_qs = (uint16_t)(data[0] | (data[1] << 8));
+        return intervals_update(&iv);
+    default:
+        ESP_LOGW(TAG, "Unhandled command 0x%02x", message->info.command.id);
+        return ESP_OK;
+    }
+}
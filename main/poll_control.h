@@ -0,0 +1,109 @@
+/*
+ * Poll Control
+ * ZCL Poll Control (0x0020) server: check-in, long/short poll and fast-poll
+ * timeout persisted in NVS, and fast-poll windows requested by the coordinator
+ * or by the application (OTA, post-join configuration)
+ */
+
+#ifndef POLL_CONTROL_H
+#define POLL_CONTROL_H
+
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ZCL intervals are in quarter seconds */
+#define POLL_CONTROL_QS_TO_MS(qs)           ((uint32_t)(qs) * 250U)
+
+/* Defaults: the long poll stays below the parent's 7.68 s indirect-frame persistence,
+ * so coordinator writes still arrive without a check-in; raise it over Zigbee to
+ * trade command latency for fewer wake-ups */
+#define POLL_CONTROL_CHECK_IN_DEFAULT_QS    (60U * 60U * 4U)    // 1 h
+#define POLL_CONTROL_LONG_POLL_DEFAULT_QS   30U                 // 7.5 s
+#define POLL_CONTROL_SHORT_POLL_DEFAULT_QS  2U                  // 0.5 s
+#define POLL_CONTROL_FAST_TIMEOUT_DEFAULT_QS 40U                // 10 s
+
+/* Limits (server-side minimum/maximum attributes) */
+#define POLL_CONTROL_CHECK_IN_MIN_QS        (60U * 4U)          // 1 min
+#define POLL_CONTROL_LONG_POLL_MIN_QS       4U                  // 1 s
+#define POLL_CONTROL_LONG_POLL_MAX_QS       (60U * 60U * 4U)    // 1 h, below the 64 min parent timeout
+#define POLL_CONTROL_FAST_TIMEOUT_MAX_QS    (10U * 60U * 4U)    // 10 min
+
+/* Independent fast-poll requests; polling stays fast while any of them is active */
+typedef enum {
+    POLL_CONTROL_REASON_CLIENT = 0,     // Check-in response / awaiting it (ends with Fast Poll Stop)
+    POLL_CONTROL_REASON_OTA,            // Image transfer in progress
+    POLL_CONTROL_REASON_JOIN,           // Interview and reporting setup after a join
+    POLL_CONTROL_REASON_COUNT,
+} poll_control_reason_t;
+
+/**
+ * @brief Load the intervals from NVS (defaults if none stored)
+ * @param sleep_threshold_ms Idle time before CAN_SLEEP used outside fast polling
+ */
+esp_err_t poll_control_init(uint32_t sleep_threshold_ms);
+
+/**
+ * @brief Long poll interval in ms (keep_alive for esp_zb_init)
+ */
+uint32_t poll_control_long_poll_ms(void);
+
+/**
+ * @brief Create the Poll Control server cluster with the loaded intervals
+ */
+esp_zb_attribute_list_t *poll_control_cluster_create(void);
+
+/**
+ * @brief Register the client commands with the application (after esp_zb_device_register)
+ * @param endpoint Endpoint that hosts the server cluster
+ */
+esp_err_t poll_control_register(uint8_t endpoint);
+
+/**
+ * @brief Network joined: apply the long poll interval and start the check-in cycle
+ */
+void poll_control_start(void);
+
+/**
+ * @brief Network lost: stop check-ins and every fast-poll request
+ */
+void poll_control_stop(void);
+
+/**
+ * @brief Start or extend a fast-poll window (Zigbee task context)
+ * @param reason     Requester
+ * @param timeout_ms Window length from now; 0 uses the FastPollTimeout attribute
+ */
+void poll_control_fast_poll(poll_control_reason_t reason, uint32_t timeout_ms);
+
+/**
+ * @brief End the fast-poll request of one requester (Zigbee task context)
+ */
+void poll_control_fast_poll_stop(poll_control_reason_t reason);
+
+/**
+ * @brief true while any fast-poll request is active
+ */
+bool poll_control_is_fast_polling(void);
+
+/**
+ * @brief Validate, apply and persist a written Poll Control attribute
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if the value violates the interval constraints (attribute restored)
+ */
+esp_err_t poll_control_attribute_written(uint16_t attr_id, const void *value);
+
+/**
+ * @brief Handle a Poll Control client command (check-in response, fast poll stop, set long/short poll)
+ */
+esp_err_t poll_control_command_handler(const esp_zb_zcl_privilege_command_message_t *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POLL_CONTROL_H
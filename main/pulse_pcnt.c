@@ -0,0 +1,179 @@
+/*
+ * Hardware Pulse Counting
+ *
+ * Design:
+ * - Rising edges increment a PCNT unit through its glitch filter; no per-edge interrupt
+ * - High limit = threshold with accumulation: the unit wraps in hardware and the
+ *   watch-point interrupt tells the owner every `threshold` pulses, so a fast input
+ *   costs one wake-up per threshold instead of one per edge
+ * - PCNT needs the APB clock, which stops in light sleep. The GPIO interrupt (also the
+ *   light-sleep wake source) marks the start of a burst, takes a no-light-sleep PM lock
+ *   and masks itself; pulse_pcnt_take() ends the burst once a flush interval passes
+ *   without pulses
+ * - The burst-start edge is added in software only if the unit did not see it: the
+ *   count had not moved when the interrupt ran and the chip was woken by GPIO
+ * - The light-sleep wake source is level triggered (HIGH), and so is the pin interrupt
+ *   once gpio_wakeup_enable() has set it: a burst only ends while the input reads low,
+ *   otherwise re-arming would fire at once and start a phantom burst
+ */
+
+#include "pulse_pcnt.h"
+#include "driver/pulse_cnt.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+
+static const char *TAG = "PULSE_PCNT";
+
+struct pulse_pcnt_t {
+    gpio_num_t gpio;
+    pcnt_unit_handle_t unit;
+    pcnt_channel_handle_t chan;
+    esp_pm_lock_handle_t pm_lock;   // Held while a burst is active (NULL without CONFIG_PM_ENABLE)
+    pulse_pcnt_event_cb_t on_event;
+    void *user_ctx;
+    portMUX_TYPE lock;
+    uint32_t last_total;            // Accumulated unit count at the previous take
+    bool start_unseen;              // Count had not moved when the burst-start interrupt ran
+    bool active;
+};
+
+static void IRAM_ATTR pulse_pcnt_gpio_isr(void *arg)
+{
+    struct pulse_pcnt_t *p = arg;
+    int count = 0;
+    pcnt_unit_get_count(p->unit, &count);
+
+    bool started = false;
+    portENTER_CRITICAL_ISR(&p->lock);
+    if (!p->active) {
+        p->active = true;
+        started = true;
+        p->start_unseen = (uint32_t)count == p->last_total;
+    }
+    portEXIT_CRITICAL_ISR(&p->lock);
+
+    gpio_intr_disable(p->gpio);
+    if (!started) return;
+    if (p->pm_lock) esp_pm_lock_acquire(p->pm_lock);
+    if (p->on_event && p->on_event(p->user_ctx)) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static bool IRAM_ATTR pulse_pcnt_on_reach(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *user_ctx)
+{
+    struct pulse_pcnt_t *p = user_ctx;
+    return p->on_event ? p->on_event(p->user_ctx) : false;
+}
+
+static void pulse_pcnt_free(struct pulse_pcnt_t *p)
+{
+    if (p->chan) pcnt_del_channel(p->chan);
+    if (p->unit) pcnt_del_unit(p->unit);
+    if (p->pm_lock) esp_pm_lock_delete(p->pm_lock);
+    free(p);
+}
+
+esp_err_t pulse_pcnt_new(const pulse_pcnt_config_t *config, pulse_pcnt_handle_t *out_handle)
+{
+    ESP_RETURN_ON_FALSE(config && out_handle, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->threshold > 0 && config->threshold <= INT16_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "threshold out of range");
+
+    struct pulse_pcnt_t *p = calloc(1, sizeof(*p));
+    ESP_RETURN_ON_FALSE(p, ESP_ERR_NO_MEM, TAG, "no memory");
+    p->gpio = config->gpio;
+    p->on_event = config->on_event;
+    p->user_ctx = config->user_ctx;
+    portMUX_INITIALIZE(&p->lock);
+
+    esp_err_t ret = ESP_OK;
+    pcnt_unit_config_t unit_config = {
+        .low_limit = -1,
+        .high_limit = config->threshold,
+        .flags.accum_count = 1,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_new_unit(&unit_config, &p->unit), err, TAG, "no free PCNT unit");
+
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = PULSE_PCNT_GLITCH_NS,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_unit_set_glitch_filter(p->unit, &filter_config), err, TAG, "glitch filter failed");
+
+    pcnt_chan_config_t chan_config = {
+        .edge_gpio_num = config->gpio,
+        .level_gpio_num = -1,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_new_channel(p->unit, &chan_config, &p->chan), err, TAG, "PCNT channel failed");
+    ESP_GOTO_ON_ERROR(pcnt_channel_set_edge_action(p->chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                                   PCNT_CHANNEL_EDGE_ACTION_HOLD), err, TAG, "edge action failed");
+
+    // Accumulation needs the high limit as watch point; it doubles as the threshold event
+    ESP_GOTO_ON_ERROR(pcnt_unit_add_watch_point(p->unit, config->threshold), err, TAG, "watch point failed");
+    pcnt_event_callbacks_t cbs = {
+        .on_reach = pulse_pcnt_on_reach,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_unit_register_event_callbacks(p->unit, &cbs, p), err, TAG, "callback failed");
+
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "pcnt_burst", &p->pm_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No PM lock (%s) - counting only while awake anyway", esp_err_to_name(ret));
+        p->pm_lock = NULL;
+    }
+
+    ESP_GOTO_ON_ERROR(pcnt_unit_enable(p->unit), err, TAG, "enable failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_clear_count(p->unit), err, TAG, "clear failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_start(p->unit), err, TAG, "start failed");
+
+    ESP_GOTO_ON_ERROR(gpio_isr_handler_add(config->gpio, pulse_pcnt_gpio_isr, p), err, TAG, "GPIO ISR failed");
+    gpio_intr_enable(config->gpio);
+
+    ESP_LOGI(TAG, "✅ GPIO%d counted by PCNT (glitch filter %d ns, event every %d pulses)", config->gpio,
+             PULSE_PCNT_GLITCH_NS, config->threshold);
+    *out_handle = p;
+    return ESP_OK;
+
+err:
+    pulse_pcnt_free(p);
+    return ret;
+}
+
+esp_err_t pulse_pcnt_take(pulse_pcnt_handle_t handle, uint32_t *out_pulses, bool *out_active)
+{
+    ESP_RETURN_ON_FALSE(handle && out_pulses, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    struct pulse_pcnt_t *p = handle;
+    int count = 0;
+    ESP_RETURN_ON_ERROR(pcnt_unit_get_count(p->unit, &count), TAG, "read failed");
+    // The PM lock keeps the chip awake during a burst: the wake cause is still that of its start
+    const bool gpio_wake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+    const bool input_high = gpio_get_level(p->gpio) != 0;
+
+    portENTER_CRITICAL(&p->lock);
+    uint32_t pulses = (uint32_t)count - p->last_total;
+    if (p->start_unseen && gpio_wake) {
+        pulses++;   // Rising edge that woke the chip while the PCNT clock was stopped
+    }
+    p->last_total = (uint32_t)count;
+    p->start_unseen = false;
+    bool ended = p->active && pulses == 0 && !input_high;
+    if (ended) {
+        p->active = false;
+    }
+    bool active = p->active;
+    portEXIT_CRITICAL(&p->lock);
+
+    if (ended) {
+        // Edges from here on are counted by the unit and picked up by the next take
+        gpio_intr_enable(p->gpio);
+        if (p->pm_lock) esp_pm_lock_release(p->pm_lock);
+        ESP_LOGD(TAG, "GPIO%d burst ended", p->gpio);
+    }
+
+    *out_pulses = pulses;
+    if (out_active) *out_active = active;
+    return ESP_OK;
+}
@@ -0,0 +1,71 @@
+/*
+ * Hardware Pulse Counting
+ * PCNT unit with glitch filter behind a GPIO input: edges are counted by the
+ * peripheral, the CPU is only woken for the first edge of a burst, when a
+ * threshold is reached, and when the owner collects the count
+ */
+
+#ifndef PULSE_PCNT_H
+#define PULSE_PCNT_H
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pulses shorter than this are dropped by the PCNT glitch filter (hardware limit ~1 µs
+ * at the 32 MHz APB clock). Contact bounce lasts milliseconds: reed switches on a PCNT
+ * input need an RC filter in front of the pin. */
+#ifndef PULSE_PCNT_GLITCH_NS
+#define PULSE_PCNT_GLITCH_NS 1000
+#endif
+
+typedef struct pulse_pcnt_t *pulse_pcnt_handle_t;
+
+/**
+ * @brief Burst start / threshold notification, called from ISR context
+ * @param user_ctx pulse_pcnt_config_t::user_ctx
+ * @return true if a higher priority task was woken
+ */
+typedef bool (*pulse_pcnt_event_cb_t)(void *user_ctx);
+
+typedef struct {
+    gpio_num_t gpio;                /*!< Input, already configured (pull, wake source) by the owner */
+    int threshold;                  /*!< Pulses per threshold event (PCNT high limit), 1..32767 */
+    pulse_pcnt_event_cb_t on_event; /*!< Burst start and every threshold pulses */
+    void *user_ctx;
+} pulse_pcnt_config_t;
+
+/**
+ * @brief Attach a PCNT unit to a rising-edge input
+ *
+ * The GPIO ISR service must already be installed. The GPIO interrupt only fires for
+ * the first edge of a burst: it holds a no-light-sleep PM lock (the PCNT clock stops
+ * in light sleep) and masks itself until pulse_pcnt_take() sees the input go quiet.
+ * The edge that woke the chip from light sleep is added in software. The owner's
+ * gpio_wakeup_enable() leaves the pin interrupt level triggered (HIGH).
+ */
+esp_err_t pulse_pcnt_new(const pulse_pcnt_config_t *config, pulse_pcnt_handle_t *out_handle);
+
+/**
+ * @brief Pulses counted since the previous call
+ *
+ * Call on the owner's flush timer while a burst is active. A call that finds no new
+ * pulse while the input reads low ends the burst: the PM lock is released and the
+ * GPIO interrupt re-armed. A pin held high keeps the burst (and the chip) awake.
+ *
+ * @param handle     Counter
+ * @param out_pulses New pulses
+ * @param out_active true while the burst continues (call again after the flush interval)
+ */
+esp_err_t pulse_pcnt_take(pulse_pcnt_handle_t handle, uint32_t *out_pulses, bool *out_active);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PULSE_PCNT_H */
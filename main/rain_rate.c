@@ -0,0 +1,211 @@
+/*
+ * Rain Rate
+ *
+ * Design:
+ * - Ring of RAIN_RATE_RING_LEN uint16 gaps (100 ms units, saturating at ~109 min)
+ *   plus the absolute time of the newest tip: 2 bytes per tip instead of 8
+ * - Time base is the RTC timer (keeps running through light sleep and software
+ *   resets); the ISR tick of each tip is converted by its age at record time
+ * - Record in RTC memory with magic + CRC, so a reset during a storm keeps the window
+ * - Window rates walk the ring from the newest tip; if the ring runs out inside the
+ *   window the rate is extrapolated over the span it does cover
+ * - Reporting is change-driven: the caller only sets attributes when the intensity
+ *   class or the rate moved noticeably, so dry periods produce no traffic
+ */
+
+#include "rain_rate.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_private/esp_clk.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "RAIN_RATE";
+
+#define RAIN_RATE_MAGIC        0x5A1E7E01
+#define RAIN_RATE_GAP_UNIT_MS  100
+#define RAIN_RATE_GAP_UNKNOWN  0xFFFF
+#define RAIN_RATE_10MIN_MS     (10 * 60 * 1000)
+#define RAIN_RATE_1H_MS        (60 * 60 * 1000)
+#define RAIN_RATE_MIN_SPAN_MS  (60 * 1000)     // Shortest span a window rate is extrapolated from
+
+typedef struct {
+    uint32_t magic;
+    int64_t newest_ms;                      // RTC time of the newest tip
+    uint16_t head;                          // Index of the newest tip
+    uint16_t count;
+    uint16_t gap[RAIN_RATE_RING_LEN];       // Gap to the previous tip, 100 ms units
+    float reported[3];                      // Last committed instant / 10 min / 1 h
+    uint32_t crc;
+} rain_rate_ring_t;
+
+static RTC_DATA_ATTR rain_rate_ring_t s_ring;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static float s_mm_per_tip;
+
+static int64_t rain_rate_now_ms(void)
+{
+    return (int64_t)(esp_clk_rtc_time() / 1000ULL);
+}
+
+static uint32_t rain_rate_crc(void)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&s_ring, offsetof(rain_rate_ring_t, crc));
+}
+
+void rain_rate_init(float mm_per_tip)
+{
+    s_mm_per_tip = mm_per_tip;
+    bool valid = s_ring.magic == RAIN_RATE_MAGIC && s_ring.crc == rain_rate_crc() &&
+                 s_ring.count <= RAIN_RATE_RING_LEN && s_ring.head < RAIN_RATE_RING_LEN &&
+                 s_ring.newest_ms <= rain_rate_now_ms();
+    if (!valid) {
+        memset(&s_ring, 0, sizeof(s_ring));
+        s_ring.magic = RAIN_RATE_MAGIC;
+        s_ring.crc = rain_rate_crc();
+        ESP_LOGI(TAG, "Tip ring reset");
+        return;
+    }
+    ESP_LOGI(TAG, "📂 %u tip(s) restored from RTC, newest %lld s ago", s_ring.count,
+             (long long)((rain_rate_now_ms() - s_ring.newest_ms) / 1000));
+}
+
+void rain_rate_record(uint32_t tips, uint32_t tick_ms)
+{
+    uint32_t age_ms = pdTICKS_TO_MS(xTaskGetTickCount()) - tick_ms;
+    int64_t when = rain_rate_now_ms() - age_ms;
+
+    portENTER_CRITICAL(&s_lock);
+    for (uint32_t i = 0; i < tips; i++) {
+        uint16_t gap = RAIN_RATE_GAP_UNKNOWN;
+        if (s_ring.count > 0) {
+            int64_t delta = (when - s_ring.newest_ms) / RAIN_RATE_GAP_UNIT_MS;
+            gap = delta < 0 ? 0 : delta >= RAIN_RATE_GAP_UNKNOWN ? RAIN_RATE_GAP_UNKNOWN : (uint16_t)delta;
+        }
+        s_ring.head = (s_ring.head + 1) % RAIN_RATE_RING_LEN;
+        s_ring.gap[s_ring.head] = gap;
+        if (when > s_ring.newest_ms || s_ring.count == 0) {
+            s_ring.newest_ms = when;
+        }
+        if (s_ring.count < RAIN_RATE_RING_LEN) {
+            s_ring.count++;
+        }
+    }
+    s_ring.crc = rain_rate_crc();
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/* Tips within window_ms of now, extrapolated if the ring ends inside the window */
+static float rain_rate_window(const rain_rate_ring_t *ring, int64_t now_ms, int64_t window_ms)
+{
+    int64_t age = now_ms - ring->newest_ms;
+    int64_t oldest_age = 0;
+    uint32_t tips = 0;
+    bool covered = ring->count < RAIN_RATE_RING_LEN;
+    uint16_t idx = ring->head;
+    for (uint16_t k = 0; k < ring->count; k++) {
+        if (age > window_ms) {
+            covered = true;
+            break;
+        }
+        tips++;
+        oldest_age = age;
+        if (k + 1 == ring->count) {
+            break;
+        }
+        if (ring->gap[idx] == RAIN_RATE_GAP_UNKNOWN) {
+            covered = true;     // Nothing older that could fall in the window
+            break;
+        }
+        age += (int64_t)ring->gap[idx] * RAIN_RATE_GAP_UNIT_MS;
+        idx = (idx + RAIN_RATE_RING_LEN - 1) % RAIN_RATE_RING_LEN;
+    }
+    int64_t span = window_ms;
+    if (!covered && tips > 0) {
+        span = oldest_age > RAIN_RATE_MIN_SPAN_MS ? oldest_age : RAIN_RATE_MIN_SPAN_MS;
+    }
+    return tips * s_mm_per_tip * (3600000.0f / (float)span);
+}
+
+static float rain_rate_instant(const rain_rate_ring_t *ring, int64_t now_ms)
+{
+    if (ring->count == 0) {
+        return 0.0f;
+    }
+    int64_t since_last = now_ms - ring->newest_ms;
+    if (since_last > RAIN_RATE_DRY_TIMEOUT_S * 1000LL) {
+        return 0.0f;
+    }
+    /* Tips delivered together count as one interval */
+    uint32_t tips = 1;
+    int64_t gap_ms = RAIN_RATE_DRY_TIMEOUT_S * 1000LL;
+    uint16_t idx = ring->head;
+    for (uint16_t k = 0; k + 1 < ring->count; k++) {
+        uint16_t gap = ring->gap[idx];
+        if (gap == RAIN_RATE_GAP_UNKNOWN) {
+            break;
+        }
+        if (gap > 0) {
+            gap_ms = (int64_t)gap * RAIN_RATE_GAP_UNIT_MS;
+            break;
+        }
+        tips++;
+        idx = (idx + RAIN_RATE_RING_LEN - 1) % RAIN_RATE_RING_LEN;
+    }
+    /* Decays while dry: the next tip is at least as far away as the time already waited */
+    int64_t interval = gap_ms > since_last ? gap_ms : since_last;
+    if (interval < 1000) {
+        interval = 1000;
+    }
+    return tips * s_mm_per_tip * (3600000.0f / (float)interval);
+}
+
+/* 0 none, 1 light, 2 moderate, 3 heavy, 4 violent (mm/h) */
+static int rain_rate_class(float mm_h)
+{
+    if (mm_h <= 0.0f) return 0;
+    if (mm_h < 2.5f) return 1;
+    if (mm_h < 7.6f) return 2;
+    if (mm_h < 50.0f) return 3;
+    return 4;
+}
+
+static bool rain_rate_moved(float now, float reported)
+{
+    if (rain_rate_class(now) != rain_rate_class(reported)) {
+        return true;
+    }
+    float delta = fabsf(now - reported);
+    return delta >= RAIN_RATE_REPORT_MIN_DELTA && delta >= reported * RAIN_RATE_REPORT_REL_DELTA;
+}
+
+bool rain_rate_poll(rain_rate_t *out)
+{
+    rain_rate_ring_t ring;
+    portENTER_CRITICAL(&s_lock);
+    ring = s_ring;
+    portEXIT_CRITICAL(&s_lock);
+
+    int64_t now_ms = rain_rate_now_ms();
+    out->instant_mm_h = rain_rate_instant(&ring, now_ms);
+    out->rate_10min_mm_h = rain_rate_window(&ring, now_ms, RAIN_RATE_10MIN_MS);
+    out->rate_1h_mm_h = rain_rate_window(&ring, now_ms, RAIN_RATE_1H_MS);
+
+    return rain_rate_moved(out->instant_mm_h, ring.reported[0]) ||
+           rain_rate_moved(out->rate_10min_mm_h, ring.reported[1]) ||
+           rain_rate_moved(out->rate_1h_mm_h, ring.reported[2]);
+}
+
+void rain_rate_commit(const rain_rate_t *rate)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_ring.reported[0] = rate->instant_mm_h;
+    s_ring.reported[1] = rate->rate_10min_mm_h;
+    s_ring.reported[2] = rate->rate_1h_mm_h;
+    s_ring.crc = rain_rate_crc();
+    portEXIT_CRITICAL(&s_lock);
+}
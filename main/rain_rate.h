@@ -0,0 +1,78 @@
+/*
+ * Rain Rate
+ * Rain intensity (mm/h) from a sliding window of bucket-tip timestamps kept in
+ * RTC memory: instantaneous, 10-minute and 1-hour rates
+ */
+
+#ifndef RAIN_RATE_H
+#define RAIN_RATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tips kept in the ring (2 bytes each). 128 tips cover a full hour up to ~46 mm/h at
+ * 0.36 mm/tip; above that the 1-hour rate is extrapolated from the span the ring covers. */
+#ifndef RAIN_RATE_RING_LEN
+#define RAIN_RATE_RING_LEN 128
+#endif
+
+/* No tip for this long: instantaneous rate drops to zero */
+#ifndef RAIN_RATE_DRY_TIMEOUT_S
+#define RAIN_RATE_DRY_TIMEOUT_S 1800
+#endif
+
+/* A rate is reported again when it moves by this much (mm/h) ... */
+#ifndef RAIN_RATE_REPORT_MIN_DELTA
+#define RAIN_RATE_REPORT_MIN_DELTA 0.5f
+#endif
+
+/* ... and by this fraction of the last reported value, or changes intensity class */
+#ifndef RAIN_RATE_REPORT_REL_DELTA
+#define RAIN_RATE_REPORT_REL_DELTA 0.2f
+#endif
+
+typedef struct {
+    float instant_mm_h;     /*!< From the interval between the latest tips, decaying while dry */
+    float rate_10min_mm_h;  /*!< Rain in the last 10 minutes, per hour */
+    float rate_1h_mm_h;     /*!< Rain in the last hour */
+} rain_rate_t;
+
+/**
+ * @brief Restore the tip ring from RTC memory (dropped if invalid)
+ * @param mm_per_tip Rain per bucket tip
+ */
+void rain_rate_init(float mm_per_tip);
+
+/**
+ * @brief Record bucket tips
+ * @param tips    Tips at this instant (PCNT collects may deliver several)
+ * @param tick_ms FreeRTOS tick of the tip in ms (as captured by the ISR)
+ */
+void rain_rate_record(uint32_t tips, uint32_t tick_ms);
+
+/**
+ * @brief Current rates and whether they changed enough to be reported
+ *
+ * A report is due when any rate changes intensity class (none, light, moderate,
+ * heavy, violent) or moves by both RAIN_RATE_REPORT_MIN_DELTA and
+ * RAIN_RATE_REPORT_REL_DELTA against the last committed values.
+ *
+ * @param out Current rates
+ * @return true if a report is due
+ */
+bool rain_rate_poll(rain_rate_t *out);
+
+/**
+ * @brief Remember rates as reported (after the attributes were set)
+ */
+void rain_rate_commit(const rain_rate_t *rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAIN_RATE_H */
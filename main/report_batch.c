@@ -0,0 +1,108 @@
+/*
+ * Report Batch
+ *
+ * Design:
+ * - Readers stage values instead of taking the Zigbee lock per attribute; between two
+ *   separate set calls the stack can run its reporting check and send a frame for the
+ *   first attribute alone
+ * - Apply sorts by endpoint/cluster and writes everything in one Zigbee task pass, so the
+ *   reporting engine finds all of a cluster's changes due together and builds one
+ *   Report Attributes frame per cluster (one radio TX instead of one per attribute)
+ * - Values are written without the report flag: when a frame goes on air is still
+ *   decided by the configured reporting (or an explicit report by the caller)
+ * - Explicit esp_zb_zcl_report_attr_cmd_req() is not used here: it carries one
+ *   attribute per request, i.e. one frame per attribute
+ */
+
+#include "report_batch.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include <string.h>
+
+static const char *TAG = "REPORT_BATCH";
+
+static bool report_batch_before(const report_batch_entry_t *a, const report_batch_entry_t *b)
+{
+    if (a->endpoint != b->endpoint) {
+        return a->endpoint < b->endpoint;
+    }
+    return a->cluster_id < b->cluster_id;
+}
+
+void report_batch_reset(report_batch_t *batch)
+{
+    batch->count = 0;
+}
+
+esp_err_t report_batch_add(report_batch_t *batch, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                           const void *value, size_t len)
+{
+    ESP_RETURN_ON_FALSE(batch && value, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(len <= REPORT_BATCH_VALUE_MAX, ESP_ERR_INVALID_SIZE, TAG,
+                        "EP%u 0x%04x/0x%04x: value too large (%u bytes)", endpoint, cluster_id, attr_id, (unsigned)len);
+
+    report_batch_entry_t *entry = NULL;
+    for (size_t i = 0; i < batch->count; i++) {
+        report_batch_entry_t *e = &batch->entries[i];
+        if (e->endpoint == endpoint && e->cluster_id == cluster_id && e->attr_id == attr_id) {
+            entry = e;
+            break;
+        }
+    }
+    if (entry == NULL) {
+        ESP_RETURN_ON_FALSE(batch->count < REPORT_BATCH_MAX_ENTRIES, ESP_ERR_NO_MEM, TAG,
+                            "batch full, EP%u 0x%04x/0x%04x dropped", endpoint, cluster_id, attr_id);
+        entry = &batch->entries[batch->count++];
+        entry->endpoint = endpoint;
+        entry->cluster_id = cluster_id;
+        entry->attr_id = attr_id;
+    }
+    entry->len = (uint8_t)len;
+    memcpy(entry->value, value, len);
+    return ESP_OK;
+}
+
+esp_err_t report_batch_apply(report_batch_t *batch, size_t *clusters)
+{
+    ESP_RETURN_ON_FALSE(batch, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (clusters) {
+        *clusters = 0;
+    }
+    if (batch->count == 0) {
+        return ESP_OK;
+    }
+
+    /* Insertion sort (stable, a handful of entries): each cluster becomes one contiguous run */
+    for (size_t i = 1; i < batch->count; i++) {
+        report_batch_entry_t tmp = batch->entries[i];
+        size_t j = i;
+        while (j > 0 && report_batch_before(&tmp, &batch->entries[j - 1])) {
+            batch->entries[j] = batch->entries[j - 1];
+            j--;
+        }
+        batch->entries[j] = tmp;
+    }
+
+    esp_err_t result = ESP_OK;
+    size_t groups = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        report_batch_entry_t *e = &batch->entries[i];
+        if (i == 0 || report_batch_before(&batch->entries[i - 1], e)) {
+            groups++;
+        }
+        esp_err_t ret = esp_zb_zcl_set_attribute_val(e->endpoint, e->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                     e->attr_id, e->value, false);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "❌ EP%u 0x%04x/0x%04x rejected: 0x%x", e->endpoint, e->cluster_id, e->attr_id, ret);
+            result = ESP_FAIL;
+        }
+    }
+
+    ESP_LOGI(TAG, "📦 %u attribute(s) committed in %u cluster group(s)", (unsigned)batch->count, (unsigned)groups);
+    if (clusters) {
+        *clusters = groups;
+    }
+    report_batch_reset(batch);
+    return result;
+}
@@ -0,0 +1,73 @@
+/*
+ * Report Batch
+ * Collects the attribute changes of one wake cycle and writes them to the Zigbee
+ * stack together, so the reporting engine packs each cluster into one frame
+ */
+
+#ifndef REPORT_BATCH_H
+#define REPORT_BATCH_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Attributes staged per cycle */
+#ifndef REPORT_BATCH_MAX_ENTRIES
+#define REPORT_BATCH_MAX_ENTRIES 16
+#endif
+
+/* Largest attribute value (bytes, a ZCL string including its length prefix) */
+#ifndef REPORT_BATCH_VALUE_MAX
+#define REPORT_BATCH_VALUE_MAX 52
+#endif
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t len;
+    uint8_t value[REPORT_BATCH_VALUE_MAX];
+} report_batch_entry_t;
+
+/**
+ * @brief Attribute changes of one cycle, owned by the caller (no internal locking)
+ */
+typedef struct {
+    size_t count;
+    report_batch_entry_t entries[REPORT_BATCH_MAX_ENTRIES];
+} report_batch_t;
+
+/**
+ * @brief Drop every staged attribute
+ */
+void report_batch_reset(report_batch_t *batch);
+
+/**
+ * @brief Stage a server attribute value (copied); a second value for the same attribute replaces the first
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the value is too large, ESP_ERR_NO_MEM if the batch is full
+ */
+esp_err_t report_batch_add(report_batch_t *batch, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                           const void *value, size_t len);
+
+/**
+ * @brief Write every staged attribute, grouped by endpoint and cluster (Zigbee task context or lock held)
+ *
+ * The stack's reporting engine only runs once the Zigbee task gets control back, so it
+ * sees all changed attributes of a cluster at once and sends them as one Report
+ * Attributes frame with several records. The batch is empty afterwards, also on failure.
+ *
+ * @param batch    Staged attributes
+ * @param clusters Optional: number of endpoint/cluster groups written
+ * @return ESP_OK, ESP_FAIL if an attribute was rejected
+ */
+esp_err_t report_batch_apply(report_batch_t *batch, size_t *clusters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORT_BATCH_H */
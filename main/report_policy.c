@@ -0,0 +1,188 @@
+/*
+ * Report Policy
+ *
+ * Design:
+ * - Const default table; the active table starts as a copy and Zigbee overrides are
+ *   persisted as one blob of every parameter (blob size doubles as format check)
+ * - The engine gates the attribute write itself: a value that is not approved never
+ *   reaches the attribute table, so no reporting configuration (coordinator's or lost
+ *   after a reboot) can put it on air
+ * - Deadband against the last reported value; a change against the previous direction
+ *   also has to clear the hysteresis, so noise around a level does not flap
+ * - Minimum interval holds back changes, the maximum interval sends a heartbeat even
+ *   without change; state lives in RAM (kept in light sleep, a reboot reports afresh)
+ * - Overrides are validated as a whole (min <= max interval, deadband >= hysteresis) and
+ *   reach the active table only once NVS has them, so RAM and flash never disagree
+ * - One spinlock guards the active table and the state: set/reset run in the Zigbee
+ *   task, check in the sensor task
+ */
+
+#include "report_policy.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "REPORT_POLICY";
+static const char *NVS_NAMESPACE = "report_pol";
+static const char *NVS_KEY = "params";
+
+static const report_policy_t s_defaults[REPORT_POLICY_COUNT] = {
+    /*                                                 deadband  hyst  min s  max s */
+    [REPORT_POLICY_TEMPERATURE]       = { "temperature",       { 10,    5,    60,  3600 } },
+    [REPORT_POLICY_HUMIDITY]          = { "humidity",          { 100,   50,   60,  3600 } },
+    [REPORT_POLICY_PRESSURE]          = { "pressure",          { 2,     1,    60,  3600 } },
+    [REPORT_POLICY_BATTERY_VOLTAGE]   = { "battery_voltage",   { 1,     1,  3600, 43200 } },
+    [REPORT_POLICY_BATTERY_PERCENT]   = { "battery_percent",   { 2,     2,  3600, 43200 } },
+    [REPORT_POLICY_PROBE_TEMPERATURE] = { "probe_temperature", { 10,    5,    60,  3600 } },
+};
+
+typedef struct {
+    bool valid;
+    int8_t direction;                   // Sign of the last reported change
+    int32_t value;                      // Last reported value
+    uint32_t time_s;                    // When it was reported
+} report_policy_state_t;
+
+static report_policy_t s_active[REPORT_POLICY_COUNT];
+static report_policy_state_t s_state[REPORT_POLICY_COUNT][REPORT_POLICY_CHANNELS];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool report_policy_valid(const uint16_t *p)
+{
+    return p[REPORT_POLICY_DEADBAND] >= p[REPORT_POLICY_HYSTERESIS] &&
+           (p[REPORT_POLICY_MAX_INTERVAL] == 0 || p[REPORT_POLICY_MIN_INTERVAL] <= p[REPORT_POLICY_MAX_INTERVAL]);
+}
+
+esp_err_t report_policy_init(void)
+{
+    memcpy(s_active, s_defaults, sizeof(s_active));
+    report_policy_reset();
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return ESP_OK;      // No overrides yet
+    }
+    uint16_t stored[REPORT_POLICY_COUNT][REPORT_POLICY_PARAM_COUNT];
+    size_t size = sizeof(stored);
+    esp_err_t ret = nvs_get_blob(nvs_handle, NVS_KEY, stored, &size);
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK || size != sizeof(stored)) {
+        if (ret == ESP_OK || ret == ESP_ERR_NVS_INVALID_LENGTH) {
+            ESP_LOGW(TAG, "Stored overrides have another layout - using defaults");
+        }
+        return ESP_OK;
+    }
+    for (int id = 0; id < REPORT_POLICY_COUNT; id++) {
+        if (!report_policy_valid(stored[id])) {
+            ESP_LOGW(TAG, "Stored %s override is inconsistent - using defaults", s_defaults[id].name);
+            continue;
+        }
+        memcpy(s_active[id].param, stored[id], sizeof(stored[id]));
+    }
+    ESP_LOGI(TAG, "📂 Report policy overrides loaded from NVS");
+    return ESP_OK;
+}
+
+const report_policy_t *report_policy_get(report_policy_id_t id)
+{
+    if ((unsigned)id >= REPORT_POLICY_COUNT) return NULL;
+    return &s_active[id];
+}
+
+esp_err_t report_policy_set(report_policy_id_t id, report_policy_param_t param, uint16_t value)
+{
+    if ((unsigned)id >= REPORT_POLICY_COUNT || (unsigned)param >= REPORT_POLICY_PARAM_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_active[id].param[param] == value) {
+        return ESP_OK;
+    }
+
+    /* Candidate table: validated and stored before it becomes active */
+    uint16_t stored[REPORT_POLICY_COUNT][REPORT_POLICY_PARAM_COUNT];
+    for (int i = 0; i < REPORT_POLICY_COUNT; i++) {
+        memcpy(stored[i], s_active[i].param, sizeof(stored[i]));
+    }
+    stored[id][param] = value;
+    if (!report_policy_valid(stored[id])) {
+        ESP_LOGW(TAG, "%s parameter %d = %u rejected (needs min <= max interval, deadband >= hysteresis)",
+                 s_active[id].name, param, value);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = nvs_set_blob(nvs_handle, NVS_KEY, stored, sizeof(stored));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store report policy: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_active[id].param[param] = value;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "💾 %s parameter %d set to %u", s_active[id].name, param, value);
+    return ESP_OK;
+}
+
+bool report_policy_check(report_policy_id_t id, uint8_t channel, int32_t value, uint32_t now_s)
+{
+    if ((unsigned)id >= REPORT_POLICY_COUNT || channel >= REPORT_POLICY_CHANNELS) {
+        return true;        // Not governed: let it through
+    }
+    portENTER_CRITICAL(&s_lock);
+    const uint16_t *p = s_active[id].param;
+    report_policy_state_t *st = &s_state[id][channel];
+
+    int32_t delta = value - st->value;
+    int8_t direction = delta > 0 ? 1 : delta < 0 ? -1 : 0;
+    uint32_t elapsed = now_s - st->time_s;
+    bool send;
+    if (!st->valid) {
+        send = true;
+    } else if (p[REPORT_POLICY_MAX_INTERVAL] && elapsed >= p[REPORT_POLICY_MAX_INTERVAL]) {
+        send = true;        // Heartbeat
+    } else if (direction == 0 || elapsed < p[REPORT_POLICY_MIN_INTERVAL]) {
+        send = false;
+    } else {
+        uint32_t threshold = p[REPORT_POLICY_DEADBAND];
+        if (st->direction != 0 && direction != st->direction) {
+            threshold += p[REPORT_POLICY_HYSTERESIS];
+        }
+        send = (uint32_t)abs(delta) >= threshold;
+    }
+    int32_t reported = st->value;
+    if (send) {
+        if (direction != 0) {
+            st->direction = direction;
+        }
+        st->valid = true;
+        st->value = value;
+        st->time_s = now_s;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!send) {
+        ESP_LOGD(TAG, "%s[%u]: %ld held back (reported %ld, %lu s ago)", s_defaults[id].name, channel, (long)value,
+                 (long)reported, (unsigned long)elapsed);
+    }
+    return send;
+}
+
+void report_policy_reset(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(s_state, 0, sizeof(s_state));
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,82 @@
+/*
+ * Report Policy
+ * On-device decision of when a measured value goes on air: deadband, hysteresis,
+ * minimum interval and heartbeat per value, from a const default table with
+ * overrides written over Zigbee and persisted in NVS
+ */
+
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Values are part of the Zigbee attribute ids and of the NVS blob - do not renumber */
+typedef enum {
+    REPORT_POLICY_TEMPERATURE = 0,      // EP1 temperature, 0.01 °C
+    REPORT_POLICY_HUMIDITY = 1,         // EP1 relative humidity, 0.01 %
+    REPORT_POLICY_PRESSURE = 2,         // EP1 pressure, raw attribute units
+    REPORT_POLICY_BATTERY_VOLTAGE = 3,  // Battery voltage, 0.1 V
+    REPORT_POLICY_BATTERY_PERCENT = 4,  // Battery remaining, 0.5 %
+    REPORT_POLICY_PROBE_TEMPERATURE = 5,// DS18B20 probes (one channel per probe), 0.01 °C
+    REPORT_POLICY_COUNT,
+} report_policy_id_t;
+
+typedef enum {
+    REPORT_POLICY_DEADBAND = 0,         // Smallest change that is reported (attribute units)
+    REPORT_POLICY_HYSTERESIS = 1,       // Extra change needed when the direction reverses
+    REPORT_POLICY_MIN_INTERVAL = 2,     // Seconds between two reports of a changed value
+    REPORT_POLICY_MAX_INTERVAL = 3,     // Heartbeat: seconds after which the value is sent anyway (0 = never)
+    REPORT_POLICY_PARAM_COUNT,
+} report_policy_param_t;
+
+/* Independent instances of one value (DS18B20 probes share a policy, not a state) */
+#define REPORT_POLICY_CHANNELS 4
+
+typedef struct {
+    const char *name;
+    uint16_t param[REPORT_POLICY_PARAM_COUNT];
+} report_policy_t;
+
+/**
+ * @brief Load the defaults and apply the overrides stored in NVS
+ */
+esp_err_t report_policy_init(void);
+
+/**
+ * @brief Active policy of a value, NULL if id is out of range (Zigbee task: the only writer)
+ */
+const report_policy_t *report_policy_get(report_policy_id_t id);
+
+/**
+ * @brief Override one parameter and persist the active table (no flash write if unchanged)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if the result would have min > max interval (max != 0)
+ *         or deadband < hysteresis, or the NVS error (the active table is left unchanged)
+ */
+esp_err_t report_policy_set(report_policy_id_t id, report_policy_param_t param, uint16_t value);
+
+/**
+ * @brief Decide whether a new value goes on air; if so it becomes the reference value
+ * @param id      Value
+ * @param channel Instance (probe index), 0 for single values
+ * @param value   New value in attribute units
+ * @param now_s   Monotonic time in seconds
+ * @return true if the value should be written to the attribute and reported
+ */
+bool report_policy_check(report_policy_id_t id, uint8_t channel, int32_t value, uint32_t now_s);
+
+/**
+ * @brief Forget the reported values, so the next sample of every value is sent (network rejoin)
+ */
+void report_policy_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPORT_POLICY_H
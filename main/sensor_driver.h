@@ -0,0 +1,43 @@
+#pragma once
+
+#include "i2c_bus.h"
+#include "esp_err.h"
+#include "sensor_if.h"
+#include "sensor_profile.h"
+#include "sensor_topology.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Descriptor of one environmental sensor driver. sensor_if.c only talks to drivers
+// through these hooks, so a new chip is one more entry in sensor_drivers[].
+typedef struct {
+    const char *name;
+    sensor_source_t source;                 // Tag of values coming from this driver
+    uint8_t quality[SENSOR_CH_COUNT];       // Per-channel preference, 0 = channel not provided
+
+    // Full probe on the bus; ESP_OK if the chip was found and initialized
+    esp_err_t (*probe)(i2c_bus_handle_t i2c_bus);
+    // Re-attach from a cached record (one presence check, no probing)
+    esp_err_t (*attach)(i2c_bus_handle_t i2c_bus, const sensor_topology_dev_t *dev);
+    // Fill the cache record of the attached chip
+    esp_err_t (*describe)(sensor_topology_dev_t *dev);
+    // Drop the device handle (bus recovery deletes and recreates the bus)
+    void (*release)(void);
+    // Apply a measurement profile (optional)
+    esp_err_t (*configure)(const sensor_profile_t *profile);
+
+    // Split-phase measurement
+    esp_err_t (*start)(uint32_t *out_min_us, uint32_t *out_max_us);
+    bool (*ready)(void);
+    esp_err_t (*collect)(void);
+    // Return the chip to its lowest-power state after collect (optional)
+    esp_err_t (*sleep)(void);
+
+    // Last collected value per channel, NULL where quality is 0
+    esp_err_t (*read[SENSOR_CH_COUNT])(float *out);
+} sensor_driver_t;
+
+// Flash-resident driver registry (sensor_registry.c)
+extern const sensor_driver_t sensor_drivers[];
+extern const size_t sensor_driver_count;
@@ -1,179 +1,649 @@
 #include "sensor_if.h"
-#include "bme280_app.h" // existing BME280 app API
-#include "aht20.h"
-#include "bmp280.h"
-#include "sht41.h"
+#include "sensor_driver.h"
+#include "sensor_topology.h"
+#include "bmx280_comp.h"
 #include "esp_log.h"
+#include "esp_check.h"
 #include "i2c_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "driver/gpio.h"
 #include <stdio.h>
+#include <string.h>
 
 static const char *TAG = "SENSOR_IF";
-static sensor_type_t detected = SENSOR_TYPE_NONE;
 
-// Default pressure value when no pressure sensor is available (SHT41 case)
+// Registry indices are used as bit positions below
+#define SENSOR_MAX_DRIVERS SENSOR_TOPOLOGY_MAX_DEVICES
+
+// Drivers attached at init (bit i = sensor_drivers[i])
+static uint32_t s_present = 0;
+
+// Drivers with a conversion in flight (set by sensor_start_measurement)
+static uint32_t s_pending = 0;
+
+// Per-channel source order: present drivers providing the channel, best quality first
+static uint8_t s_route[SENSOR_CH_COUNT][SENSOR_MAX_DRIVERS];
+static uint8_t s_route_len[SENSOR_CH_COUNT];
+
+// Summary for logging, e.g. "SHT41 + BMP280"
+static char s_description[48] = "none";
+
+// Result of the last sensor_collect()
+static sensor_sample_t s_last_sample = { 0 };
+
+// Conversion timing of the current / last cycle
+static sensor_timing_t s_timing = { 0 };
+
+// Requested measurement profile and the one the drivers are programmed with
+static volatile sensor_profile_id_t s_profile_req = SENSOR_PROFILE_DEFAULT;
+static sensor_profile_id_t s_profile_applied = SENSOR_PROFILE_COUNT;
+
+// Subsample mode requested / programmed: BMx280 at X1 with the IIR filter off
+static bool s_subsample_req = false;
+static bool s_subsample_applied = false;
+
+// Retry policy: a failed driver is restarted only while its worst-case conversion
+// still ends before the cycle deadline (conversion budget + this margin), so a flaky
+// chip costs at most this much extra awake time per cycle
+#define SENSOR_RETRY_BUDGET_US      25000
+#define SENSOR_MAX_RETRIES          2
+
+// Bus recovery after this many failed cycles in a row of one driver, at most once per interval
+#define SENSOR_RECOVERY_THRESHOLD   3
+#define SENSOR_RECOVERY_MIN_INTERVAL_US (15LL * 60 * 1000 * 1000)
+
+// Bus the drivers are attached to and how to recreate it
+static i2c_bus_handle_t s_bus = NULL;
+static i2c_port_t s_bus_port;
+static i2c_config_t s_bus_conf;
+static bool s_bus_conf_valid = false;
+static int64_t s_last_recovery_us = 0;
+
+// Error accounting
+static sensor_driver_stats_t s_drv_stats[SENSOR_MAX_DRIVERS];
+static sensor_stats_t s_stats = { 0 };
+
+// Worst-case conversion time of each driver's last successful start (retry admission)
+static uint32_t s_drv_max_us[SENSOR_MAX_DRIVERS];
+
+// Default pressure value when no present driver measures pressure (e.g. SHT41 alone)
 #define DEFAULT_PRESSURE_HPA 1000.0f
 
+#define SENSOR_BIT(i) (1UL << (i))
+
+static const char *s_channel_names[SENSOR_CH_COUNT] = { "temperature", "humidity", "pressure" };
+
+// Full discovery: bus scan followed by a probe of every registered driver
+static esp_err_t sensor_probe_all(i2c_bus_handle_t i2c_bus)
+{
+    // Diagnostic scan: list all devices on the bus to help debug NACKs
+    uint8_t found[32];
+    int n = i2c_bus_scan(i2c_bus, found, sizeof(found));
+    if (n == 0) {
+        ESP_LOGW(TAG, "I2C scan: no devices found on bus");
+    } else {
+        char buf[128];
+        int off = 0;
+        off += snprintf(buf + off, sizeof(buf) - off, "I2C scan: %d device(s):", n);
+        for (int i = 0; i < n; ++i) off += snprintf(buf + off, sizeof(buf) - off, " 0x%02x", found[i]);
+        ESP_LOGI(TAG, "%s", buf);
+    }
+
+    s_present = 0;
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        const sensor_driver_t *drv = &sensor_drivers[i];
+        ESP_LOGI(TAG, "Probing for %s...", drv->name);
+        if (drv->probe(i2c_bus) == ESP_OK) {
+            s_present |= SENSOR_BIT(i);
+            ESP_LOGI(TAG, "Detected sensor: %s", drv->name);
+        }
+    }
+    return s_present ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+static int sensor_find_driver(uint8_t source)
+{
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (sensor_drivers[i].source == source) return (int)i;
+    }
+    return -1;
+}
+
+// Re-attach the devices of a cached topology with one presence check per device
+static esp_err_t sensor_attach_cached(i2c_bus_handle_t i2c_bus, const sensor_topology_t *topo)
+{
+    if (topo->count == 0) return ESP_ERR_NOT_FOUND;
+
+    s_present = 0;
+    for (uint8_t d = 0; d < topo->count; d++) {
+        int i = sensor_find_driver(topo->dev[d].source);
+        if (i < 0) return ESP_ERR_NOT_SUPPORTED;    // cached by a firmware with other drivers
+        ESP_RETURN_ON_ERROR(sensor_drivers[i].attach(i2c_bus, &topo->dev[d]), TAG, "%s missing",
+                            sensor_drivers[i].name);
+        s_present |= SENSOR_BIT(i);
+    }
+    return ESP_OK;
+}
+
+// Snapshot what the full probe found so the next boot can skip it
+static void sensor_cache_topology(void)
+{
+    sensor_topology_t topo;
+    memset(&topo, 0, sizeof(topo));     // padding is covered by the CRC
+
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (!(s_present & SENSOR_BIT(i))) continue;
+        sensor_topology_dev_t *dev = &topo.dev[topo.count];
+        dev->source = (uint8_t)sensor_drivers[i].source;
+        if (sensor_drivers[i].describe(dev) != ESP_OK) {
+            return;
+        }
+        topo.count++;
+    }
+
+    sensor_topology_save(&topo);
+}
+
+// Order the present drivers per channel by quality and build the log summary
+static void sensor_build_routes(void)
+{
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        uint8_t len = 0;
+        for (size_t i = 0; i < sensor_driver_count; i++) {
+            if (!(s_present & SENSOR_BIT(i)) || sensor_drivers[i].quality[ch] == 0) continue;
+            // Insertion sort, the lists hold a handful of entries at most
+            uint8_t pos = len++;
+            while (pos > 0 && sensor_drivers[s_route[ch][pos - 1]].quality[ch] < sensor_drivers[i].quality[ch]) {
+                s_route[ch][pos] = s_route[ch][pos - 1];
+                pos--;
+            }
+            s_route[ch][pos] = (uint8_t)i;
+        }
+        s_route_len[ch] = len;
+        if (len > 0) {
+            ESP_LOGI(TAG, "  %s <- %s%s", s_channel_names[ch], sensor_drivers[s_route[ch][0]].name,
+                     len > 1 ? " (with fallback)" : "");
+        } else if (ch == SENSOR_CH_IDX_PRESSURE && s_present) {
+            ESP_LOGI(TAG, "  %s <- default %.1f hPa", s_channel_names[ch], DEFAULT_PRESSURE_HPA);
+        }
+    }
+
+    int off = 0;
+    s_description[0] = '\0';
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (!(s_present & SENSOR_BIT(i))) continue;
+        off += snprintf(s_description + off, sizeof(s_description) - off, "%s%s", off ? " + " : "",
+                        sensor_drivers[i].name);
+        if (off >= (int)sizeof(s_description)) break;
+    }
+    if (!s_present) snprintf(s_description, sizeof(s_description), "none");
+}
+
+esp_err_t sensor_set_profile(sensor_profile_id_t id)
+{
+    if (sensor_profile_get(id) == NULL) return ESP_ERR_INVALID_ARG;
+    s_profile_req = id;
+    return ESP_OK;
+}
+
+sensor_profile_id_t sensor_get_profile(void)
+{
+    return s_profile_req;
+}
+
+void sensor_set_subsample(bool enable)
+{
+    s_subsample_req = enable;
+}
+
+// Push the requested profile into the drivers. Before attach this only sets their
+// defaults; afterwards it rewrites the chip config. Retried next cycle on failure.
+static void sensor_apply_profile(void)
+{
+    sensor_profile_id_t id = s_profile_req;
+    bool subsample = s_subsample_req;
+    if (id == s_profile_applied && subsample == s_subsample_applied) return;
+
+    // Subsamples are averaged in software: an IIR filter would smear samples minutes
+    // apart and hardware oversampling would pay twice for the same noise reduction
+    sensor_profile_t p = *sensor_profile_get(id);
+    if (subsample) {
+        p.osrs_t = BMX280_OSRS_X1;
+        p.osrs_p = BMX280_OSRS_X1;
+        p.osrs_h = BMX280_OSRS_X1;
+        p.filter = BMX280_FILTER_OFF;
+    }
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        const sensor_driver_t *drv = &sensor_drivers[i];
+        esp_err_t ret = drv->configure ? drv->configure(&p) : ESP_OK;
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Measurement profile '%s' not applied to %s (%s)", p.name, drv->name,
+                     esp_err_to_name(ret));
+            return;
+        }
+    }
+
+    if (id != s_profile_applied) {
+        ESP_LOGI(TAG, "📐 Measurement profile '%s' active (~%u uJ/sample)", p.name, p.energy_uj);
+    }
+    ESP_LOGD(TAG, "Subsample mode %s", subsample ? "on" : "off");
+    s_profile_applied = id;
+    s_subsample_applied = subsample;
+}
+
 esp_err_t sensor_init(i2c_bus_handle_t i2c_bus)
 {
+    // Program driver defaults before attach/probe writes the chip config
+    sensor_apply_profile();
+
+    if (i2c_bus == NULL) {
+        ESP_LOGW(TAG, "sensor_init: i2c_bus handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_bus = i2c_bus;
+
+    // Fast path: validate the cached topology instead of scanning and probing
     esp_err_t ret = ESP_ERR_NOT_FOUND;
+    sensor_topology_t topo;
+    if (sensor_topology_load(&topo) == ESP_OK) {
+        int64_t t0 = esp_timer_get_time();
+        ret = sensor_attach_cached(i2c_bus, &topo);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "⚡ Cached sensor topology validated in %lld us - probe skipped",
+                     (long long)(esp_timer_get_time() - t0));
+        } else {
+            ESP_LOGW(TAG, "Cached sensor topology no longer matches the bus - running full probe");
+        }
+    }
 
-    if (i2c_bus != NULL) {
-        // Diagnostic scan: list all devices on the bus to help debug NACKs
-        uint8_t found[32];
-        int n = i2c_bus_scan(i2c_bus, found, sizeof(found));
-        if (n == 0) {
-            ESP_LOGW(TAG, "I2C scan: no devices found on bus");
+    if (ret != ESP_OK) {
+        ret = sensor_probe_all(i2c_bus);
+        if (ret == ESP_OK) {
+            sensor_cache_topology();
         } else {
-            char buf[128];
-            int off = 0;
-            off += snprintf(buf + off, sizeof(buf) - off, "I2C scan: %d device(s):", n);
-            for (int i = 0; i < n; ++i) off += snprintf(buf + off, sizeof(buf) - off, " 0x%02x", found[i]);
-            ESP_LOGI(TAG, "%s", buf);
+            sensor_topology_erase();
         }
-    } else {
-        ESP_LOGW(TAG, "sensor_init: i2c_bus handle is NULL");
     }
 
-    // Try BME280 first (existing single-chip sensor)
-    ESP_LOGI(TAG, "Probing for BME280...");
-    ret = bme280_app_init(i2c_bus);
+    sensor_build_routes();
     if (ret == ESP_OK) {
-        // Check if it's actually a BMP280 (no humidity) - if so, look for humidity sensor combo
-        if (bme280_app_is_bmp280()) {
-            ESP_LOGI(TAG, "BMP280 detected (no humidity), searching for separate humidity sensor...");
-            
-            // Initialize standalone BMP280 module for combo sensor support
-            esp_err_t bmp_ret = bmp280_init(i2c_bus);
-            if (bmp_ret != ESP_OK) {
-                ESP_LOGW(TAG, "Failed to initialize standalone BMP280 module: %s", esp_err_to_name(bmp_ret));
-            }
-            
-            // Try to find SHT41 for humidity
-            esp_err_t sht_ret = sht41_init(i2c_bus);
-            if (sht_ret == ESP_OK) {
-                detected = SENSOR_TYPE_SHT41_BMP280;
-                ESP_LOGI(TAG, "Detected sensor combo: SHT41 + BMP280 (temp/RH from SHT41, pressure from BMP280)");
-                return ESP_OK;
-            }
-            ESP_LOGW(TAG, "No humidity sensor found, using BMP280 alone (humidity unavailable)");
+        ESP_LOGI(TAG, "Sensor layer ready: %s", s_description);
+    }
+    return ret;
+}
+
+uint32_t sensor_get_present(void)
+{
+    return s_present;
+}
+
+const char *sensor_get_description(void)
+{
+    return s_description;
+}
+
+// Classify a driver error into its counter
+static void sensor_count_error(size_t i, esp_err_t err)
+{
+    sensor_driver_stats_t *st = &s_drv_stats[i];
+    switch (err) {
+    case ESP_ERR_INVALID_CRC:
+        st->crc_errors++;
+        break;
+    case ESP_ERR_TIMEOUT:
+        st->timeouts++;
+        break;
+    default:
+        st->bus_errors++;
+        break;
+    }
+    s_stats.errors++;
+}
+
+// Trigger one driver and fold its datasheet window into *timing
+static esp_err_t sensor_start_driver(size_t i, sensor_timing_t *timing)
+{
+    const sensor_driver_t *drv = &sensor_drivers[i];
+    uint32_t min_us = 0, max_us = 0;
+    esp_err_t r = drv->start(&min_us, &max_us);
+    if (r != ESP_OK) {
+        sensor_count_error(i, r);
+        ESP_LOGW(TAG, "%s trigger failed (%s)", drv->name, esp_err_to_name(r));
+        return r;
+    }
+    s_pending |= SENSOR_BIT(i);
+    s_drv_max_us[i] = max_us;
+    if (min_us > timing->first_poll_us) timing->first_poll_us = min_us;
+    if (max_us > timing->budget_us) timing->budget_us = max_us;
+    return ESP_OK;
+}
+
+esp_err_t sensor_start_measurement(sensor_timing_t *out_timing)
+{
+    sensor_timing_t timing = { .last_wait_us = s_timing.last_wait_us };
+    s_pending = 0;
+    if (s_present == 0) return ESP_ERR_NOT_FOUND;
+    sensor_apply_profile();
+
+    // Start every present driver; fold each datasheet window into the cycle timing
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (s_present & SENSOR_BIT(i)) sensor_start_driver(i, &timing);
+    }
+
+    s_timing = timing;
+    if (out_timing) *out_timing = timing;
+    // Return OK if at least one succeeds (allows partial functionality)
+    return s_pending ? ESP_OK : ESP_FAIL;
+}
+
+void sensor_get_timing(sensor_timing_t *out_timing)
+{
+    if (out_timing) *out_timing = s_timing;
+}
+
+bool sensor_measurement_ready(void)
+{
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if ((s_pending & SENSOR_BIT(i)) && !sensor_drivers[i].ready()) return false;
+    }
+    return true;
+}
+
+static void sensor_set_channel(sensor_sample_t *sample, int ch, float v, sensor_source_t src)
+{
+    switch (ch) {
+    case SENSOR_CH_IDX_TEMPERATURE:
+        sample->temperature_c = v;
+        sample->temperature_src = src;
+        break;
+    case SENSOR_CH_IDX_HUMIDITY:
+        sample->humidity_pct = v;
+        sample->humidity_src = src;
+        break;
+    case SENSOR_CH_IDX_PRESSURE:
+        sample->pressure_hpa = v;
+        sample->pressure_src = src;
+        break;
+    default:
+        return;
+    }
+    sample->valid |= (uint8_t)(1 << ch);
+}
+
+// Collect every pending driver once; returns the bits of the drivers that delivered data
+static uint32_t sensor_collect_drivers(void)
+{
+    uint32_t ok = 0;
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (!(s_pending & SENSOR_BIT(i))) continue;
+        const sensor_driver_t *drv = &sensor_drivers[i];
+        esp_err_t r = drv->collect();
+        if (r == ESP_OK) {
+            ok |= SENSOR_BIT(i);
+        } else {
+            sensor_count_error(i, r);
+            ESP_LOGW(TAG, "%s read failed (%s)", drv->name, esp_err_to_name(r));
         }
-        detected = SENSOR_TYPE_BME280;
-        ESP_LOGI(TAG, "Detected sensor: BME280");
-        return ESP_OK;
+        if (drv->sleep) drv->sleep();
     }
+    s_pending = 0;
+    return ok;
+}
 
-    // Try SHT41 + BMP280 combo (temp+humidity from SHT41, pressure from BMP280)
-    ESP_LOGI(TAG, "BME280 not found, probing for SHT41 + BMP280 combo...");
-    esp_err_t sht_ret = sht41_init(i2c_bus);
-    esp_err_t bmp_ret = bmp280_init(i2c_bus);
-    if (sht_ret == ESP_OK && bmp_ret == ESP_OK) {
-        detected = SENSOR_TYPE_SHT41_BMP280;
-        ESP_LOGI(TAG, "Detected sensor combo: SHT41 + BMP280 (temp/RH from SHT41, pressure from BMP280)");
-        return ESP_OK;
+// Rebuild the bus after a slave got stuck: release the drivers, clock SCL until
+// SDA is free, issue a STOP, recreate the bus and re-attach. Rate-limited because
+// a permanently broken chip would otherwise trigger it every cycle.
+static esp_err_t sensor_bus_recover(void)
+{
+    if (!s_bus_conf_valid) return ESP_ERR_NOT_SUPPORTED;
+    int64_t now = esp_timer_get_time();
+    if (s_stats.bus_recoveries > 0 && now - s_last_recovery_us < SENSOR_RECOVERY_MIN_INTERVAL_US) {
+        return ESP_ERR_INVALID_STATE;
     }
+    s_last_recovery_us = now;
+    s_stats.bus_recoveries++;
+    ESP_LOGW(TAG, "🔧 I2C bus recovery #%u", s_stats.bus_recoveries);
 
-    // Try SHT41 alone (temp + humidity only, no pressure)
-    if (sht_ret == ESP_OK) {
-        ESP_LOGI(TAG, "Detected sensor: SHT41 only (pressure will default to %.1f hPa)", DEFAULT_PRESSURE_HPA);
-        detected = SENSOR_TYPE_SHT41;
-        return ESP_OK;
+    // i2c_bus_delete() refuses while devices exist
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (s_present & SENSOR_BIT(i)) sensor_drivers[i].release();
     }
+    s_present = 0;
+    s_pending = 0;
+    if (s_bus) i2c_bus_delete(&s_bus);
 
-    // Try AHT20 + BMP280 combo
-    ESP_LOGI(TAG, "SHT41 not found, probing for AHT20 + BMP280 combo...");
-    ret = aht20_init(i2c_bus);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "AHT20 not present or init failed");
-        return ESP_ERR_NOT_FOUND;
+    // A slave interrupted mid-byte holds SDA low until it has clocked out its bits
+    gpio_num_t sda = (gpio_num_t)s_bus_conf.sda_io_num;
+    gpio_num_t scl = (gpio_num_t)s_bus_conf.scl_io_num;
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << sda) | (1ULL << scl),
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = s_bus_conf.sda_pullup_en,
+        .pull_down_en = 0,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+    gpio_set_level(sda, 1);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(5);
+    for (int n = 0; n < 9 && gpio_get_level(sda) == 0; n++) {
+        gpio_set_level(scl, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(5);
+    }
+    // STOP: SDA rises while SCL is high
+    gpio_set_level(scl, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(sda, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(5);
+    gpio_set_level(sda, 1);
+    esp_rom_delay_us(5);
+
+    s_bus = i2c_bus_create(s_bus_port, &s_bus_conf);
+    if (s_bus == NULL) {
+        ESP_LOGE(TAG, "I2C bus re-init failed - sensors offline");
+        sensor_build_routes();
+        return ESP_FAIL;
+    }
+
+    // Chips may have been power-cycled or reset: attach rewrites their config
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    sensor_topology_t topo;
+    if (sensor_topology_load(&topo) == ESP_OK) {
+        ret = sensor_attach_cached(s_bus, &topo);
     }
-    ret = bmp280_init(i2c_bus);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "BMP280 not present or init failed");
-        return ESP_ERR_NOT_FOUND;
+        ret = sensor_probe_all(s_bus);
+    }
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        s_drv_stats[i].consecutive = 0;
+    }
+    sensor_build_routes();
+    ESP_LOGI(TAG, "I2C bus recovered: %s", s_description);
+    return ret;
+}
+
+// Update the consecutive-failure counts of a finished cycle and recover the bus if needed
+static void sensor_account_cycle(uint32_t ok)
+{
+    bool stuck = false;
+    for (size_t i = 0; i < sensor_driver_count; i++) {
+        if (!(s_present & SENSOR_BIT(i))) continue;
+        sensor_driver_stats_t *st = &s_drv_stats[i];
+        if (ok & SENSOR_BIT(i)) {
+            st->cycles++;
+            st->consecutive = 0;
+        } else {
+            if (st->consecutive < UINT8_MAX) st->consecutive++;
+            if (st->consecutive >= SENSOR_RECOVERY_THRESHOLD) stuck = true;
+        }
+    }
+    if ((s_present & ~ok) != 0) s_stats.incomplete++;
+    if (stuck) sensor_bus_recover();
+}
+
+// Best collected source per channel; the next one in the route is the fallback
+static esp_err_t sensor_build_sample(uint32_t ok, sensor_sample_t *out_sample)
+{
+    sensor_sample_t sample = { .timestamp_us = esp_timer_get_time() };
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        for (uint8_t r = 0; r < s_route_len[ch]; r++) {
+            const sensor_driver_t *drv = &sensor_drivers[s_route[ch][r]];
+            float v = 0.0f;
+            if ((ok & SENSOR_BIT(s_route[ch][r])) && drv->read[ch](&v) == ESP_OK) {
+                sensor_set_channel(&sample, ch, v, drv->source);
+                break;
+            }
+        }
+    }
+    if (s_route_len[SENSOR_CH_IDX_PRESSURE] == 0 && ok) {
+        // No pressure sensor fitted - report default value
+        sensor_set_channel(&sample, SENSOR_CH_IDX_PRESSURE, DEFAULT_PRESSURE_HPA, SENSOR_SRC_DEFAULT);
+    }
+
+    s_last_sample = sample;
+    if (out_sample) *out_sample = sample;
+    return sample.valid ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t sensor_collect(sensor_sample_t *out_sample)
+{
+    if (s_pending == 0) return ESP_ERR_INVALID_STATE;
+
+    // One conversion per physical chip: collect each started driver exactly once
+    uint32_t ok = sensor_collect_drivers();
+    // Routes are built from the drivers present before a possible recovery
+    esp_err_t ret = sensor_build_sample(ok, out_sample);
+    sensor_account_cycle(ok);
+    return ret;
+}
+
+// Sleep through the typical conversion time, then poll the ready flags once per tick.
+// Every driver reports ready at its datasheet maximum; the deadline bounds the loop
+// even if one never does.
+static void sensor_wait_ready(uint32_t first_poll_us, int64_t deadline_us)
+{
+    vTaskDelay(pdMS_TO_TICKS((first_poll_us + 999) / 1000));
+    while (!sensor_measurement_ready() && esp_timer_get_time() < deadline_us) {
+        vTaskDelay(1);
+    }
+}
+
+esp_err_t sensor_wake_and_measure(sensor_sample_t *out_sample)
+{
+    sensor_timing_t timing;
+    esp_err_t ret = sensor_start_measurement(&timing);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        // Everything dropped out in an earlier recovery: try again once the interval allows
+        if (s_stats.bus_recoveries > 0) sensor_bus_recover();
+        return ret;
+    }
+    int64_t t0 = esp_timer_get_time();
+    // Drivers whose trigger failed have no window yet; assume the cycle's slowest
+    int64_t deadline = t0 + timing.budget_us + SENSOR_RETRY_BUDGET_US;
+
+    // All conversions run in parallel
+    uint32_t ok = 0;
+    if (s_pending) {
+        sensor_wait_ready(timing.first_poll_us, t0 + timing.budget_us);
+        s_timing.last_wait_us = (uint32_t)(esp_timer_get_time() - t0);
+        ok = sensor_collect_drivers();
+    }
+
+    // Retry failed drivers while their worst case still ends before the deadline
+    for (int attempt = 0; attempt < SENSOR_MAX_RETRIES && (s_present & ~ok); attempt++) {
+        sensor_timing_t rt = { 0 };
+        int64_t now = esp_timer_get_time();
+        for (size_t i = 0; i < sensor_driver_count; i++) {
+            if (!(s_present & ~ok & SENSOR_BIT(i))) continue;
+            uint32_t max_us = s_drv_max_us[i] ? s_drv_max_us[i] : timing.budget_us;
+            if (now + max_us > deadline) continue;
+            s_drv_stats[i].retries++;
+            s_stats.retries++;
+            sensor_start_driver(i, &rt);
+        }
+        if (!s_pending) break;
+        sensor_wait_ready(rt.first_poll_us, deadline);
+        ok |= sensor_collect_drivers();
     }
 
-    detected = SENSOR_TYPE_AHT20_BMP280;
-    ESP_LOGI(TAG, "Detected sensor combo: AHT20 + BMP280");
+    ESP_LOGD(TAG, "Conversion wait %lu us (typ %lu us, budget %lu us), cycle %lld us",
+             (unsigned long)s_timing.last_wait_us, (unsigned long)timing.first_poll_us,
+             (unsigned long)timing.budget_us, (long long)(esp_timer_get_time() - t0));
+
+    ret = sensor_build_sample(ok, out_sample);
+    sensor_account_cycle(ok);
+    return ret;
+}
+
+esp_err_t sensor_read_sample(sensor_sample_t *out_sample)
+{
+    if (!out_sample) return ESP_ERR_INVALID_ARG;
+    if (s_present == 0) return ESP_ERR_NOT_FOUND;
+    if (s_last_sample.valid == 0) return ESP_ERR_INVALID_STATE;
+    *out_sample = s_last_sample;
+    return ESP_OK;
+}
+
+void sensor_set_bus_config(i2c_port_t port, const i2c_config_t *conf)
+{
+    if (!conf) return;
+    s_bus_port = port;
+    s_bus_conf = *conf;
+    s_bus_conf_valid = true;
+}
+
+void sensor_get_stats(sensor_stats_t *out)
+{
+    if (out) *out = s_stats;
+}
+
+esp_err_t sensor_get_driver_stats(size_t idx, const char **out_name, sensor_driver_stats_t *out)
+{
+    if (idx >= sensor_driver_count || !out) return ESP_ERR_INVALID_ARG;
+    if (out_name) *out_name = sensor_drivers[idx].name;
+    *out = s_drv_stats[idx];
     return ESP_OK;
 }
 
-sensor_type_t sensor_get_type(void)
-{
-    return detected;
-}
-
-esp_err_t sensor_wake_and_measure(void)
-{
-    if (detected == SENSOR_TYPE_BME280) {
-        return bme280_app_wake_and_measure();
-    } else if (detected == SENSOR_TYPE_SHT41) {
-        return sht41_trigger_measurement();
-    } else if (detected == SENSOR_TYPE_SHT41_BMP280) {
-        esp_err_t r1 = sht41_trigger_measurement();
-        esp_err_t r2 = bmp280_trigger_measurement();
-        if (r2 != ESP_OK) ESP_LOGW(TAG, "BMP280 trigger failed (%s) - pressure will be stale", esp_err_to_name(r2));
-        // Return OK if at least one succeeds (allows partial functionality)
-        return (r1 == ESP_OK || r2 == ESP_OK) ? ESP_OK : ESP_FAIL;
-    } else if (detected == SENSOR_TYPE_AHT20_BMP280) {
-        esp_err_t r1 = aht20_trigger_measurement();
-        esp_err_t r2 = bmp280_trigger_measurement();
-        if (r2 != ESP_OK) ESP_LOGW(TAG, "BMP280 trigger failed (%s) - pressure will be stale", esp_err_to_name(r2));
-        // Return OK if at least one succeeds (allows partial functionality)
-        return (r1 == ESP_OK || r2 == ESP_OK) ? ESP_OK : ESP_FAIL;
-    }
-    return ESP_ERR_NOT_FOUND;
-}
-
-esp_err_t sensor_read_temperature(float *out_c)
-{
-    if (!out_c) return ESP_ERR_INVALID_ARG;
-    if (detected == SENSOR_TYPE_BME280) {
-        return bme280_app_read_temperature(out_c);
-    } else if (detected == SENSOR_TYPE_SHT41) {
-        return sht41_read_temperature(out_c);
-    } else if (detected == SENSOR_TYPE_SHT41_BMP280) {
-        // Read temperature from SHT41 (preferred for accuracy)
-        return sht41_read_temperature(out_c);
-    } else if (detected == SENSOR_TYPE_AHT20_BMP280) {
-        // Read temperature from AHT20 (preferred) or BMP280 as fallback
-        esp_err_t ret = aht20_read_temperature(out_c);
-        if (ret == ESP_OK) return ESP_OK;
-        return bmp280_read_temperature(out_c);
-    }
-    return ESP_ERR_NOT_FOUND;
-}
-
-esp_err_t sensor_read_humidity(float *out_percent)
-{
-    if (!out_percent) return ESP_ERR_INVALID_ARG;
-    if (detected == SENSOR_TYPE_BME280) {
-        if (bme280_app_is_bmp280()) return ESP_ERR_NOT_SUPPORTED;
-        return bme280_app_read_humidity(out_percent);
-    } else if (detected == SENSOR_TYPE_SHT41) {
-        return sht41_read_humidity(out_percent);
-    } else if (detected == SENSOR_TYPE_SHT41_BMP280) {
-        return sht41_read_humidity(out_percent);
-    } else if (detected == SENSOR_TYPE_AHT20_BMP280) {
-        return aht20_read_humidity(out_percent);
-    }
-    return ESP_ERR_NOT_FOUND;
-}
-
-esp_err_t sensor_read_pressure(float *out_hpa)
-{
-    if (!out_hpa) return ESP_ERR_INVALID_ARG;
-    if (detected == SENSOR_TYPE_BME280) {
-        return bme280_app_read_pressure(out_hpa);
-    } else if (detected == SENSOR_TYPE_SHT41) {
-        // SHT41 has no pressure sensor - return default value
-        *out_hpa = DEFAULT_PRESSURE_HPA;
-        return ESP_OK;
-    } else if (detected == SENSOR_TYPE_SHT41_BMP280) {
-        // Use no-trigger version since measurement already triggered in sensor_wake_and_measure()
-        return bmp280_read_pressure_no_trigger(out_hpa);
-    } else if (detected == SENSOR_TYPE_AHT20_BMP280) {
-        // Use no-trigger version since measurement already triggered in sensor_wake_and_measure()
-        return bmp280_read_pressure_no_trigger(out_hpa);
-    }
-    return ESP_ERR_NOT_FOUND;
+size_t sensor_format_stats(char *buf, size_t len)
+{
+    if (!buf || len == 0) return 0;
+    size_t off = 0;
+    buf[0] = '\0';
+    for (size_t i = 0; i < sensor_driver_count && off < len; i++) {
+        if (!(s_present & SENSOR_BIT(i)) && s_drv_stats[i].cycles == 0) continue;
+        const sensor_driver_stats_t *st = &s_drv_stats[i];
+        uint32_t errors = (uint32_t)st->bus_errors + st->crc_errors + st->timeouts;
+        int n = snprintf(buf + off, len - off, "%s%s ok%lu", off ? ";" : "", sensor_drivers[i].name,
+                         (unsigned long)st->cycles);
+        if (n > 0 && off + n < len && errors) {
+            n += snprintf(buf + off + n, len - off - n, " e%lu", (unsigned long)errors);
+        }
+        if (n > 0 && off + n < len && st->retries) {
+            n += snprintf(buf + off + n, len - off - n, " r%u", st->retries);
+        }
+        if (n < 0) break;
+        off += (size_t)n;
+    }
+    if (off >= len) off = len - 1;
+    return off;
+}
+
+const char *sensor_source_name(sensor_source_t src)
+{
+    switch (src) {
+    case SENSOR_SRC_BME280:  return "BME280";
+    case SENSOR_SRC_BMP280:  return "BMP280";
+    case SENSOR_SRC_SHT41:   return "SHT41";
+    case SENSOR_SRC_AHT20:   return "AHT20";
+    case SENSOR_SRC_DEFAULT: return "default";
+    default:                 return "none";
+    }
 }
@@ -2,29 +2,127 @@
 
 #include "i2c_bus.h"
 #include "esp_err.h"
+#include "driver/i2c.h"
+#include "sensor_profile.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+// Physical source of a channel value in a sensor_sample_t
 typedef enum {
-    SENSOR_TYPE_NONE = 0,
-    SENSOR_TYPE_BME280,
-    SENSOR_TYPE_AHT20_BMP280,
-    SENSOR_TYPE_SHT41,
-    SENSOR_TYPE_SHT41_BMP280,
-} sensor_type_t;
-
-// Initialize selected sensor stack (either BME280 or AHT20+BMP280)
+    SENSOR_SRC_NONE = 0,
+    SENSOR_SRC_BME280,
+    SENSOR_SRC_BMP280,
+    SENSOR_SRC_SHT41,
+    SENSOR_SRC_AHT20,
+    SENSOR_SRC_DEFAULT,     // Substituted constant (e.g. pressure on SHT41-only boards)
+} sensor_source_t;
+
+// Channel indices (driver tables) and bits (sensor_sample_t.valid)
+#define SENSOR_CH_IDX_TEMPERATURE 0
+#define SENSOR_CH_IDX_HUMIDITY    1
+#define SENSOR_CH_IDX_PRESSURE    2
+#define SENSOR_CH_COUNT           3
+#define SENSOR_CH_TEMPERATURE (1 << SENSOR_CH_IDX_TEMPERATURE)
+#define SENSOR_CH_HUMIDITY    (1 << SENSOR_CH_IDX_HUMIDITY)
+#define SENSOR_CH_PRESSURE    (1 << SENSOR_CH_IDX_PRESSURE)
+
+// One measurement cycle: all channels from a single conversion per chip
+typedef struct {
+    int64_t timestamp_us;           // esp_timer time the sample was collected
+    uint8_t valid;                  // SENSOR_CH_* bits of channels holding fresh data
+    float temperature_c;
+    float humidity_pct;             // 0-100
+    float pressure_hpa;
+    sensor_source_t temperature_src;
+    sensor_source_t humidity_src;
+    sensor_source_t pressure_src;
+} sensor_sample_t;
+
+// Conversion timing of a measurement cycle (datasheet derived, for instrumentation)
+typedef struct {
+    uint32_t first_poll_us;     // Longest typical conversion time: earliest point worth checking ready flags
+    uint32_t budget_us;         // Longest datasheet maximum conversion time of the started drivers
+    uint32_t last_wait_us;      // Measured start-to-ready time of the last sensor_wake_and_measure()
+} sensor_timing_t;
+
+// Error accounting of one driver since boot
+typedef struct {
+    uint32_t cycles;            // Successful collects
+    uint16_t bus_errors;        // NACK / arbitration loss on trigger or read
+    uint16_t crc_errors;        // Data CRC mismatch (ESP_ERR_INVALID_CRC)
+    uint16_t timeouts;          // Bus timeout or conversion not finished when collected
+    uint16_t retries;           // Extra conversions started by the retry policy
+    uint8_t consecutive;        // Failed cycles in a row (triggers bus recovery)
+} sensor_driver_stats_t;
+
+// Error accounting of the sensor layer since boot
+typedef struct {
+    uint32_t errors;            // Sum of all driver bus/CRC/timeout errors
+    uint32_t retries;           // Sum of all driver retries
+    uint16_t bus_recoveries;    // SCL clock-out + bus re-init runs
+    uint16_t incomplete;        // Cycles that ended with a present driver still failing
+} sensor_stats_t;
+
+// Remember how the I2C bus was created so bus recovery can rebuild it.
+// Call before sensor_init(); without it recovery is disabled.
+void sensor_set_bus_config(i2c_port_t port, const i2c_config_t *conf);
+
+// Attach every registered driver whose chip is on the bus (cached topology first,
+// full probe otherwise). Returns ESP_OK if at least one driver is present.
 esp_err_t sensor_init(i2c_bus_handle_t i2c_bus);
 
-// Return detected sensor type (after sensor_init)
-sensor_type_t sensor_get_type(void);
+// Select the measurement profile; takes effect at sensor_init() or the next
+// sensor_start_measurement(), so it is safe to call from the Zigbee task
+esp_err_t sensor_set_profile(sensor_profile_id_t id);
+
+// Profile last selected with sensor_set_profile()
+sensor_profile_id_t sensor_get_profile(void);
+
+// Subsample mode for software oversampling: BMx280 hardware oversampling X1 and IIR
+// filter off (the SHT41 keeps the profile's repeatability) until disabled again.
+// Takes effect at the next sensor_start_measurement(); call from the sensor task.
+void sensor_set_subsample(bool enable);
+
+// Bit mask of present drivers (bit i = sensor_drivers[i]), 0 if none
+uint32_t sensor_get_present(void);
+
+// Human-readable summary of the present drivers, e.g. "SHT41 + BMP280"
+const char *sensor_get_description(void);
+
+// Start conversions on all detected sensors at once without waiting.
+// *out_timing (optional) receives the typical/max conversion window of the slowest driver.
+// Returns ESP_OK if at least one sensor started.
+esp_err_t sensor_start_measurement(sensor_timing_t *out_timing);
+
+// Timing of the current / last measurement cycle
+void sensor_get_timing(sensor_timing_t *out_timing);
+
+// True once every conversion started by sensor_start_measurement() has finished
+bool sensor_measurement_ready(void);
+
+// Fetch results of the started conversions and build a sample from them.
+// *out_sample is optional. Returns ESP_OK if at least one channel is valid.
+esp_err_t sensor_collect(sensor_sample_t *out_sample);
+
+// Start, sleep until the slowest conversion is due, then collect into *out_sample (optional).
+// Drivers that fail are restarted while their worst-case conversion still fits in the
+// cycle deadline (conversion budget + SENSOR_RETRY_BUDGET_US); repeated failures trigger
+// a rate-limited bus recovery.
+esp_err_t sensor_wake_and_measure(sensor_sample_t *out_sample);
+
+// Return the sample built by the last sensor_collect()
+esp_err_t sensor_read_sample(sensor_sample_t *out_sample);
 
-// Wake sensor(s) and trigger measurement (if required)
-esp_err_t sensor_wake_and_measure(void);
+// Layer-wide error counters
+void sensor_get_stats(sensor_stats_t *out);
 
-// Read last measured temperature in degrees Celsius
-esp_err_t sensor_read_temperature(float *out_c);
+// Counters of sensor_drivers[idx]; *out_name (optional) receives the driver name
+esp_err_t sensor_get_driver_stats(size_t idx, const char **out_name, sensor_driver_stats_t *out);
 
-// Read last measured humidity in % (0-100). If sensor doesn't provide, return ESP_ERR_NOT_SUPPORTED
-esp_err_t sensor_read_humidity(float *out_percent);
+// Compact per-driver summary of the present drivers for the diagnostics attribute,
+// e.g. "SHT41 ok120 e2 r1;BMP280 ok122". Returns the string length.
+size_t sensor_format_stats(char *buf, size_t len);
 
-// Read last measured pressure in hPa. If sensor doesn't provide, return ESP_ERR_NOT_SUPPORTED
-esp_err_t sensor_read_pressure(float *out_hpa);
+// Short name of a sample source for logging
+const char *sensor_source_name(sensor_source_t src);
@@ -0,0 +1,131 @@
+/*
+ * Software Oversampling
+ *
+ * Design:
+ * - Fixed-point ring in plain RAM, sized at compile time (SENSOR_OVERSAMPLE_DEPTH): light
+ *   sleep keeps it, and it is emptied at every boot since esp_timer stamps restart from zero
+ * - Filled from cheap samples taken on wake-ups the stack does anyway (keep-alive polls),
+ *   so N samples cost N short conversions instead of one long hardware-oversampled one
+ * - Reduced at report time: per-channel mean, min/max trimmed from 4 entries on
+ * - Only the sensor task touches the ring, so no locking is needed
+ */
+
+#include "sensor_oversample.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "SENSOR_OVS";
+
+typedef struct {
+    uint32_t time_ms;           // esp_timer time in ms (wraps after 49 days; only differences are used)
+    int16_t  temperature_centi; // 0.01 °C
+    uint16_t humidity_centi;    // 0.01 %RH
+    uint32_t pressure_pa : 24;  // Pa (300-1100 hPa fits in 24 bits)
+    uint32_t valid : 8;         // SENSOR_CH_* bits
+} sensor_oversample_entry_t;
+
+static sensor_oversample_entry_t s_ring[SENSOR_OVERSAMPLE_DEPTH];
+static uint8_t s_head;     // Next slot to write
+static uint8_t s_count;    // Valid entries
+static uint32_t s_last_ms; // Time of the newest entry
+
+/* Per-channel accumulator for the trimmed mean */
+typedef struct {
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    uint32_t n;
+} sensor_oversample_acc_t;
+
+static uint32_t sensor_oversample_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void acc_add(sensor_oversample_acc_t *acc, int32_t v)
+{
+    if (acc->n == 0 || v < acc->min) acc->min = v;
+    if (acc->n == 0 || v > acc->max) acc->max = v;
+    acc->sum += v;
+    acc->n++;
+}
+
+static bool acc_mean(const sensor_oversample_acc_t *acc, float scale, float *out)
+{
+    if (acc->n == 0) return false;
+    int64_t sum = acc->sum;
+    uint32_t n = acc->n;
+    if (n >= 4) {
+        sum -= (int64_t)acc->min + acc->max;
+        n -= 2;
+    }
+    *out = (float)sum / (float)n / scale;
+    return true;
+}
+
+void sensor_oversample_reset(void)
+{
+    memset(s_ring, 0, sizeof(s_ring));
+    s_head = 0;
+    s_count = 0;
+    s_last_ms = 0;
+}
+
+bool sensor_oversample_due(void)
+{
+    if (s_count == 0) return true;
+    return (uint32_t)(sensor_oversample_now_ms() - s_last_ms) >= SENSOR_OVERSAMPLE_INTERVAL_MS;
+}
+
+void sensor_oversample_push(const sensor_sample_t *sample)
+{
+    if (!sample || sample->valid == 0) return;
+
+    sensor_oversample_entry_t *e = &s_ring[s_head];
+    memset(e, 0, sizeof(*e));
+    e->time_ms = (uint32_t)(sample->timestamp_us / 1000);
+    e->valid = sample->valid;
+    if (sample->valid & SENSOR_CH_TEMPERATURE) {
+        e->temperature_centi = (int16_t)lroundf(sample->temperature_c * 100.0f);
+    }
+    if (sample->valid & SENSOR_CH_HUMIDITY) {
+        e->humidity_centi = (uint16_t)lroundf(sample->humidity_pct * 100.0f);
+    }
+    if (sample->valid & SENSOR_CH_PRESSURE) {
+        e->pressure_pa = (uint32_t)lroundf(sample->pressure_hpa * 100.0f);
+    }
+
+    s_head = (uint8_t)((s_head + 1) % SENSOR_OVERSAMPLE_DEPTH);
+    if (s_count < SENSOR_OVERSAMPLE_DEPTH) s_count++;
+    s_last_ms = e->time_ms;
+}
+
+uint32_t sensor_oversample_reduce(sensor_sample_t *sample, uint32_t window_ms)
+{
+    if (!sample) return 0;
+
+    sensor_oversample_acc_t t = { 0 }, h = { 0 }, p = { 0 };
+    uint32_t now_ms = sensor_oversample_now_ms();
+    uint32_t used = 0;
+
+    for (uint8_t i = 0; i < s_count; i++) {
+        const sensor_oversample_entry_t *e = &s_ring[i];
+        if ((uint32_t)(now_ms - e->time_ms) > window_ms) continue;
+        used++;
+        if (e->valid & SENSOR_CH_TEMPERATURE) acc_add(&t, e->temperature_centi);
+        if (e->valid & SENSOR_CH_HUMIDITY) acc_add(&h, e->humidity_centi);
+        if (e->valid & SENSOR_CH_PRESSURE) acc_add(&p, (int32_t)e->pressure_pa);
+    }
+
+    // A channel that failed in the latest sample stays invalid rather than reporting old data
+    float v;
+    if ((sample->valid & SENSOR_CH_TEMPERATURE) && acc_mean(&t, 100.0f, &v)) sample->temperature_c = v;
+    if ((sample->valid & SENSOR_CH_HUMIDITY) && acc_mean(&h, 100.0f, &v)) sample->humidity_pct = v;
+    if ((sample->valid & SENSOR_CH_PRESSURE) && acc_mean(&p, 100.0f, &v)) sample->pressure_hpa = v;
+
+    ESP_LOGD(TAG, "Averaged %lu of %u stored samples", (unsigned long)used, s_count);
+    sensor_oversample_reset();
+    return used;
+}
@@ -0,0 +1,62 @@
+/*
+ * Software Oversampling
+ * RAM ring of cheap sensor samples taken on existing wake-ups,
+ * averaged into one value at report time
+ */
+
+#ifndef SENSOR_OVERSAMPLE_H
+#define SENSOR_OVERSAMPLE_H
+
+#include "sensor_if.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ring depth (samples kept between two reports); 12 bytes of RAM per entry */
+#ifndef SENSOR_OVERSAMPLE_DEPTH
+#define SENSOR_OVERSAMPLE_DEPTH 8
+#endif
+
+/* Minimum spacing of intermediate samples; with the 5-minute report period this
+ * yields ~4 intermediate samples per report */
+#ifndef SENSOR_OVERSAMPLE_INTERVAL_MS
+#define SENSOR_OVERSAMPLE_INTERVAL_MS 60000
+#endif
+
+/**
+ * @brief Drop all stored samples (call once at boot: timestamps do not survive a reset)
+ */
+void sensor_oversample_reset(void);
+
+/**
+ * @brief True when the newest stored sample is older than SENSOR_OVERSAMPLE_INTERVAL_MS
+ */
+bool sensor_oversample_due(void);
+
+/**
+ * @brief Store the valid channels of a sample, overwriting the oldest entry when full
+ * @param sample Sample returned by sensor_collect()/sensor_wake_and_measure()
+ */
+void sensor_oversample_push(const sensor_sample_t *sample);
+
+/**
+ * @brief Average the stored samples younger than window_ms into *sample and empty the ring
+ *
+ * Each channel is averaged over the entries where it was valid; with four or more
+ * entries the minimum and maximum are dropped first so a single glitch cannot move
+ * the result. Only channels valid in *sample are replaced.
+ *
+ * @param sample    In: latest sample (should already be pushed). Out: averaged channels
+ * @param window_ms Entries older than this are ignored
+ * @return Number of entries inside the window (0 if nothing was averaged)
+ */
+uint32_t sensor_oversample_reduce(sensor_sample_t *sample, uint32_t window_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_OVERSAMPLE_H
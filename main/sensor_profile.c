@@ -0,0 +1,114 @@
+/*
+ * Sensor Measurement Profiles
+ *
+ * Design:
+ * - Const table of presets; the profile id is the only persisted state (one u8 in NVS)
+ * - Energy figures are sensor-side estimates at 3.3 V from datasheet typical
+ *   conversion times and supply currents:
+ *     BMx280: 1 ms start-up @ 350 uA, T 2 ms/osr @ 350 uA,
+ *             P (2 ms/osr + 0.5 ms) @ 714 uA, H (2 ms/osr + 0.5 ms) @ 340 uA
+ *     SHT41:  500 uA for 1.6 / 4.5 / 8.3 ms (low / medium / high)
+ *   The larger of "BME280" and "SHT41 + BMP280" is listed; AHT20 has no
+ *   settings and MCU wake time is not included
+ */
+
+#include "sensor_profile.h"
+#include "bmx280_comp.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "SENSOR_PROFILE";
+static const char *NVS_NAMESPACE = "sensor_prof";
+static const char *NVS_KEY = "profile";
+
+static const sensor_profile_t s_profiles[SENSOR_PROFILE_COUNT] = {
+    /* Datasheet "weather monitoring" setting: lowest energy, highest noise */
+    [SENSOR_PROFILE_ECO] = {
+        .name = "eco",
+        .osrs_t = BMX280_OSRS_X1, .osrs_p = BMX280_OSRS_X1, .osrs_h = BMX280_OSRS_X1,
+        .filter = BMX280_FILTER_OFF,
+        .sht41_precision = SHT41_PRECISION_LOW,
+        .energy_uj = 12,
+    },
+    /* ~2x lower pressure noise, light smoothing of single outliers */
+    [SENSOR_PROFILE_BALANCED] = {
+        .name = "balanced",
+        .osrs_t = BMX280_OSRS_X2, .osrs_p = BMX280_OSRS_X4, .osrs_h = BMX280_OSRS_X2,
+        .filter = BMX280_FILTER_X2,
+        .sht41_precision = SHT41_PRECISION_MEDIUM,
+        .energy_uj = 33,
+    },
+    /* Lowest noise; IIR kept at 4 because samples are minutes apart */
+    [SENSOR_PROFILE_PRECISE] = {
+        .name = "precise",
+        .osrs_t = BMX280_OSRS_X2, .osrs_p = BMX280_OSRS_X16, .osrs_h = BMX280_OSRS_X4,
+        .filter = BMX280_FILTER_X4,
+        .sht41_precision = SHT41_PRECISION_HIGH,
+        .energy_uj = 96,
+    },
+    /* Default: the original fixed settings (BMx280 as eco, SHT41 high repeatability) */
+    [SENSOR_PROFILE_STANDARD] = {
+        .name = "standard",
+        .osrs_t = BMX280_OSRS_X1, .osrs_p = BMX280_OSRS_X1, .osrs_h = BMX280_OSRS_X1,
+        .filter = BMX280_FILTER_OFF,
+        .sht41_precision = SHT41_PRECISION_HIGH,
+        .energy_uj = 23,
+    },
+};
+
+const sensor_profile_t *sensor_profile_get(sensor_profile_id_t id)
+{
+    if ((unsigned)id >= SENSOR_PROFILE_COUNT) return NULL;
+    return &s_profiles[id];
+}
+
+esp_err_t sensor_profile_load(sensor_profile_id_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    *out = SENSOR_PROFILE_DEFAULT;
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t id = 0;
+    esp_err_t ret = nvs_get_u8(nvs_handle, NVS_KEY, &id);
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK || id >= SENSOR_PROFILE_COUNT) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *out = (sensor_profile_id_t)id;
+    return ESP_OK;
+}
+
+esp_err_t sensor_profile_save(sensor_profile_id_t id)
+{
+    if ((unsigned)id >= SENSOR_PROFILE_COUNT) return ESP_ERR_INVALID_ARG;
+
+    sensor_profile_id_t stored;
+    if (sensor_profile_load(&stored) == ESP_OK && stored == id) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_u8(nvs_handle, NVS_KEY, (uint8_t)id);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "💾 Measurement profile '%s' saved", s_profiles[id].name);
+    } else {
+        ESP_LOGE(TAG, "Failed to store measurement profile: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
@@ -0,0 +1,65 @@
+/*
+ * Sensor Measurement Profiles
+ * Named oversampling / IIR filter / SHT41 repeatability presets that trade
+ * measurement noise against energy per sample, persisted in NVS
+ */
+
+#ifndef SENSOR_PROFILE_H
+#define SENSOR_PROFILE_H
+
+#include "esp_err.h"
+#include "sht41.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Values are exchanged over Zigbee (enum8 attribute) and stored in NVS - do not renumber */
+typedef enum {
+    SENSOR_PROFILE_ECO = 0,
+    SENSOR_PROFILE_BALANCED = 1,
+    SENSOR_PROFILE_PRECISE = 2,
+    SENSOR_PROFILE_STANDARD = 3,
+    SENSOR_PROFILE_COUNT,
+} sensor_profile_id_t;
+
+/* Profile used when nothing valid is stored: the chip settings from before profiles existed */
+#define SENSOR_PROFILE_DEFAULT SENSOR_PROFILE_STANDARD
+
+typedef struct {
+    const char *name;
+    uint8_t osrs_t;                     // BMX280_OSRS_* temperature oversampling
+    uint8_t osrs_p;                     // BMX280_OSRS_* pressure oversampling
+    uint8_t osrs_h;                     // BMX280_OSRS_* humidity oversampling (BME280 only)
+    uint8_t filter;                     // BMX280_FILTER_* IIR coefficient
+    sht41_precision_t sht41_precision;  // SHT41 repeatability
+    uint16_t energy_uj;                 // Estimated sensor energy per sample at 3.3 V (µJ)
+} sensor_profile_t;
+
+/**
+ * @brief Get the settings of a profile
+ * @param id Profile identifier
+ * @return Profile settings, or NULL if id is out of range
+ */
+const sensor_profile_t *sensor_profile_get(sensor_profile_id_t id);
+
+/**
+ * @brief Load the selected profile from NVS
+ * @param out Receives the stored profile, or SENSOR_PROFILE_DEFAULT if none/invalid
+ * @return ESP_OK if a valid profile was stored, ESP_ERR_NOT_FOUND otherwise
+ */
+esp_err_t sensor_profile_load(sensor_profile_id_t *out);
+
+/**
+ * @brief Persist the selected profile in NVS (no flash write if unchanged)
+ * @param id Profile identifier
+ * @return ESP_OK on success
+ */
+esp_err_t sensor_profile_save(sensor_profile_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_PROFILE_H
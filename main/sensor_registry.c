@@ -0,0 +1,166 @@
+#include "sensor_driver.h"
+#include "bme280_app.h"
+#include "bmp280.h"
+#include "sht41.h"
+#include "aht20.h"
+
+/* Driver registry: glue between the chip drivers and the generic sensor layer.
+ * Channel quality decides which present chip serves a channel (highest wins,
+ * the next one is the fallback when a read fails):
+ *   temperature: SHT41 (±0.2 °C) > AHT20 (±0.3 °C) > BME280 > BMP280 (±1 °C, self-heated)
+ *   humidity:    SHT41 (±1.8 %RH) > AHT20 (±2 %RH) > BME280 (±3 %RH)
+ *   pressure:    BME280 > BMP280 (same core, BME280 preferred when both fitted) */
+
+#define BMP280_CHIP_ID 0x58
+
+/* ---------- BME280 (humidity-capable Bosch chip via bme280_app) ---------- */
+
+static esp_err_t bme280_drv_attach(i2c_bus_handle_t i2c_bus, const sensor_topology_dev_t *dev)
+{
+    if (dev->calib_len < BME280_CALIB_LEN) return ESP_ERR_INVALID_SIZE;
+    return bme280_app_attach(i2c_bus, dev->addr, dev->chip_id, dev->calib);
+}
+
+static esp_err_t bme280_drv_describe(sensor_topology_dev_t *dev)
+{
+    dev->addr = bme280_app_get_address();
+    dev->chip_id = bme280_app_get_chip_id();
+    dev->calib_len = BME280_CALIB_LEN;
+    return bme280_app_get_calibration(dev->calib, sizeof(dev->calib));
+}
+
+static esp_err_t bme280_drv_configure(const sensor_profile_t *profile)
+{
+    return bme280_app_set_config(profile->osrs_t, profile->osrs_p, profile->osrs_h, profile->filter);
+}
+
+/* ---------- BMP280 (temperature + pressure) ---------- */
+
+static esp_err_t bmp280_drv_attach(i2c_bus_handle_t i2c_bus, const sensor_topology_dev_t *dev)
+{
+    if (dev->calib_len < BMP280_CALIB_LEN) return ESP_ERR_INVALID_SIZE;
+    return bmp280_attach(i2c_bus, dev->addr, dev->calib);
+}
+
+static esp_err_t bmp280_drv_describe(sensor_topology_dev_t *dev)
+{
+    dev->addr = bmp280_get_address();
+    dev->chip_id = BMP280_CHIP_ID;
+    dev->calib_len = BMP280_CALIB_LEN;
+    return bmp280_get_calibration(dev->calib, sizeof(dev->calib));
+}
+
+static esp_err_t bmp280_drv_configure(const sensor_profile_t *profile)
+{
+    return bmp280_set_config(profile->osrs_t, profile->osrs_p, profile->filter);
+}
+
+/* ---------- SHT41 (temperature + humidity) ---------- */
+
+static esp_err_t sht41_drv_attach(i2c_bus_handle_t i2c_bus, const sensor_topology_dev_t *dev)
+{
+    (void)dev;  // fixed address
+    return sht41_attach(i2c_bus);
+}
+
+static esp_err_t sht41_drv_describe(sensor_topology_dev_t *dev)
+{
+    dev->addr = sht41_get_address();
+    return ESP_OK;
+}
+
+static esp_err_t sht41_drv_configure(const sensor_profile_t *profile)
+{
+    return sht41_set_precision(profile->sht41_precision);
+}
+
+/* ---------- AHT20 (temperature + humidity) ---------- */
+
+static esp_err_t aht20_drv_attach(i2c_bus_handle_t i2c_bus, const sensor_topology_dev_t *dev)
+{
+    (void)dev;  // fixed address; init is a single status read
+    return aht20_init(i2c_bus);
+}
+
+static esp_err_t aht20_drv_describe(sensor_topology_dev_t *dev)
+{
+    dev->addr = aht20_get_address();
+    return ESP_OK;
+}
+
+const sensor_driver_t sensor_drivers[] = {
+    {
+        .name = "BME280",
+        .source = SENSOR_SRC_BME280,
+        .quality = { [SENSOR_CH_IDX_TEMPERATURE] = 60, [SENSOR_CH_IDX_HUMIDITY] = 60, [SENSOR_CH_IDX_PRESSURE] = 100 },
+        .probe = bme280_app_init,
+        .attach = bme280_drv_attach,
+        .describe = bme280_drv_describe,
+        .release = bme280_app_deinit,
+        .configure = bme280_drv_configure,
+        .start = bme280_app_start_measurement,
+        .ready = bme280_app_is_measurement_ready,
+        .collect = bme280_app_collect,
+        .sleep = bme280_app_sleep,
+        .read = {
+            [SENSOR_CH_IDX_TEMPERATURE] = bme280_app_read_temperature,
+            [SENSOR_CH_IDX_HUMIDITY] = bme280_app_read_humidity,
+            [SENSOR_CH_IDX_PRESSURE] = bme280_app_read_pressure,
+        },
+    },
+    {
+        .name = "SHT41",
+        .source = SENSOR_SRC_SHT41,
+        .quality = { [SENSOR_CH_IDX_TEMPERATURE] = 100, [SENSOR_CH_IDX_HUMIDITY] = 100 },
+        .probe = sht41_init,
+        .attach = sht41_drv_attach,
+        .describe = sht41_drv_describe,
+        .release = sht41_deinit,
+        .configure = sht41_drv_configure,
+        .start = sht41_start_measurement,
+        .ready = sht41_is_measurement_ready,
+        .collect = sht41_collect,
+        .read = {
+            [SENSOR_CH_IDX_TEMPERATURE] = sht41_read_temperature,
+            [SENSOR_CH_IDX_HUMIDITY] = sht41_read_humidity,
+        },
+    },
+    {
+        .name = "AHT20",
+        .source = SENSOR_SRC_AHT20,
+        .quality = { [SENSOR_CH_IDX_TEMPERATURE] = 80, [SENSOR_CH_IDX_HUMIDITY] = 80 },
+        .probe = aht20_init,
+        .attach = aht20_drv_attach,
+        .describe = aht20_drv_describe,
+        .release = aht20_deinit,
+        .start = aht20_start_measurement,
+        .ready = aht20_is_measurement_ready,
+        .collect = aht20_collect,
+        .read = {
+            [SENSOR_CH_IDX_TEMPERATURE] = aht20_read_temperature,
+            [SENSOR_CH_IDX_HUMIDITY] = aht20_read_humidity,
+        },
+    },
+    {
+        .name = "BMP280",
+        .source = SENSOR_SRC_BMP280,
+        .quality = { [SENSOR_CH_IDX_TEMPERATURE] = 40, [SENSOR_CH_IDX_PRESSURE] = 90 },
+        .probe = bmp280_init,
+        .attach = bmp280_drv_attach,
+        .describe = bmp280_drv_describe,
+        .release = bmp280_deinit,
+        .configure = bmp280_drv_configure,
+        .start = bmp280_start_measurement,
+        .ready = bmp280_is_measurement_ready,
+        .collect = bmp280_collect,
+        .read = {
+            [SENSOR_CH_IDX_TEMPERATURE] = bmp280_read_temperature,
+            [SENSOR_CH_IDX_PRESSURE] = bmp280_read_pressure,
+        },
+    },
+};
+
+const size_t sensor_driver_count = sizeof(sensor_drivers) / sizeof(sensor_drivers[0]);
+
+_Static_assert(sizeof(sensor_drivers) / sizeof(sensor_drivers[0]) <= SENSOR_TOPOLOGY_MAX_DEVICES,
+               "sensor_topology_t cannot cache every registered driver");
@@ -0,0 +1,107 @@
+/*
+ * Sensor Topology Cache
+ *
+ * Design:
+ * - One CRC-protected, versioned blob in NVS (survives brown-outs and power loss)
+ * - Written only when the full probe result differs from what is stored
+ * - A version or CRC mismatch is treated as "no cache" and triggers the full probe
+ */
+
+#include "sensor_topology.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "SENSOR_TOPO";
+static const char *NVS_NAMESPACE = "sensor_topo";
+static const char *NVS_KEY = "topo";
+
+static uint32_t sensor_topology_crc(const sensor_topology_t *topo)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)topo, offsetof(sensor_topology_t, crc));
+}
+
+esp_err_t sensor_topology_load(sensor_topology_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (ret != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sensor_topology_t topo;
+    size_t size = sizeof(topo);
+    ret = nvs_get_blob(nvs_handle, NVS_KEY, &topo, &size);
+    nvs_close(nvs_handle);
+    if (ret != ESP_OK || size != sizeof(topo)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (topo.version != SENSOR_TOPOLOGY_VERSION) {
+        ESP_LOGW(TAG, "Cached topology version %u != %u - ignoring", topo.version, SENSOR_TOPOLOGY_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (topo.crc != sensor_topology_crc(&topo) || topo.count > SENSOR_TOPOLOGY_MAX_DEVICES) {
+        ESP_LOGW(TAG, "Cached topology CRC mismatch - ignoring");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *out = topo;
+    return ESP_OK;
+}
+
+esp_err_t sensor_topology_save(sensor_topology_t *topo)
+{
+    if (!topo) return ESP_ERR_INVALID_ARG;
+
+    topo->version = SENSOR_TOPOLOGY_VERSION;
+    topo->crc = sensor_topology_crc(topo);
+
+    // Avoid a flash write on every boot when the probe found the same hardware
+    sensor_topology_t stored;
+    if (sensor_topology_load(&stored) == ESP_OK && memcmp(&stored, topo, sizeof(stored)) == 0) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_blob(nvs_handle, NVS_KEY, topo, sizeof(*topo));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "💾 Sensor topology cached (%u device(s))", topo->count);
+    } else {
+        ESP_LOGE(TAG, "Failed to store sensor topology: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t sensor_topology_erase(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        return ESP_OK;
+    }
+
+    ret = nvs_erase_key(nvs_handle, NVS_KEY);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    } else if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+    nvs_close(nvs_handle);
+    return ret;
+}
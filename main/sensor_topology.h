@@ -0,0 +1,68 @@
+/*
+ * Sensor Topology Cache
+ * Remembers which I2C sensors were found (type, addresses, calibration)
+ * so later boots can skip the bus scan and probe chain
+ */
+
+#ifndef SENSOR_TOPOLOGY_H
+#define SENSOR_TOPOLOGY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bump whenever the layout or meaning of sensor_topology_t changes */
+#define SENSOR_TOPOLOGY_VERSION 3
+
+/* Raw Bosch calibration block: 0x88-0xA1 (26 bytes) + 0xE1-0xE7 (7 bytes) */
+#define SENSOR_TOPOLOGY_CALIB_MAX 33
+
+/* Devices that can be cached (entries of the sensor driver registry) */
+#define SENSOR_TOPOLOGY_MAX_DEVICES 6
+
+/* What a driver needs to re-attach without probing */
+typedef struct {
+    uint8_t  source;            // sensor_source_t of the driver, SENSOR_SRC_NONE for an unused slot
+    uint8_t  addr;              // I2C address
+    uint8_t  chip_id;           // Chip ID seen at probe time, 0 if the chip has none
+    uint8_t  calib_len;         // Valid bytes in calib[]
+    uint8_t  calib[SENSOR_TOPOLOGY_CALIB_MAX];
+} sensor_topology_dev_t;
+
+typedef struct {
+    uint16_t version;           // SENSOR_TOPOLOGY_VERSION
+    uint8_t  count;             // Used entries in dev[]
+    uint8_t  reserved;
+    sensor_topology_dev_t dev[SENSOR_TOPOLOGY_MAX_DEVICES];
+    uint32_t crc;               // CRC32 over all preceding bytes
+} sensor_topology_t;
+
+/**
+ * @brief Load the cached topology from NVS
+ * @param out Destination record
+ * @return ESP_OK if a record with matching version and CRC was found,
+ *         ESP_ERR_NOT_FOUND / ESP_ERR_INVALID_VERSION / ESP_ERR_INVALID_CRC otherwise
+ */
+esp_err_t sensor_topology_load(sensor_topology_t *out);
+
+/**
+ * @brief Store a topology record in NVS (version and CRC are filled in here)
+ * @param topo Record to store
+ * @return ESP_OK on success
+ */
+esp_err_t sensor_topology_save(sensor_topology_t *topo);
+
+/**
+ * @brief Remove the cached topology so the next boot runs the full probe
+ * @return ESP_OK on success or if nothing was stored
+ */
+esp_err_t sensor_topology_erase(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_TOPOLOGY_H
@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -15,10 +16,37 @@ static const char *TAG = "SHT41";
 // Commands for SHT41
 #define SHT41_CMD_MEASURE_HIGH_PRECISION 0xFD  // High precision measurement (~8.3ms)
 #define SHT41_CMD_SOFT_RESET 0x94
+#define SHT41_CMD_READ_SERIAL 0x89
+
+// Measurement duration per repeatability (datasheet table 4). The SHT4x has no
+// ready flag and NACKs reads while busy, so the max time is always waited.
+#define SHT41_CMD_MEASURE_MEDIUM_PRECISION 0xF6
+#define SHT41_CMD_MEASURE_LOW_PRECISION 0xE0
+#define SHT41_TIME_HIGH_MAX_US   8300
+#define SHT41_TIME_MEDIUM_MAX_US 4500
+#define SHT41_TIME_LOW_MAX_US    1600
 
 static i2c_bus_device_handle_t s_dev = NULL;
 static float s_last_temperature = 0.0f;
 static float s_last_humidity = 0.0f;
+static bool s_have_data = false;
+
+// Measurement command used by sht41_start_measurement()
+static uint8_t s_measure_cmd = SHT41_CMD_MEASURE_HIGH_PRECISION;
+
+// Split-phase state: time the pending conversion was started and its duration
+static bool s_pending = false;
+static int64_t s_start_us = 0;
+static uint32_t s_max_us = 0;
+
+static uint32_t sht41_measure_time_us(uint8_t cmd)
+{
+    switch (cmd) {
+    case SHT41_CMD_MEASURE_LOW_PRECISION:    return SHT41_TIME_LOW_MAX_US;
+    case SHT41_CMD_MEASURE_MEDIUM_PRECISION: return SHT41_TIME_MEDIUM_MAX_US;
+    default:                                 return SHT41_TIME_HIGH_MAX_US;
+    }
+}
 
 // CRC-8 calculation for SHT41 (polynomial: 0x31, init: 0xFF)
 static uint8_t sht41_crc8(const uint8_t *data, size_t len)
@@ -37,9 +65,25 @@ static uint8_t sht41_crc8(const uint8_t *data, size_t len)
     return crc;
 }
 
+static void sht41_release(void)
+{
+    if (s_dev) {
+        i2c_bus_device_delete(&s_dev);
+        s_dev = NULL;
+    }
+    s_pending = false;
+    s_have_data = false;
+}
+
+void sht41_deinit(void)
+{
+    sht41_release();
+}
+
 esp_err_t sht41_init(i2c_bus_handle_t i2c_bus)
 {
     if (!i2c_bus) return ESP_ERR_INVALID_ARG;
+    sht41_release();
 
     // Create device handle
     i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, SHT41_I2C_ADDR, 0);
@@ -74,26 +118,89 @@ esp_err_t sht41_init(i2c_bus_handle_t i2c_bus)
     return ESP_OK;
 }
 
-esp_err_t sht41_trigger_measurement(void)
+esp_err_t sht41_attach(i2c_bus_handle_t i2c_bus)
+{
+    if (!i2c_bus) return ESP_ERR_INVALID_ARG;
+    sht41_release();
+
+    i2c_bus_device_handle_t dev = i2c_bus_device_create(i2c_bus, SHT41_I2C_ADDR, 0);
+    if (dev == NULL) return ESP_ERR_NOT_FOUND;
+
+    // SHT4x has no ID register - a CRC-valid serial number read confirms presence
+    uint8_t cmd = SHT41_CMD_READ_SERIAL;
+    uint8_t raw[6];
+    esp_err_t ret = i2c_bus_write_bytes(dev, NULL_I2C_MEM_ADDR, 1, &cmd);
+    if (ret == ESP_OK) {
+        vTaskDelay(pdMS_TO_TICKS(1) + 1);
+        ret = i2c_bus_read_bytes(dev, NULL_I2C_MEM_ADDR, sizeof(raw), raw);
+    }
+    if (ret == ESP_OK && (sht41_crc8(&raw[0], 2) != raw[2] || sht41_crc8(&raw[3], 2) != raw[5])) {
+        ret = ESP_ERR_INVALID_CRC;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "sht41_attach: serial read failed (%s)", esp_err_to_name(ret));
+        i2c_bus_device_delete(&dev);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_dev = dev;
+    return ESP_OK;
+}
+
+uint8_t sht41_get_address(void)
+{
+    return s_dev ? SHT41_I2C_ADDR : 0;
+}
+
+esp_err_t sht41_set_precision(sht41_precision_t precision)
+{
+    switch (precision) {
+    case SHT41_PRECISION_LOW:    s_measure_cmd = SHT41_CMD_MEASURE_LOW_PRECISION; break;
+    case SHT41_PRECISION_MEDIUM: s_measure_cmd = SHT41_CMD_MEASURE_MEDIUM_PRECISION; break;
+    case SHT41_PRECISION_HIGH:   s_measure_cmd = SHT41_CMD_MEASURE_HIGH_PRECISION; break;
+    default:                     return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sht41_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us)
 {
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
 
-    // Send high precision measurement command
-    uint8_t cmd = SHT41_CMD_MEASURE_HIGH_PRECISION;
+    // Send measurement command, result is fetched by sht41_collect()
+    uint8_t cmd = s_measure_cmd;
     esp_err_t ret = i2c_bus_write_bytes(s_dev, NULL_I2C_MEM_ADDR, 1, &cmd);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "sht41_trigger_measurement: write failed");
+        ESP_LOGW(TAG, "sht41_start_measurement: write failed");
+        s_pending = false;
         return ret;
     }
 
-    // Wait for measurement to complete (typical 8.3ms for high precision)
-    vTaskDelay(pdMS_TO_TICKS(10));
+    s_start_us = esp_timer_get_time();
+    s_max_us = sht41_measure_time_us(cmd);
+    s_pending = true;
+    if (out_min_us) *out_min_us = s_max_us;
+    if (out_max_us) *out_max_us = s_max_us;
+    return ESP_OK;
+}
+
+bool sht41_is_measurement_ready(void)
+{
+    if (!s_pending) return false;
+    return (esp_timer_get_time() - s_start_us) >= (int64_t)s_max_us;
+}
+
+esp_err_t sht41_collect(void)
+{
+    if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_pending) return ESP_ERR_INVALID_STATE;
+    s_pending = false;
 
     // Read 6 bytes: temp_msb, temp_lsb, temp_crc, hum_msb, hum_lsb, hum_crc
     uint8_t raw[6];
-    ret = i2c_bus_read_bytes(s_dev, NULL_I2C_MEM_ADDR, 6, raw);
+    esp_err_t ret = i2c_bus_read_bytes(s_dev, NULL_I2C_MEM_ADDR, 6, raw);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "sht41_trigger_measurement: read failed");
+        ESP_LOGW(TAG, "sht41_collect: read failed");
         return ret;
     }
 
@@ -123,6 +230,7 @@ esp_err_t sht41_trigger_measurement(void)
     if (s_last_humidity < 0.0f) s_last_humidity = 0.0f;
     if (s_last_humidity > 100.0f) s_last_humidity = 100.0f;
 
+    s_have_data = true;
     ESP_LOGD(TAG, "SHT41 measurement: T=%.2f°C, RH=%.2f%%", s_last_temperature, s_last_humidity);
 
     return ESP_OK;
@@ -132,6 +240,7 @@ esp_err_t sht41_read_temperature(float *out_c)
 {
     if (!out_c) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
     *out_c = s_last_temperature;
     return ESP_OK;
@@ -141,6 +250,7 @@ esp_err_t sht41_read_humidity(float *out_percent)
 {
     if (!out_percent) return ESP_ERR_INVALID_ARG;
     if (s_dev == NULL) return ESP_ERR_NOT_FOUND;
+    if (!s_have_data) return ESP_ERR_INVALID_STATE;
 
     *out_percent = s_last_humidity;
     return ESP_OK;
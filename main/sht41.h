@@ -2,15 +2,43 @@
 
 #include "i2c_bus.h"
 #include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Measurement repeatability (commands 0xE0 / 0xF6 / 0xFD)
+typedef enum {
+    SHT41_PRECISION_LOW = 0,    // 1.6 ms max
+    SHT41_PRECISION_MEDIUM,     // 4.5 ms max
+    SHT41_PRECISION_HIGH,       // 8.3 ms max (default)
+} sht41_precision_t;
 
 // Initialize SHT41 on the provided I2C bus
 esp_err_t sht41_init(i2c_bus_handle_t i2c_bus);
 
-// Trigger a measurement
-esp_err_t sht41_trigger_measurement(void);
+// Attach to a previously detected SHT41 (serial number read only, no soft reset)
+esp_err_t sht41_attach(i2c_bus_handle_t i2c_bus);
+
+// Release the device handle (before the I2C bus is deleted)
+void sht41_deinit(void);
+
+// I2C address of the attached SHT41 (0 if none)
+uint8_t sht41_get_address(void);
+
+// Select the repeatability used by the following measurements
+esp_err_t sht41_set_precision(sht41_precision_t precision);
+
+// Start a measurement without waiting; the optional outputs receive the earliest ready
+// time and the maximum conversion time (identical: the SHT41 has no ready flag)
+esp_err_t sht41_start_measurement(uint32_t *out_min_us, uint32_t *out_max_us);
+
+// True once the datasheet maximum measurement duration has elapsed
+bool sht41_is_measurement_ready(void);
+
+// Fetch and cache the result of the pending conversion
+esp_err_t sht41_collect(void);
 
-// Read temperature in degrees Celsius
+// Read temperature in degrees Celsius (last collected value)
 esp_err_t sht41_read_temperature(float *out_c);
 
-// Read relative humidity in percent (0-100)
+// Read relative humidity in percent (0-100) (last collected value)
 esp_err_t sht41_read_humidity(float *out_percent);
@@ -22,10 +22,6 @@ static const char *SLEEP_TAG = "SLEEP";
 
 /* RTC memory to persist data across sleep cycles */
 static RTC_DATA_ATTR uint32_t boot_count = 0;
-static RTC_DATA_ATTR float rtc_rainfall_mm = 0.0f;
-static RTC_DATA_ATTR uint32_t rtc_rain_pulse_count = 0;
-static RTC_DATA_ATTR float rtc_pulse_counter_value = 0.0f;
-static RTC_DATA_ATTR uint32_t rtc_pulse_counter_count = 0;
 static RTC_DATA_ATTR int64_t last_report_timestamp = 0;
 
 /* Wake-up reason tracking */
@@ -66,10 +62,6 @@ wake_reason_t check_wake_reason(void)
             ESP_LOGI(SLEEP_TAG, "🔌 Wake-up reason: POWER ON / RESET");
             // Reset RTC memory on first boot
             if (boot_count == 1) {
-                rtc_rainfall_mm = 0.0f;
-                rtc_rain_pulse_count = 0;
-                rtc_pulse_counter_value = 0.0f;
-                rtc_pulse_counter_count = 0;
                 last_report_timestamp = 0;
             }
             return WAKE_REASON_RESET;
@@ -112,148 +104,7 @@ void configure_gpio_wakeup(gpio_num_t gpio_num, int level)
     }
 }
 
-/**
- * @brief Save rainfall data to RTC memory and NVS
- * @param rainfall_mm Current total rainfall in mm
- * @param pulse_count Current pulse count
- */
-void save_rainfall_data(float rainfall_mm, uint32_t pulse_count)
-{
-    // Save to RTC memory (fast, survives sleep)
-    rtc_rainfall_mm = rainfall_mm;
-    rtc_rain_pulse_count = pulse_count;
-    
-    ESP_LOGI(SLEEP_TAG, "💾 Saved to RTC: %.2f mm, %lu pulses", rtc_rainfall_mm, rtc_rain_pulse_count);
-    
-    // Also save to NVS for persistence across power loss
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("rain_storage", NVS_READWRITE, &nvs_handle);
-    if (ret == ESP_OK) {
-        nvs_set_blob(nvs_handle, "rainfall", &rainfall_mm, sizeof(float));
-        nvs_set_u32(nvs_handle, "pulses", pulse_count);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-        ESP_LOGI(SLEEP_TAG, "💾 Saved to NVS: %.2f mm, %lu pulses", rainfall_mm, pulse_count);
-    }
-}
-
-/**
- * @brief Load rainfall data from RTC memory or NVS
- * @param rainfall_mm Pointer to store rainfall value
- * @param pulse_count Pointer to store pulse count
- * @return true if data loaded from RTC, false if loaded from NVS
- */
-bool load_rainfall_data(float *rainfall_mm, uint32_t *pulse_count)
-{
-    // Check if we have valid RTC data (from previous sleep cycle)
-    if (boot_count > 1) {
-        *rainfall_mm = rtc_rainfall_mm;
-        *pulse_count = rtc_rain_pulse_count;
-        if (!isfinite(*rainfall_mm)) {
-            ESP_LOGW(SLEEP_TAG, "RTC rainfall NaN/Inf — resetting to 0");
-            *rainfall_mm = 0.0f;
-            *pulse_count = 0;
-        }
-        ESP_LOGI(SLEEP_TAG, "📂 Loaded from RTC: %.2f mm, %lu pulses", *rainfall_mm, *pulse_count);
-        return true;
-    }
-    
-    // Otherwise, try to load from NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("rain_storage", NVS_READONLY, &nvs_handle);
-    if (ret == ESP_OK) {
-        size_t size = sizeof(float);
-        ret = nvs_get_blob(nvs_handle, "rainfall", rainfall_mm, &size);
-        if (ret == ESP_OK) {
-            nvs_get_u32(nvs_handle, "pulses", pulse_count);
-            nvs_close(nvs_handle);
-            ESP_LOGI(SLEEP_TAG, "📂 Loaded from NVS: %.2f mm, %lu pulses", *rainfall_mm, *pulse_count);
-            
-            // Update RTC memory
-            rtc_rainfall_mm = *rainfall_mm;
-            rtc_rain_pulse_count = *pulse_count;
-            return false;
-        }
-        nvs_close(nvs_handle);
-    }
-    
-    // No stored data, start fresh
-    *rainfall_mm = 0.0f;
-    *pulse_count = 0;
-    ESP_LOGI(SLEEP_TAG, "📂 No stored data, starting from 0.0 mm");
-    return false;
-}
-
-/**
- * @brief Save pulse counter data to RTC memory and NVS
- * @param pulse_value Current total pulse counter value
- * @param pulse_count Current pulse count
- */
-void save_pulse_counter_data(float pulse_value, uint32_t pulse_count)
-{
-    // Save to RTC memory (fast, survives sleep)
-    rtc_pulse_counter_value = pulse_value;
-    rtc_pulse_counter_count = pulse_count;
-    
-    ESP_LOGI(SLEEP_TAG, "💾 Saved to RTC: %.2f value, %lu pulses", rtc_pulse_counter_value, rtc_pulse_counter_count);
-    
-    // Also save to NVS for persistence across power loss
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("pulse_storage", NVS_READWRITE, &nvs_handle);
-    if (ret == ESP_OK) {
-        nvs_set_blob(nvs_handle, "pulse_val", &pulse_value, sizeof(float));
-        nvs_set_u32(nvs_handle, "pulse_cnt", pulse_count);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-        ESP_LOGI(SLEEP_TAG, "💾 Saved to NVS: %.2f value, %lu pulses", pulse_value, pulse_count);
-    }
-}
-
-/**
- * @brief Load pulse counter data from RTC memory or NVS
- * @param pulse_value Pointer to store pulse counter value
- * @param pulse_count Pointer to store pulse count
- * @return true if data loaded from RTC, false if loaded from NVS
- */
-bool load_pulse_counter_data(float *pulse_value, uint32_t *pulse_count)
-{
-    // Check if we have valid RTC data (from previous sleep cycle)
-    if (boot_count > 1) {
-        *pulse_value = rtc_pulse_counter_value;
-        *pulse_count = rtc_pulse_counter_count;
-        if (!isfinite(*pulse_value)) {
-            ESP_LOGW(SLEEP_TAG, "RTC pulse counter NaN/Inf — resetting to 0");
-            *pulse_value = 0.0f;
-            *pulse_count = 0;
-        }
-        ESP_LOGI(SLEEP_TAG, "📂 Loaded from RTC: %.2f value, %lu pulses", *pulse_value, *pulse_count);
-        return true;
-    }
-    
-    // Otherwise, try to load from NVS
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("pulse_storage", NVS_READONLY, &nvs_handle);
-    if (ret == ESP_OK) {
-        size_t size = sizeof(float);
-        ret = nvs_get_blob(nvs_handle, "pulse_val", pulse_value, &size);
-        if (ret == ESP_OK) {
-            nvs_get_u32(nvs_handle, "pulse_cnt", pulse_count);
-            nvs_close(nvs_handle);
-            ESP_LOGI(SLEEP_TAG, "📂 Loaded from NVS: %.2f value, %lu pulses", *pulse_value, *pulse_count);
-            
-            // Update RTC memory
-            rtc_pulse_counter_value = *pulse_value;
-            rtc_pulse_counter_count = *pulse_count;
-            return false;
-        }
-        nvs_close(nvs_handle);
-    }
-    
-    // No stored data, start fresh
-    *pulse_value = 0.0f;
-    *pulse_count = 0;
-    return false;
-}
+/* Rain gauge and pulse counter totals are persisted by counter_channel.c */
 
 /* NOTE: Manual enter_light_sleep() function removed.
  * 
@@ -322,8 +173,6 @@ void print_wake_statistics(void)
     ESP_LOGI(SLEEP_TAG, "📊 WAKE-UP STATISTICS");
     ESP_LOGI(SLEEP_TAG, "========================================");
     ESP_LOGI(SLEEP_TAG, "Boot count: %lu", boot_count);
-    ESP_LOGI(SLEEP_TAG, "Rainfall (RTC): %.2f mm", rtc_rainfall_mm);
-    ESP_LOGI(SLEEP_TAG, "Pulse count (RTC): %lu", rtc_rain_pulse_count);
     
     /* Calculate uptime percentage */
     /* Awake ~3 sec every 15 min = 3/900 = 0.33% duty cycle */
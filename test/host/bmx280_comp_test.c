@@ -0,0 +1,136 @@
+/*
+ * BMx280 Compensation Host Test
+ *
+ * Design:
+ * - main/bmx280_comp.c is built twice (CMakeLists.txt): once per BMX280_COMP_USE_FLOAT
+ *   value, with the public symbols renamed *_int / *_float, so both paths run side by side
+ * - Temperature and pressure are checked against the BMP280 datasheet example
+ *   (section 3.12: adc_T 519888, adc_P 415148 -> T 2508 = 25.08 °C, P 100653.25 Pa);
+ *   the integer path must hit them to the LSB, the float path within rounding
+ * - Humidity has no datasheet vector: the two paths are checked against each other
+ * - Each path is timed over BENCH_ITERATIONS calls (host figures: relative cost only)
+ */
+
+#include "bmx280_comp.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+void bmx280_comp_parse_calib_int(bmx280_calib_t *cal, const uint8_t *raw, bool has_humidity);
+esp_err_t bmx280_compensate_int(const bmx280_calib_t *cal, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                                bmx280_comp_t *out);
+esp_err_t bmx280_compensate_float(const bmx280_calib_t *cal, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                                  bmx280_comp_t *out);
+
+#define BENCH_ITERATIONS 1000000
+
+/* BMP280 datasheet 3.12 example */
+#define DS_ADC_T            519888
+#define DS_ADC_P            415148
+#define DS_T_CENTI          2508
+#define DS_P_PA             100653.25
+#define INT_P_TOL_PA        0.01        // A few Q24.8 LSBs
+#define FLOAT_P_TOL_PA      1.0
+
+/* Typical BME280 humidity trim (only used for the int/float agreement check) */
+#define HUM_ADC_H           30000
+
+static int s_failures;
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if (!(cond)) {                          \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                \
+            printf("\n");                       \
+            s_failures++;                       \
+        }                                       \
+    } while (0)
+
+static void put16(uint8_t *raw, size_t off, int32_t v)
+{
+    raw[off] = (uint8_t)(v & 0xFF);
+    raw[off + 1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+/* Raw 0x88-0xA1 + 0xE1-0xE7 block holding the datasheet T/P trim and a typical H trim */
+static void datasheet_calib(bmx280_calib_t *cal)
+{
+    static const int32_t tp[12] = { 27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 };
+    const int32_t h4 = 313, h5 = 50;
+    uint8_t raw[BMX280_CALIB_LEN] = { 0 };
+    for (size_t i = 0; i < 12; i++) {
+        put16(raw, i * 2, tp[i]);
+    }
+    raw[25] = 75;                                       // H1
+    put16(raw, 26, 362);                                // H2
+    raw[28] = 0;                                        // H3
+    raw[29] = (uint8_t)(h4 >> 4);                       // H4 [11:4]
+    raw[30] = (uint8_t)((h4 & 0x0F) | ((h5 & 0x0F) << 4));
+    raw[31] = (uint8_t)(h5 >> 4);                       // H5 [11:4]
+    raw[32] = 30;                                       // H6
+    bmx280_comp_parse_calib_int(cal, raw, true);
+}
+
+static double bench_ns(esp_err_t (*fn)(const bmx280_calib_t *, int32_t, int32_t, int32_t, bmx280_comp_t *),
+                       const bmx280_calib_t *cal)
+{
+    struct timespec t0, t1;
+    volatile uint32_t sink = 0;
+    bmx280_comp_t out;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(cal, DS_ADC_T + (i & 0xFF), DS_ADC_P + (i & 0xFF), HUM_ADC_H + (i & 0xFF), &out);
+        sink += out.pressure_q8;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_ITERATIONS;
+}
+
+int main(void)
+{
+    bmx280_calib_t cal;
+    datasheet_calib(&cal);
+    CHECK(cal.T1 == 27504 && cal.T3 == -1000 && cal.P9 == 6000, "T/P trim decoded wrongly");
+    CHECK(cal.H1 == 75 && cal.H2 == 362 && cal.H4 == 313 && cal.H5 == 50 && cal.H6 == 30, "H trim decoded wrongly");
+
+    bmx280_comp_t ci, cf;
+    CHECK(bmx280_compensate_int(&cal, DS_ADC_T, DS_ADC_P, HUM_ADC_H, &ci) == ESP_OK, "integer path failed");
+    CHECK(bmx280_compensate_float(&cal, DS_ADC_T, DS_ADC_P, HUM_ADC_H, &cf) == ESP_OK, "float path failed");
+
+    /* Integer path: datasheet results to the LSB */
+    double pi = ci.pressure_q8 / 256.0, pf = cf.pressure_q8 / 256.0;
+    CHECK(ci.temperature_centi == DS_T_CENTI, "int T %ld, expected %d", (long)ci.temperature_centi, DS_T_CENTI);
+    CHECK(fabs(pi - DS_P_PA) <= INT_P_TOL_PA, "int P %.4f Pa, expected %.2f", pi, DS_P_PA);
+
+    /* Float path: within single-precision rounding of the datasheet values */
+    CHECK(abs(cf.temperature_centi - DS_T_CENTI) <= 1, "float T %ld, expected %d +-1", (long)cf.temperature_centi,
+          DS_T_CENTI);
+    CHECK(fabs(pf - DS_P_PA) <= FLOAT_P_TOL_PA, "float P %.2f Pa, expected %.2f +-%.0f", pf, DS_P_PA, FLOAT_P_TOL_PA);
+
+    /* Humidity: both paths agree within 0.1 %RH */
+    double hi = ci.humidity_q10 / 1024.0, hf = cf.humidity_q10 / 1024.0;
+    CHECK(hi > 0.0 && hi < 100.0, "int H %.3f %%RH out of range", hi);
+    CHECK(fabs(hi - hf) <= 0.1, "H int %.3f vs float %.3f %%RH", hi, hf);
+
+    printf("int   : T %.2f C, P %.2f Pa, H %.3f %%RH\n", ci.temperature_centi / 100.0, pi, hi);
+    printf("float : T %.2f C, P %.2f Pa, H %.3f %%RH\n", cf.temperature_centi / 100.0, pf, hf);
+
+    /* Invalid calibration is reported, not divided by */
+    bmx280_calib_t zero = cal;
+    zero.P1 = 0;
+    CHECK(bmx280_compensate_int(&zero, DS_ADC_T, DS_ADC_P, 0, &ci) == ESP_ERR_INVALID_STATE, "int P1=0 accepted");
+    CHECK(bmx280_compensate_float(&zero, DS_ADC_T, DS_ADC_P, 0, &cf) == ESP_ERR_INVALID_STATE, "float P1=0 accepted");
+
+    printf("bench : int %.1f ns/call, float %.1f ns/call (host, %d calls)\n", bench_ns(bmx280_compensate_int, &cal),
+           bench_ns(bmx280_compensate_float, &cal), BENCH_ITERATIONS);
+
+    if (s_failures) {
+        printf("%d check(s) failed\n", s_failures);
+        return EXIT_FAILURE;
+    }
+    printf("All checks passed\n");
+    return EXIT_SUCCESS;
+}